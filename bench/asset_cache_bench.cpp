@@ -0,0 +1,149 @@
+#include "assets/asset_cache.hpp"
+#include "assets/async_io.hpp"
+#include "core/job_system.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Stress run for the asset cache: threads load and release overlapping paths, mostly
+// without waiting for the load to finish, so releases race loads completing, loads revive
+// assets off the LRU list, and a small budget keeps evicting. Afterwards the cache's
+// books must balance: every decoded asset is either resident or destroyed, no more are
+// unreferenced than resident, and evict_unreferenced() empties it. Exits non-zero if not.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::atomic<int64_t> liveAssets{0};
+
+struct Blob {
+    std::vector<uint8_t> bytes;
+    Blob() { liveAssets.fetch_add(1, std::memory_order_relaxed); }
+    ~Blob() { liveAssets.fetch_sub(1, std::memory_order_relaxed); }
+};
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        printf("FAILED: %s\n", what);
+    }
+    return condition;
+}
+}
+
+int main(int argc, char** argv) {
+    uint32_t threadCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 4;
+    uint32_t iterations = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 20000;
+    const uint32_t pathCount = 256;
+    const size_t budget = 64 * 1024;
+
+    char directory[] = "/tmp/asset_cache_benchXXXXXX";
+    if (!mkdtemp(directory)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < pathCount; i++) {
+        paths.push_back(std::string(directory) + "/asset" + std::to_string(i));
+        FILE* file = fopen(paths.back().c_str(), "wb");
+        std::vector<uint8_t> contents(512 + (i * 97) % 4096, static_cast<uint8_t>(i));
+        fwrite(contents.data(), 1, contents.size(), file);
+        fclose(file);
+    }
+
+    JobSystem jobs;
+    AsyncIOConfig config;
+    config.bufferCount = 0;
+    AsyncIO io(jobs, config);
+    bool ok = true;
+    {
+        AssetCache cache(jobs, io);
+        cache.register_type<Blob>(AssetBudget{budget, SIZE_MAX},
+                                  [](const uint8_t* bytes, size_t size, AssetUsage& usage) {
+                                      std::unique_ptr<Blob> blob = std::make_unique<Blob>();
+                                      blob->bytes.assign(bytes, bytes + size);
+                                      usage.cpuBytes = size;
+                                      return blob;
+                                  });
+
+        Clock::time_point start = Clock::now();
+        std::atomic<uint64_t> mismatches{0};
+        std::atomic<uint32_t> finished{0};
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t + 1);
+                std::vector<AssetHandle<Blob>> held;
+                for (uint32_t i = 0; i < iterations; i++) {
+                    uint32_t path = rng() % pathCount;
+                    AssetHandle<Blob> handle = cache.load<Blob>(paths[path]);
+                    if (rng() % 8 == 0) {
+                        while (cache.get_state(handle) == AssetState::Loading) {
+                            std::this_thread::yield();
+                        }
+                        const Blob* blob = cache.get(handle);
+                        if (!blob || blob->bytes.empty() || blob->bytes[0] != static_cast<uint8_t>(path)) {
+                            mismatches.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    if (rng() % 4 == 0) {
+                        held.push_back(handle); // Released a little later, out of order
+                    } else {
+                        cache.release(handle);
+                    }
+                    if (held.size() > 8) {
+                        size_t victim = rng() % held.size();
+                        cache.release(held[victim]);
+                        held.erase(held.begin() + static_cast<std::ptrdiff_t>(victim));
+                    }
+                    if (t == 0 && i % 1000 == 999) {
+                        cache.evict_unreferenced();
+                    }
+                }
+                for (AssetHandle<Blob> handle : held) {
+                    cache.release(handle);
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+        // This thread is worker 0 of the pool and runs completions, possibly the only one
+        while (finished.load(std::memory_order_acquire) < threadCount) {
+            io.wait_idle();
+            std::this_thread::yield();
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        io.wait_idle();
+        double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        AssetCache::TypeStats stats = cache.get_stats<Blob>();
+        printf("%u threads x %u load/release in %.1f ms: %llu loads, %llu shared, %llu evictions, %u resident, "
+               "%zu KB of %zu KB\n",
+               threadCount, iterations, elapsed, static_cast<unsigned long long>(stats.loads),
+               static_cast<unsigned long long>(stats.sharedLoads), static_cast<unsigned long long>(stats.evictions),
+               stats.resident, stats.usage.cpuBytes / 1024, budget / 1024);
+
+        ok &= check(mismatches.load() == 0, "get() returned a missing or wrong asset while referenced");
+        ok &= check(stats.unreferenced <= stats.resident, "more unreferenced assets than resident ones");
+        ok &= check(stats.unreferenced == stats.resident, "a fully released asset is not on the LRU list");
+        ok &= check(stats.usage.cpuBytes <= budget, "usage above budget with nothing referenced");
+        ok &= check(liveAssets.load() == static_cast<int64_t>(stats.resident), "decoded assets leaked");
+        cache.evict_unreferenced();
+        stats = cache.get_stats<Blob>();
+        ok &= check(stats.resident == 0 && stats.unreferenced == 0 && stats.usage.cpuBytes == 0,
+                    "evict_unreferenced() left assets behind");
+        ok &= check(liveAssets.load() == 0, "evicted assets were not destroyed");
+    }
+
+    for (const std::string& path : paths) {
+        unlink(path.c_str());
+    }
+    rmdir(directory);
+    return ok ? 0 : 1;
+}
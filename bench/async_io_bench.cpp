@@ -0,0 +1,84 @@
+#include "assets/async_io.hpp"
+#include "core/job_system.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Writes a directory of small files and reads all of them back, through io_uring and
+// through the pread fallback. Each pass first asks the kernel to drop the files from the
+// page cache, so the reads go to the disk where it allows it.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double milliseconds_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void drop_from_cache(const std::vector<std::string>& paths) {
+    for (const std::string& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    uint32_t fileCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 4000;
+    char directory[] = "/tmp/async_io_benchXXXXXX";
+    if (!mkdtemp(directory)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // 1-32 KB, roughly the spread of small textures, meshes and configs
+    std::vector<std::string> paths;
+    std::vector<char> contents(32 * 1024, 'a');
+    for (uint32_t i = 0; i < fileCount; i++) {
+        paths.push_back(std::string(directory) + "/asset" + std::to_string(i));
+        FILE* file = fopen(paths.back().c_str(), "wb");
+        fwrite(contents.data(), 1, 1024 + (i * 7919) % (31 * 1024), file);
+        fclose(file);
+    }
+
+    JobSystem jobs;
+    for (bool fallback : {false, true}) {
+        AsyncIOConfig config;
+        config.forceFallback = fallback;
+        AsyncIO io(jobs, config);
+        drop_from_cache(paths);
+
+        std::atomic<uint64_t> failed{0};
+        Clock::time_point start = Clock::now();
+        for (const std::string& path : paths) {
+            io.read_file(path, [&failed](AsyncIO::Result& result) {
+                if (result.error != 0) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        io.wait_idle();
+        double elapsed = milliseconds_since(start);
+
+        AsyncIO::Stats stats = io.get_stats();
+        printf("%-8s %u files in %.2f ms, %.1f MB/s, %llu syscalls, %llu failed\n",
+               io.uses_io_uring() ? "io_uring" : "pread", fileCount, elapsed,
+               static_cast<double>(stats.bytes) / (elapsed * 1000.0), static_cast<unsigned long long>(stats.submitCalls),
+               static_cast<unsigned long long>(failed.load()));
+    }
+
+    for (const std::string& path : paths) {
+        unlink(path.c_str());
+    }
+    rmdir(directory);
+    return 0;
+}
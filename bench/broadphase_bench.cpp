@@ -0,0 +1,88 @@
+#include "core/job_system.hpp"
+#include "physics/broadphase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Moves bodies through a box at fixed steps, bouncing off its walls, and times the
+// broadphase update each step, serially and on the job system.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double milliseconds_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Body {
+    float position[3];
+    float velocity[3];
+    float halfExtent;
+    uint32_t handle;
+};
+
+Aabb bounds_of(const Body& body) {
+    Aabb bounds;
+    for (int axis = 0; axis < 3; axis++) {
+        bounds.min[axis] = body.position[axis] - body.halfExtent;
+        bounds.max[axis] = body.position[axis] + body.halfExtent;
+    }
+    return bounds;
+}
+}
+
+int main(int argc, char** argv) {
+    uint32_t bodyCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 50000;
+    const int steps = 120;
+    const float dt = 1.0f / 60.0f;
+    // Sized so an average body touches a few others
+    const float worldSize = 4.0f * std::cbrt(static_cast<float>(bodyCount));
+
+    JobSystem jobs;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> velocity(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> size(0.5f, 1.5f);
+
+    for (JobSystem* pool : {static_cast<JobSystem*>(nullptr), &jobs}) {
+        Broadphase broadphase;
+        std::vector<Body> bodies(bodyCount);
+        for (Body& body : bodies) {
+            for (int axis = 0; axis < 3; axis++) {
+                body.position[axis] = position(rng);
+                body.velocity[axis] = velocity(rng);
+            }
+            body.halfExtent = size(rng);
+            body.handle = broadphase.add(bounds_of(body), 0);
+        }
+
+        double totalMs = 0.0;
+        uint64_t totalPairs = 0, totalCandidates = 0, totalChanges = 0;
+        for (int step = 0; step < steps; step++) {
+            for (Body& body : bodies) {
+                for (int axis = 0; axis < 3; axis++) {
+                    body.position[axis] += body.velocity[axis] * dt;
+                    if (body.position[axis] < 0.0f || body.position[axis] > worldSize) {
+                        body.velocity[axis] = -body.velocity[axis];
+                    }
+                }
+                broadphase.update(body.handle, bounds_of(body));
+            }
+            Clock::time_point start = Clock::now();
+            broadphase.update_pairs(pool);
+            totalMs += milliseconds_since(start);
+            totalPairs += broadphase.get_pairs().size();
+            totalCandidates += broadphase.get_candidate_count();
+            totalChanges += broadphase.get_added_pairs().size() + broadphase.get_removed_pairs().size();
+        }
+        printf("%u bodies, %u workers: %.3f ms/step, %.0f pairs/step (%.0f began or ended), %.1f M pairs/s, "
+               "%.1f M candidate tests/s\n",
+               bodyCount, pool ? pool->get_worker_count() : 1, totalMs / steps, static_cast<double>(totalPairs) / steps,
+               static_cast<double>(totalChanges) / steps, static_cast<double>(totalPairs) / totalMs * 1e-3,
+               static_cast<double>(totalCandidates) / totalMs * 1e-3);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "core/job_system.hpp"
+#include "scene/bvh.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Scatters objects over a wide, flat world and times frustum culling and raycasts on the
+// greedily built tree, after a stretch of moves has let it drift, and after a SAH rebuild.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double milliseconds_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Aabb box_around(const float center[3], float halfExtent) {
+    Aabb bounds;
+    for (int axis = 0; axis < 3; axis++) {
+        bounds.min[axis] = center[axis] - halfExtent;
+        bounds.max[axis] = center[axis] + halfExtent;
+    }
+    return bounds;
+}
+
+// Column-major perspective at the origin looking down -z, Vulkan depth range
+Frustum camera_frustum(float farPlane) {
+    const float nearPlane = 0.1f;
+    const float focal = 1.0f / std::tan(0.5236f); // 60 degree vertical field of view
+    float projection[16] = {focal, 0, 0, 0, 0, focal, 0, 0, 0, 0, farPlane / (nearPlane - farPlane), -1,
+                            0,     0, nearPlane * farPlane / (nearPlane - farPlane), 0};
+    return Frustum::from_view_projection(projection);
+}
+
+struct Object {
+    float center[3];
+    float halfExtent;
+    uint32_t proxy;
+};
+
+// Best of several runs, since a single cull is short enough for noise to dominate
+void time_queries(const char* label, const DynamicBvh& bvh, const Frustum& frustum, const std::vector<Ray>& rays) {
+    const int runs = 20;
+    std::vector<uint32_t> visible;
+    visible.reserve(bvh.get_proxy_count());
+    double cullMs = 1e9;
+    for (int run = 0; run < runs; run++) {
+        visible.clear();
+        Clock::time_point start = Clock::now();
+        bvh.query_frustum(frustum, visible);
+        cullMs = std::min(cullMs, milliseconds_since(start));
+    }
+    std::vector<RayHit> hits(rays.size());
+    double rayMs = 1e9;
+    for (int run = 0; run < runs; run++) {
+        Clock::time_point start = Clock::now();
+        bvh.raycast(rays.data(), rays.size(), hits.data());
+        rayMs = std::min(rayMs, milliseconds_since(start));
+    }
+    size_t rayHits = std::count_if(hits.begin(), hits.end(), [](const RayHit& hit) { return hit.userData != UINT32_MAX; });
+    printf("%-8s SAH cost %6.1f: cull %.3f ms (%zu visible), %zu rays %.3f ms (%.1f M rays/s, %zu hit)\n", label,
+           bvh.get_sah_cost(), cullMs, visible.size(), rays.size(), rayMs, static_cast<double>(rays.size()) / rayMs * 1e-3,
+           rayHits);
+}
+}
+
+int main(int argc, char** argv) {
+    uint32_t objectCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+    const uint32_t rayCount = 10000;
+    const int moveSteps = 60;
+    const float worldSize = 1000.0f;
+
+    JobSystem jobs;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coordinate(-worldSize, worldSize);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+    std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    DynamicBvh bvh(0.2f);
+    std::vector<Object> objects(objectCount);
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < objectCount; i++) {
+        Object& object = objects[i];
+        object.center[0] = coordinate(rng);
+        object.center[1] = coordinate(rng) * 0.05f; // Mostly flat, like a level
+        object.center[2] = coordinate(rng);
+        object.halfExtent = size(rng);
+        object.proxy = bvh.insert(box_around(object.center, object.halfExtent), i);
+    }
+    printf("%u objects inserted in %.2f ms, %zu nodes\n", objectCount, milliseconds_since(start), bvh.get_node_count());
+
+    Frustum frustum = camera_frustum(600.0f);
+    std::vector<Ray> rays(rayCount);
+    for (Ray& ray : rays) {
+        ray.origin[0] = coordinate(rng);
+        ray.origin[1] = 50.0f;
+        ray.origin[2] = coordinate(rng);
+        ray.direction[0] = unit(rng) * 0.5f;
+        ray.direction[1] = -1.0f;
+        ray.direction[2] = unit(rng) * 0.5f;
+        ray.maxDistance = 200.0f;
+    }
+    time_queries("greedy", bvh, frustum, rays);
+
+    // A quarter of the objects wander each step, mostly farther than the fat margin
+    uint64_t moves = 0, refits = 0;
+    start = Clock::now();
+    for (int step = 0; step < moveSteps; step++) {
+        for (uint32_t i = step % 4; i < objectCount; i += 4) {
+            Object& object = objects[i];
+            for (int axis = 0; axis < 3; axis++) {
+                object.center[axis] += velocity(rng) * (axis == 1 ? 0.05f : 1.0f);
+            }
+            refits += bvh.move(object.proxy, box_around(object.center, object.halfExtent)) ? 1 : 0;
+            moves++;
+        }
+    }
+    double moveMs = milliseconds_since(start);
+    printf("%llu moves in %.2f ms (%.1f M moves/s), %.1f%% refit\n", static_cast<unsigned long long>(moves), moveMs,
+           static_cast<double>(moves) / moveMs * 1e-3, 100.0 * static_cast<double>(refits) / static_cast<double>(moves));
+    time_queries("drifted", bvh, frustum, rays);
+
+    start = Clock::now();
+    bvh.rebuild();
+    printf("SAH rebuild in %.2f ms, %zu nodes\n", milliseconds_since(start), bvh.get_node_count());
+    time_queries("rebuilt", bvh, frustum, rays);
+
+    start = Clock::now();
+    bvh.begin_rebuild(jobs);
+    bool swapped = bvh.finish_rebuild();
+    printf("Asynchronous rebuild on %u workers in %.2f ms (%s)\n", jobs.get_worker_count(), milliseconds_since(start),
+           swapped ? "swapped in" : "dropped");
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "core/job_system.hpp"
+#include "scene/ecs.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Iterates a million entities spread over several archetypes, serially and on the job
+// system, and times the structural paths: bulk creation and command-buffer destruction.
+
+namespace {
+struct Position {
+    float x, y, z;
+};
+struct Velocity {
+    float x, y, z;
+};
+struct Mass {
+    float value;
+};
+struct Health {
+    int32_t value;
+};
+struct Frozen {
+    uint8_t unused;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Fn>
+double best_of(int runs, Fn&& fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        Clock::time_point start = Clock::now();
+        fn();
+        best = std::min(best, milliseconds_since(start));
+    }
+    return best;
+}
+}
+
+int main(int argc, char** argv) {
+    uint32_t entityCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+    const int runs = 10;
+    const float dt = 1.0f / 60.0f;
+
+    JobSystem jobs;
+    World world;
+
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < entityCount; i++) {
+        Position position{static_cast<float>(i), 0.0f, 0.0f};
+        Velocity velocity{1.0f, 2.0f, 3.0f};
+        // Four archetypes, so queries span several chunk lists
+        switch (i & 3) {
+        case 0: world.create(position, velocity, Mass{1.0f}); break;
+        case 1: world.create(position, velocity, Mass{2.0f}, Health{100}); break;
+        case 2: world.create(position, velocity, Health{50}); break;
+        default: world.create(position, velocity, Mass{3.0f}, Frozen{}); break;
+        }
+    }
+    printf("create:        %8.2f ms for %u entities, %zu archetypes\n", milliseconds_since(start), entityCount,
+           world.get_archetype_count());
+
+    EntityQuery& moving = world.query<Position, Velocity>();
+    EntityQuery& massive = world.query<Position, Velocity, Mass>();
+    printf("query sizes:   %zu moving, %zu with mass\n", moving.count(), massive.count());
+
+    double serial = best_of(runs, [&]() {
+        moving.each<Position, Velocity>([dt](Position& p, const Velocity& v) {
+            p.x += v.x * dt;
+            p.y += v.y * dt;
+            p.z += v.z * dt;
+        });
+    });
+    printf("each (2 comp): %8.2f ms serial\n", serial);
+
+    double parallel = best_of(runs, [&]() {
+        moving.par_each<Position, Velocity>(jobs, [dt](Position& p, const Velocity& v) {
+            p.x += v.x * dt;
+            p.y += v.y * dt;
+            p.z += v.z * dt;
+        });
+    });
+    printf("each (2 comp): %8.2f ms on %u workers\n", parallel, jobs.get_worker_count());
+
+    double chunked = best_of(runs, [&]() {
+        massive.par_each_chunk(jobs, [dt](ChunkView& view) {
+            Position* p = view.get<Position>();
+            Velocity* v = view.get<Velocity>();
+            Mass* m = view.get<Mass>();
+            for (uint32_t i = 0; i < view.count(); i++) {
+                float drag = dt / m[i].value;
+                v[i].x -= v[i].x * drag;
+                v[i].y -= v[i].y * drag;
+                v[i].z -= v[i].z * drag;
+                p[i].x += v[i].x * dt;
+                p[i].y += v[i].y * dt;
+                p[i].z += v[i].z * dt;
+            }
+        });
+    });
+    printf("chunks (3 comp): %6.2f ms on %u workers\n", chunked, jobs.get_worker_count());
+
+    EntityCommandBuffer commands;
+    start = Clock::now();
+    world.query<Health>().par_each_chunk(jobs, [&commands](ChunkView& view) {
+        const Entity* entities = view.entities();
+        const Health* health = view.get<Health>();
+        for (uint32_t i = 0; i < view.count(); i++) {
+            if (health[i].value < 75) {
+                commands.destroy(entities[i]);
+            }
+        }
+    });
+    world.apply(commands);
+    printf("destroy:       %8.2f ms via command buffer, %zu entities left\n", milliseconds_since(start),
+           world.get_entity_count());
+    return 0;
+}
@@ -0,0 +1,36 @@
+# Writes the SPIR-V modules listed in SHADERS (comma-separated) into OUTPUT as constexpr
+# word arrays, plus the EMBEDDED_SHADERS lookup table declared in
+# include/platform/embedded_shaders.hpp. Run with cmake -P.
+
+string(REPLACE "," ";" SHADER_LIST "${SHADERS}")
+
+set(ARRAYS "")
+set(ENTRIES "")
+foreach(SPV ${SHADER_LIST})
+    get_filename_component(FILE_NAME ${SPV} NAME)
+    string(REGEX REPLACE "\\.spv$" "" SHADER_NAME "${FILE_NAME}")
+    string(MAKE_C_IDENTIFIER "spirv_${SHADER_NAME}" IDENTIFIER)
+
+    # SPIR-V is a little-endian word stream; reassemble each word from its four bytes
+    file(READ ${SPV} HEX HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])"
+           "0x\\4\\3\\2\\1u, " WORDS "${HEX}")
+    string(REGEX REPLACE "((0x[0-9a-f]+u, ){8})" "\\1\n    " WORDS "${WORDS}")
+
+    string(APPEND ARRAYS "constexpr uint32_t ${IDENTIFIER}[] = {\n    ${WORDS}\n};\n\n")
+    string(APPEND ENTRIES "    {\"${SHADER_NAME}\", ${IDENTIFIER}, sizeof(${IDENTIFIER}) / sizeof(uint32_t)},\n")
+endforeach()
+
+list(LENGTH SHADER_LIST SHADER_COUNT)
+file(WRITE ${OUTPUT}
+"// Generated by cmake/embed_shaders.cmake; do not edit.
+#include \"platform/embedded_shaders.hpp\"
+
+namespace {
+${ARRAYS}}
+
+const EmbeddedShader EMBEDDED_SHADERS[] = {
+${ENTRIES}};
+
+const size_t EMBEDDED_SHADER_COUNT = ${SHADER_COUNT};
+")
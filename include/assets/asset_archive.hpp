@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class AssetCompression : uint8_t {
+    None = 0,
+    Lz4 = 1,
+    Zstd = 2,
+};
+
+// On-disk layout, little-endian: the header, a fanout table counting entries by the top
+// byte of their hash, the index sorted by hash, the NUL-terminated paths, then the blobs,
+// each starting on an `alignment` boundary.
+struct ArchiveHeader {
+    char magic[4]; // "APAK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t alignment;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;
+    uint32_t reserved[4];
+};
+static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader is part of the file format");
+
+struct ArchiveEntry {
+    uint64_t hash;   // AssetArchive::hash_path() of the path
+    uint64_t offset; // Of the stored bytes, from the start of the file
+    uint64_t storedSize;
+    uint64_t size;   // Once decompressed
+    uint32_t nameOffset; // Into the paths block
+    uint32_t checksum;   // CRC-32 of the stored bytes
+    uint8_t compression; // AssetCompression
+    uint8_t reserved[7];
+};
+static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry is part of the file format");
+
+// Read-only view of a packed archive built by tools/asset_packer. Opening maps the file
+// and checks the header; nothing is read or scanned up front, and lookups go through the
+// fanout table to a short binary search. Uncompressed assets are used in place straight
+// from the mapping; compressed ones are decoded into caller memory by extract().
+class AssetArchive {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FANOUT_SIZE = 256;
+
+    explicit AssetArchive(const std::string& path);
+    ~AssetArchive();
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    // Paths are relative to the packed directory, with '/' separators; nullptr when absent
+    const ArchiveEntry* find(std::string_view path) const;
+    const ArchiveEntry* get_entries() const { return entries; }
+    size_t get_entry_count() const { return header->entryCount; }
+    const char* get_name(const ArchiveEntry& entry) const { return names + entry.nameOffset; }
+
+    // The asset's bytes inside the mapping, or nullptr when it is stored compressed
+    const uint8_t* get_in_place(const ArchiveEntry& entry) const;
+    const uint8_t* get_stored(const ArchiveEntry& entry) const { return base + entry.offset; }
+    // Writes entry.size bytes to `destination`, decompressing when needed
+    void extract(const ArchiveEntry& entry, void* destination) const;
+    bool verify(const ArchiveEntry& entry) const; // Checks the stored bytes' checksum
+
+    // Open descriptor, e.g. for AsyncIO reads that should not fault pages on the caller
+    int get_fd() const { return fd; }
+    size_t get_size() const { return size; }
+
+    static uint64_t hash_path(std::string_view path);
+    static uint32_t checksum(const void* data, size_t size);
+    static bool supports(AssetCompression compression); // Whether this build links the codec
+    // Empty when the codec is unavailable or fails
+    static std::vector<uint8_t> compress(AssetCompression compression, const void* data, size_t size);
+
+private:
+    int fd = -1;
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    const ArchiveHeader* header = nullptr;
+    const uint32_t* fanout = nullptr;
+    const ArchiveEntry* entries = nullptr;
+    const char* names = nullptr;
+};
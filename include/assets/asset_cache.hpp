@@ -0,0 +1,215 @@
+#pragma once
+
+#include "assets/asset_archive.hpp"
+#include "assets/async_io.hpp"
+#include "core/job_system.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using AssetTypeId = uint32_t;
+
+// Index plus generation, like Entity, so handles can sit in ECS components. Eviction
+// bumps the generation, which turns handles to the old asset stale instead of aliasing
+// whatever loads into the slot next.
+template <typename T>
+struct AssetHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool is_null() const { return index == UINT32_MAX; }
+    bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const AssetHandle& other) const { return !(*this == other); }
+};
+
+struct AssetUsage {
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0; // Reported by the decoder; the cache only does the accounting
+};
+
+struct AssetBudget {
+    size_t cpuBytes = SIZE_MAX;
+    size_t gpuBytes = SIZE_MAX;
+};
+
+enum class AssetState : uint8_t {
+    Loading,
+    Ready,
+    Failed,
+};
+
+// Loaded assets by path, one budget per asset type. load() hands out a handle holding one
+// reference; loading a path that is already resident or in flight shares it. Assets whose
+// references all go away stay resident on a per-type LRU list and are evicted from its
+// cold end whenever the type is over its CPU or GPU budget, so memory stays flat however
+// long the session runs. Bytes come from the asset archive when it has the path, used in
+// place where they are stored uncompressed, and from AsyncIO otherwise; decoding runs on
+// the job system.
+class AssetCache {
+public:
+    template <typename T>
+    using Decoder = std::function<std::unique_ptr<T>(const uint8_t* bytes, size_t size, AssetUsage& usage)>;
+
+    struct TypeStats {
+        AssetUsage usage;
+        AssetBudget budget;
+        uint32_t resident = 0;
+        uint32_t unreferenced = 0; // Resident and evictable
+        uint64_t loads = 0;
+        uint64_t sharedLoads = 0;  // load() calls that found the path resident or in flight
+        uint64_t evictions = 0;
+        uint64_t failures = 0;
+    };
+
+    AssetCache(JobSystem& jobs, AsyncIO& io, const AssetArchive* archive = nullptr);
+    ~AssetCache(); // Waits for loads in flight
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    template <typename T>
+    void register_type(const AssetBudget& budget, Decoder<T> decoder) {
+        register_type_erased(type_id<T>(), budget,
+                             [decoder = std::move(decoder)](const uint8_t* bytes, size_t size, AssetUsage& usage) {
+                                 return static_cast<void*>(decoder(bytes, size, usage).release());
+                             },
+                             [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    template <typename T>
+    void set_budget(const AssetBudget& budget) {
+        set_budget(type_id<T>(), budget);
+    }
+
+    template <typename T>
+    AssetHandle<T> load(const std::string& path) {
+        AssetHandle<T> handle;
+        acquire(type_id<T>(), path, handle.index, handle.generation);
+        return handle;
+    }
+
+    // nullptr while loading, after a failed load, or for a stale handle. The asset stays
+    // put for as long as the caller holds a reference.
+    template <typename T>
+    const T* get(AssetHandle<T> handle) const {
+        const Slot* slot = find_slot(handle.index, handle.generation);
+        return slot ? static_cast<const T*>(slot->object.load(std::memory_order_acquire)) : nullptr;
+    }
+
+    template <typename T>
+    AssetState get_state(AssetHandle<T> handle) const {
+        const Slot* slot = find_slot(handle.index, handle.generation);
+        return slot ? slot->state.load(std::memory_order_acquire) : AssetState::Failed;
+    }
+
+    // Adds a reference for a copy of a handle that already holds one
+    template <typename T>
+    void retain(AssetHandle<T> handle) {
+        if (Slot* slot = const_cast<Slot*>(find_slot(handle.index, handle.generation))) {
+            slot->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    void release(AssetHandle<T> handle) {
+        release(handle.index, handle.generation);
+    }
+
+    template <typename T>
+    TypeStats get_stats() const {
+        return get_stats(type_id<T>());
+    }
+
+    // Evicts every unreferenced asset of every type, e.g. between levels
+    void evict_unreferenced();
+
+    template <typename T>
+    static AssetTypeId type_id() {
+        static const AssetTypeId id = next_type_id();
+        return id;
+    }
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint32_t SLOTS_PER_BLOCK = 1024;
+    static constexpr uint32_t MAX_BLOCKS = 1024;
+
+    struct Slot {
+        // Read without the lock by get()
+        std::atomic<uint32_t> generation{0};
+        std::atomic<uint32_t> references{0};
+        std::atomic<AssetState> state{AssetState::Loading};
+        std::atomic<void*> object{nullptr};
+
+        // Guarded by the cache mutex
+        AssetTypeId type = 0;
+        AssetUsage usage;
+        std::string path;
+        bool resident = false;   // Has a path-map entry and counts towards the budget
+        uint32_t lruPrev = NO_SLOT;
+        uint32_t lruNext = NO_SLOT;
+        bool inLru = false;
+    };
+
+    using ErasedDecoder = std::function<void*(const uint8_t*, size_t, AssetUsage&)>;
+
+    struct TypeInfo {
+        bool registered = false;
+        ErasedDecoder decode;
+        void (*destroy)(void*) = nullptr;
+        AssetBudget budget;
+        TypeStats stats;
+        uint32_t lruHead = NO_SLOT; // Least recently released
+        uint32_t lruTail = NO_SLOT;
+    };
+
+    struct Victim {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    static AssetTypeId next_type_id();
+
+    void register_type_erased(AssetTypeId type, const AssetBudget& budget, ErasedDecoder decode,
+                              void (*destroy)(void*));
+    void set_budget(AssetTypeId type, const AssetBudget& budget);
+    void acquire(AssetTypeId type, const std::string& path, uint32_t& index, uint32_t& generation);
+    void release(uint32_t index, uint32_t generation);
+    TypeStats get_stats(AssetTypeId type) const;
+
+    Slot& slot_at(uint32_t index) const {
+        return blocks[index / SLOTS_PER_BLOCK].load(std::memory_order_acquire)[index % SLOTS_PER_BLOCK];
+    }
+    const Slot* find_slot(uint32_t index, uint32_t generation) const;
+    uint32_t allocate_slot();
+    void start_load(uint32_t index, ErasedDecoder decoder, const std::string& path);
+    void decode(uint32_t index, const ErasedDecoder& decoder, const uint8_t* bytes, size_t size);
+    void finish_load(uint32_t index, void* object, const AssetUsage& usage); // nullptr when it failed
+    void lru_link(Slot& slot, uint32_t index);
+    void lru_unlink(Slot& slot);
+    void evict(uint32_t index, std::vector<Victim>& victims);
+    void evict_over_budget(AssetTypeId type, std::vector<Victim>& victims);
+    static void destroy_victims(std::vector<Victim>& victims);
+
+    JobSystem& jobs;
+    AsyncIO& io;
+    const AssetArchive* archive;
+
+    mutable std::mutex mutex;
+    std::vector<TypeInfo> types;
+    std::unordered_map<std::string, uint32_t> slotByPath;
+    std::vector<uint32_t> freeSlots;
+    uint32_t slotCount = 0;
+    // Fixed table of blocks so get() can index slots without the lock while others are added
+    mutable std::array<std::atomic<Slot*>, MAX_BLOCKS> blocks{};
+
+    std::atomic<uint32_t> loadsInFlight{0};
+    JobCounter decodeJobs; // Archive loads; AsyncIO tracks its own
+};
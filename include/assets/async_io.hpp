@@ -0,0 +1,137 @@
+#pragma once
+
+#include "core/job_system.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct IoRequest;
+
+struct AsyncIOConfig {
+    uint32_t queueDepth = 256;
+    uint32_t bufferCount = 16;        // Registered buffers for read_direct()
+    uint32_t bufferSize = 256 * 1024; // Multiple of the 4 KB O_DIRECT alignment
+    uint32_t fallbackThreads = 4;
+    bool forceFallback = false;
+};
+
+// Asynchronous file reads. On io_uring one service thread owns the ring: requests
+// posted from any thread are drained in batches and every open, statx, read and close
+// they need goes in with one io_uring_enter per loop. When io_uring is missing or
+// lacks those ops, a small pool of threads does the same with blocking syscalls.
+// Completions run as jobs on the job system, so decoding starts on a worker as soon as
+// the bytes land, never on the frame thread.
+class AsyncIO {
+public:
+    static constexpr uint32_t NO_BUFFER = UINT32_MAX;
+
+    struct Result {
+        int error = 0;                   // errno value, 0 on success
+        std::string path;                // read_file() only
+        std::unique_ptr<uint8_t[]> data; // read_file() only: the file, owned by whoever takes it
+        uint8_t* bytes = nullptr;        // The requested bytes
+        size_t size = 0;                 // May be short at end of file
+        uint32_t buffer = NO_BUFFER;     // read_direct() only: hand back with release_buffer()
+    };
+    using Completion = std::function<void(Result& result)>;
+
+    AsyncIO(JobSystem& jobs, const AsyncIOConfig& config);
+    ~AsyncIO(); // Waits for outstanding reads; registered buffers must have been released
+
+    AsyncIO(const AsyncIO&) = delete;
+    AsyncIO& operator=(const AsyncIO&) = delete;
+
+    void read_file(const std::string& path, Completion completion);
+    // Into caller memory that must stay valid until the completion runs
+    void read(int fd, uint64_t offset, void* destination, uint32_t size, Completion completion);
+    // Into a registered, page-aligned buffer; suits descriptors opened with O_DIRECT. The
+    // range is widened to 4 KB alignment internally and must fit in one buffer.
+    void read_direct(int fd, uint64_t offset, uint32_t size, Completion completion);
+    void release_buffer(uint32_t buffer);
+
+    // Runs completion jobs on the calling thread until every read has completed
+    void wait_idle();
+
+    struct Stats {
+        uint64_t reads = 0;
+        uint64_t bytes = 0;
+        uint64_t submitCalls = 0; // io_uring_enter calls, or blocking syscalls on the fallback
+    };
+    Stats get_stats() const;
+    bool uses_io_uring() const { return ringFd >= 0 && !ringFailed.load(std::memory_order_relaxed); }
+
+private:
+    bool setup_ring(uint32_t entries);
+    void teardown_ring();
+    void ring_loop();
+    void ring_failed_loop(std::deque<IoRequest*>& incoming, bool wakeArmed);
+    void reap_completions(bool& wakeArmed);
+    void fallback_loop();
+    void post(IoRequest* request);
+    void wake_service();
+    io_uring_sqe* get_sqe();
+    bool prepare(IoRequest* request); // False when the request has to wait for a buffer or SQE
+    void handle_completion(IoRequest* request, int result);
+    void run_blocking(IoRequest* request);
+    uint32_t acquire_buffer(bool wait);
+    void complete(IoRequest* request);
+
+    JobSystem& jobs;
+    AsyncIOConfig config;
+    std::atomic<bool> stopping{false};
+
+    // Requests posted by any thread, drained by the service thread or the fallback pool
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<IoRequest*> queue;
+
+    // Registered buffers
+    std::unique_ptr<uint8_t[], void (*)(void*)> bufferMemory{nullptr, nullptr};
+    std::mutex bufferMutex;
+    std::condition_variable bufferCondition;
+    std::vector<uint32_t> freeBuffers;
+    bool buffersRegistered = false;
+
+    // io_uring state, touched only by the service thread after construction
+    int ringFd = -1;
+    int wakeFd = -1;
+    uint64_t wakeValue = 0;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned sqLocalTail = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    unsigned cqEntries = 0;
+    io_uring_cqe* cqes = nullptr;
+    std::deque<IoRequest*> ready; // Next operation of each request, waiting for an SQE
+    uint32_t opsInFlight = 0;
+    std::atomic<bool> ringFailed{false}; // io_uring_enter failed for good; requests run blocking
+
+    std::vector<std::thread> threads;
+
+    std::atomic<uint64_t> inFlight{0};
+    JobCounter completions;
+    std::atomic<uint64_t> readCount{0};
+    std::atomic<uint64_t> byteCount{0};
+    std::atomic<uint64_t> submitCalls{0};
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bump allocator over a list of blocks. Allocation is a pointer increment; memory is
+// only given back wholesale by reset() or rewind(). Objects placed in an arena never
+// have their destructors run, so keep to trivially destructible data or containers
+// whose memory comes from the arena itself (ArenaVector).
+class LinearArena {
+public:
+    struct Marker {
+        size_t block;
+        size_t offset;
+    };
+
+    explicit LinearArena(size_t blockSize = 1024 * 1024);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    template <typename T>
+    T* allocate_array(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    Marker mark() const { return {current, blocks.empty() ? 0 : blocks[current].offset}; }
+    void rewind(Marker marker);
+    // Frees everything. Overflow blocks are merged into one, so a frame that needed
+    // more than the first block fits in a single block from then on.
+    void reset();
+
+    size_t get_used() const { return used; }
+    size_t get_peak() const { return peak; } // Since the last reset
+    size_t get_capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size;
+        size_t offset;
+    };
+
+    void add_block(size_t minimumSize);
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t blockSize;
+    size_t used = 0; // Bytes handed out, including alignment padding
+    size_t peak = 0;
+};
+
+// Rewinds an arena to where it stood when the scope was opened. Without an arena it
+// uses the calling thread's scratch arena, for temporaries that must not outlive a call.
+class ScratchScope {
+public:
+    ScratchScope();
+    explicit ScratchScope(LinearArena& arena) : arena(arena), marker(arena.mark()) {}
+    ~ScratchScope() { arena.rewind(marker); }
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    LinearArena& get_arena() { return arena; }
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return arena.allocate(size, alignment); }
+
+private:
+    LinearArena& arena;
+    LinearArena::Marker marker;
+};
+
+// STL allocator over a LinearArena; deallocate is a no-op until the arena is reset
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.get_arena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(sizeof(T) * count, alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    LinearArena* get_arena() const { return arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.get_arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.get_arena(); }
+
+private:
+    LinearArena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// One LinearArena per thread for data that lives until the end of a frame: draw lists,
+// culling results, event batches. local() hands each thread, including job workers,
+// its own arena without locking after first use. Separate instances serve separate
+// frame loops, e.g. rendering and simulation, which end their frames independently.
+class FrameArenas {
+public:
+    explicit FrameArenas(size_t blockSize = 1024 * 1024);
+    ~FrameArenas();
+
+    FrameArenas(const FrameArenas&) = delete;
+    FrameArenas& operator=(const FrameArenas&) = delete;
+
+    LinearArena& local();
+
+    // Resets every thread's arena. Call at the frame boundary, once no job still uses
+    // this frame's memory.
+    void end_frame();
+
+    size_t get_last_frame_peak() const { return lastFramePeak; } // Summed over threads
+    size_t get_max_frame_peak() const { return maxFramePeak; }
+    size_t get_thread_count() const;
+
+private:
+    LinearArena& register_thread();
+
+    uint64_t id; // Distinguishes instances in the per-thread lookup, even across reuse of an address
+    size_t blockSize;
+    mutable std::mutex mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<LinearArena>>> arenas;
+    size_t lastFramePeak = 0;
+    size_t maxFramePeak = 0;
+};
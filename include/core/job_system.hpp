@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core/work_stealing_deque.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+// Fixed pool of worker threads, one per core by default, each with its own Chase-Lev
+// deque. Workers pop their own jobs LIFO and steal FIFO from a random victim when they
+// run dry. The thread that creates the pool is worker 0 and runs jobs while it waits;
+// jobs from any other thread enter through a shared queue.
+class JobSystem {
+public:
+    struct WorkerStats {
+        uint64_t executed = 0;
+        uint64_t steals = 0;       // Jobs taken from another worker's deque
+        uint64_t failedSteals = 0; // Victim was empty or lost the race
+        double busySeconds = 0.0;
+        double utilization = 0.0;  // Busy fraction of the time since construction
+    };
+
+    static constexpr uint32_t MAX_WORKERS = 256;
+
+    // `workerCount` 0 picks one per hardware thread, and counts above MAX_WORKERS are
+    // capped. `pinThreads` binds worker i to CPU i.
+    explicit JobSystem(uint32_t workerCount = 0, bool pinThreads = false);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void run(std::function<void()> job, JobCounter* counter = nullptr);
+    // Submits `job` once `dependency` reaches zero, or right away if it already has
+    void run_after(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+    // Runs other jobs until `counter` reaches zero
+    void wait(JobCounter& counter);
+
+    // Calls `body(begin, end)` over subranges of [begin, end) and waits for all of them.
+    // A `grain` of 0 sizes ranges at a few per worker so thieves can balance the load.
+    void parallel_for(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& body,
+                      uint32_t grain = 0);
+
+    uint32_t get_worker_count() const { return static_cast<uint32_t>(workers.size()); }
+    std::vector<WorkerStats> get_stats() const;
+
+private:
+    friend class JobCounter;
+
+    struct Job {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    static constexpr size_t DEQUE_CAPACITY = 4096;
+    static constexpr uint32_t SPINS_BEFORE_SLEEP = 64;
+
+    struct alignas(64) Worker {
+        WorkStealingDeque<Job*, DEQUE_CAPACITY> deque;
+        std::thread thread;
+        uint32_t stealSeed;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> failedSteals{0};
+        std::atomic<uint64_t> busyNs{0};
+    };
+
+    void submit(Job* job);
+    void execute(Job* job, Worker* worker);
+    void finish(JobCounter* counter);
+    bool try_run_one();
+    Job* take_job(int index);
+    void worker_loop(uint32_t index, bool pin);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping{false};
+    uint64_t startNs;
+
+    // Submissions from threads outside the pool
+    std::mutex injectMutex;
+    std::deque<Job*> injected;
+
+    // Sleeping; `queuedJobs` is an upper bound on jobs waiting in any queue
+    std::atomic<int64_t> queuedJobs{0};
+    std::atomic<uint32_t> sleepingWorkers{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
+
+// Counts outstanding jobs. Jobs submitted with a counter increment it and decrement it
+// on completion; wait() and run_after() key off it reaching zero. A counter may be
+// reused once it has been waited on.
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    // Also waits out the last finishing job, so the counter may be destroyed once true
+    bool done() const {
+        return pending.load(std::memory_order_acquire) == 0 && finishing.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending{0};
+    std::atomic<uint32_t> finishing{0}; // Jobs still touching the counter after their decrement
+    std::mutex continuationMutex;
+    std::vector<JobSystem::Job*> continuations; // Submitted when `pending` reaches zero
+};
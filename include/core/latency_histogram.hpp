@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// Fixed-bucket histogram of millisecond latencies: 0.25 ms buckets up to 250 ms, with
+// everything beyond in the last bucket. Recording is O(1) and allocation-free, so it
+// can run from Wayland event handlers every frame.
+class LatencyHistogram {
+public:
+    static constexpr double BUCKET_MS = 0.25;
+    static constexpr size_t BUCKET_COUNT = 1000;
+
+    void record(double milliseconds) {
+        milliseconds = std::max(milliseconds, 0.0);
+        size_t bucket = std::min(static_cast<size_t>(milliseconds / BUCKET_MS), BUCKET_COUNT - 1);
+        buckets[bucket]++;
+        samples++;
+        totalMs += milliseconds;
+        maxMs = std::max(maxMs, milliseconds);
+    }
+
+    // Upper edge of the bucket holding the `fraction` quantile, e.g. 0.99
+    double percentile(double fraction) const {
+        if (samples == 0) {
+            return 0.0;
+        }
+        uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(samples - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if (seen >= target) {
+                return std::min((i + 1) * BUCKET_MS, maxMs);
+            }
+        }
+        return maxMs;
+    }
+
+    uint64_t count() const { return samples; }
+    double mean() const { return samples ? totalMs / static_cast<double>(samples) : 0.0; }
+    double max() const { return maxMs; }
+
+private:
+    std::array<uint32_t, BUCKET_COUNT> buckets{};
+    uint64_t samples = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Fixed-timestep simulation clock. Real elapsed time goes into an accumulator that is
+// drained in whole steps, so the simulation always advances by the same dt whatever the
+// render rate. Time is kept in integer nanoseconds: the same sequence of accumulate()
+// calls always yields the same sequence of steps, which replays and benchmarks rely on.
+class SimulationClock {
+public:
+    static constexpr uint32_t MAX_HZ = 10000;
+
+    // At most `maxStepsPerFrame` steps are owed at once; anything beyond is dropped,
+    // so a slow frame cannot snowball into ever longer catch-up frames. `hz` is clamped
+    // to 1..MAX_HZ, so a step always lasts at least 100 us.
+    explicit SimulationClock(uint32_t hz = 60, uint32_t maxStepsPerFrame = 5)
+        : stepNs(1000000000 / std::clamp(hz, 1u, MAX_HZ)), maxStepsPerFrame(std::max(maxStepsPerFrame, 1u)) {}
+
+    void accumulate(int64_t elapsedNs) {
+        accumulatorNs += std::max<int64_t>(elapsedNs, 0);
+        int64_t limit = stepNs * maxStepsPerFrame;
+        if (accumulatorNs > limit) {
+            droppedNs += accumulatorNs - limit;
+            accumulatorNs = limit;
+        }
+    }
+
+    // Consumes one step if one is owed; call in a loop, simulating once per true return
+    bool step() {
+        if (accumulatorNs < stepNs) {
+            return false;
+        }
+        accumulatorNs -= stepNs;
+        tick++;
+        return true;
+    }
+
+    // Fraction of a step since the latest simulated state, for blending it with the previous one
+    double get_alpha() const { return static_cast<double>(accumulatorNs) / static_cast<double>(stepNs); }
+
+    int64_t get_step_ns() const { return stepNs; }
+    double get_step_seconds() const { return static_cast<double>(stepNs) * 1e-9; }
+    int64_t get_until_next_step_ns() const { return stepNs - accumulatorNs; }
+    uint64_t get_tick() const { return tick; } // Steps simulated so far
+    double get_dropped_seconds() const { return static_cast<double>(droppedNs) * 1e-9; }
+
+private:
+    int64_t stepNs;
+    int64_t maxStepsPerFrame;
+    int64_t accumulatorNs = 0;
+    int64_t droppedNs = 0;
+    uint64_t tick = 0;
+};
+
+// A piece of simulation state as of the last two steps. Call store() once per step with
+// the new state and get() when rendering with the clock's alpha. T needs +, - and
+// scaling by float.
+template <typename T>
+class Interpolated {
+public:
+    Interpolated() = default;
+    explicit Interpolated(const T& value) : previous(value), current(value) {}
+
+    void store(const T& value) {
+        previous = current;
+        current = value;
+    }
+    void reset(const T& value) { previous = current = value; } // Teleports, without a blend
+
+    T get(double alpha) const { return previous + (current - previous) * static_cast<float>(alpha); }
+    const T& latest() const { return current; }
+
+private:
+    T previous{};
+    T current{};
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer for one writer thread and one reader thread. The writer fills
+// its private back slot and publishes it; the reader swaps in the newest published slot.
+// Neither side ever waits: the writer always has a free slot, and the reader keeps its
+// current slot until something newer is complete. Intermediate publishes the reader
+// never saw are simply overwritten.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& write_buffer() { return slots[backIndex]; }
+    void publish() {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side. Returns true when a newer slot was swapped in.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+    const T& read_buffer() const { return slots[frontIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4; // Middle slot holds a publish the reader has not taken
+
+    T slots[3];
+    alignas(64) uint8_t backIndex = 0;           // Writer only
+    alignas(64) std::atomic<uint8_t> middle{1};  // Exchanged by both
+    alignas(64) uint8_t frontIndex = 2;          // Reader only
+};
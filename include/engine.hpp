@@ -1,15 +1,114 @@
 #include <wayland-client.h> // Include Wayland headers
 #include "platform/vulkan_context.hpp" // Include VulkanContext
+#include "assets/asset_archive.hpp"
+#include "assets/asset_cache.hpp"
+#include "assets/async_io.hpp"
+#include "core/arena.hpp"
+#include "core/job_system.hpp"
+#include "core/sim_clock.hpp"
+#include "core/triple_buffer.hpp"
+#include "physics/broadphase.hpp"
+#include "scene/ecs.hpp"
+#include "platform/gpu_driven.hpp"
+#include "platform/event_loop.hpp"
+#include "platform/frame_pacer.hpp"
+#include "platform/presentation_tracker.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
 
 class Engine {
 public:
     Engine(wl_display* display, wl_surface* surface); // Correct constructor declaration
     ~Engine(); // Add destructor declaration
     void run();
+
+    // Immutable view of the simulation handed to the render thread. Buffers are reused
+    // between publishes, so builders should overwrite vectors rather than reallocate them.
+    struct Snapshot {
+        uint64_t tick = 0;          // 0 until the first step has been published
+        double stepSeconds = 0.0;
+        uint64_t publishedNs = 0;   // CLOCK_MONOTONIC
+        double publishedAlpha = 0.0; // Clock alpha left over when this was published
+        float viewProjection[16] = {};
+        std::vector<GpuInstance> previous; // Instances as of tick - 1
+        std::vector<GpuInstance> current;  // Instances as of tick
+    };
+
+    // Simulation thread: called once per fixed step with the step length and the new tick
+    // number, then once per batch of steps to fill the next snapshot
+    using SimulationStep = std::function<void(double stepSeconds, uint64_t tick)>;
+    using SnapshotBuilder = std::function<void(Snapshot& snapshot)>;
+    // Render thread: called once per frame, before recording, with the newest complete
+    // snapshot and the blend factor from `previous` to `current`
+    using RenderInterpolation = std::function<void(const Snapshot& snapshot, double alpha)>;
+
+    // Set before run(); the callbacks run on different threads
+    void set_simulation_step(SimulationStep step);
+    void set_snapshot_builder(SnapshotBuilder builder);
+    void set_render_interpolation(RenderInterpolation interpolate);
+
+    // Shared worker pool for simulation, culling, animation and asset work
+    JobSystem& get_job_system() { return jobs; }
+    // Asynchronous file reads; completions run as jobs on the shared pool
+    AsyncIO& get_asset_io() { return assetIO; }
+    // Packed assets mapped at startup; nullptr when no archive was found
+    const AssetArchive* get_asset_archive() const { return assetArchive.get(); }
+    // Loaded assets by path; register each asset type with its decoder and budget first
+    AssetCache& get_asset_cache() { return assetCache; }
+    // Game objects; owned by the simulation thread once run() has started
+    World& get_world() { return world; }
+    // Overlap pairs, refreshed after every fixed step once it holds bodies; simulation thread only
+    Broadphase& get_broadphase() { return broadphase; }
+    // Per-thread scratch memory that lives until the end of the current rendered frame,
+    // or the current batch of simulation steps; reset wholesale, never freed piecemeal
+    FrameArenas& get_frame_arenas() { return frameArenas; }
+    FrameArenas& get_simulation_arenas() { return simulationArenas; }
+    // Timestamp of a wl_keyboard/wl_pointer event, for input-to-photon latency. The engine
+    // feeds its own seat's events in; call it for input that arrives some other way.
+    void note_input(uint32_t timeMs) { presentation.note_input(timeMs); }
+
     VulkanContext vkContext; // Ensure this is accessible
 
 private:
     void initialize(); // Add initialize method declaration
     void main_loop();  // Add main_loop method declaration
-    void render_frame(); // Add render_frame method declaration
+    bool render_frame(); // False when nothing was presented
+    void simulation_loop();
+    bool run_simulation_steps(); // True when a snapshot was published
+    void interpolate_latest_snapshot();
+    void bind_seat(wl_display* display);
+    static void seat_capabilities(void* data, wl_seat* seat, uint32_t capabilities);
+    static const wl_seat_listener seatListener;
+
+    EventLoop eventLoop;   // Declared after vkContext, which it borrows the display from
+    FramePacer framePacer;
+    PresentationTracker presentation;
+    // Bound only to timestamp input for the presentation tracker
+    wl_seat* seat = nullptr;
+    wl_keyboard* keyboard = nullptr;
+    wl_pointer* pointer = nullptr;
+    JobSystem jobs;
+    AsyncIO assetIO; // After jobs, which its completions run on
+    std::unique_ptr<AssetArchive> assetArchive;
+    AssetCache assetCache; // Reads through assetIO and assetArchive, so declared after both
+    FrameArenas frameArenas;      // Reset by the render thread after each present
+    FrameArenas simulationArenas; // Reset by the simulation thread after each publish
+
+    // Owned by the simulation thread, or the render thread in lockstep mode
+    World world;
+    Broadphase broadphase;
+    SimulationClock simClock;
+    bool simLockstep; // One step per rendered frame on the render thread, for benchmarks and replays
+    uint64_t lastStepNs = 0;
+    SimulationStep simulationStep;
+    SnapshotBuilder snapshotBuilder;
+
+    TripleBuffer<Snapshot> snapshots; // Simulation thread writes, render thread reads
+    RenderInterpolation renderInterpolation;
+
+    std::thread simulationThread;
+    std::atomic<bool> simulationRunning{false};
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "core/job_system.hpp"
+#include "scene/bvh.hpp"
+#include <cstdint>
+#include <vector>
+
+struct BroadphasePair {
+    uint32_t a; // Body handles, a < b
+    uint32_t b;
+};
+
+// Sweep-and-prune, run once per fixed step. Each update picks the axis along which body
+// centres spread the most and buckets bodies into a uniform grid of columns over the
+// other two axes, so dense 3D scenes do not degrade into one long overlapping sweep. A
+// single radix sort orders the entries by column and then by lower endpoint; the sweep
+// runs within each column and is split into ranges across the job system. The sorted
+// pair list is diffed against the previous step's, so contacts can react to pairs that
+// began or ended.
+class Broadphase {
+public:
+    // Column width; 0 picks twice the mean body extent on every update
+    void set_cell_size(float size) { cellSize = size; }
+
+    uint32_t add(const Aabb& bounds, uint32_t userData);
+    // Its pairs are reported as removed by the next update_pairs()
+    void remove(uint32_t body);
+    void update(uint32_t body, const Aabb& bounds);
+    uint32_t get_user_data(uint32_t body) const { return userData[body]; }
+
+    void update_pairs(JobSystem* jobs = nullptr);
+
+    // Sorted by (a, b)
+    const std::vector<BroadphasePair>& get_pairs() const { return pairs; }
+    const std::vector<BroadphasePair>& get_added_pairs() const { return addedPairs; }
+    const std::vector<BroadphasePair>& get_removed_pairs() const { return removedPairs; }
+
+    size_t get_body_count() const { return bodyCount; }
+    int get_sweep_axis() const { return sweepAxis; }
+    uint64_t get_candidate_count() const { return candidateCount; } // Pairs tested in the last sweep
+
+private:
+    // One per column a body touches
+    struct SweepEntry {
+        uint64_t key; // Dense column index, then the quantized lower endpoint
+        uint32_t body;
+    };
+
+    void sweep(uint32_t begin, uint32_t end, std::vector<uint64_t>& out, uint64_t& candidates) const;
+
+    // Indexed by body handle
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    std::vector<uint32_t> userData;
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> freeBodies;
+    std::vector<uint32_t> releasedBodies; // Reusable once the pair diff has seen them go
+    size_t bodyCount = 0;
+
+    // Rebuilt each update in sweep order: the sweep axis first, then the other two
+    std::vector<SweepEntry> entries;
+    std::vector<SweepEntry> entryScratch;
+    std::vector<uint64_t> pairScratch;
+    std::vector<float> sweepMin[3], sweepMax[3];
+    std::vector<uint64_t> sweepKey;
+    std::vector<uint32_t> sweepUpperKey; // Quantized upper endpoint
+    std::vector<uint32_t> sweepBody;
+    std::vector<int32_t> sweepCellU, sweepCellV;
+    std::vector<uint32_t> oversized; // Spanning too many columns; tested against every body
+    std::vector<std::vector<uint64_t>> rangePairs; // One list per job range
+    std::vector<uint64_t> rangeCandidates;
+
+    std::vector<uint64_t> pairKeys; // a << 32 | b, sorted
+    std::vector<uint64_t> previousKeys;
+    std::vector<BroadphasePair> pairs;
+    std::vector<BroadphasePair> addedPairs;
+    std::vector<BroadphasePair> removedPairs;
+    float cellSize = 0.0f;
+    float activeCellSize = 1.0f;
+    int sweepAxis = 0;
+    uint64_t candidateCount = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+// Hands out stable slots in a fixed-size array; released slots are recycled first.
+class DescriptorIndexAllocator {
+public:
+    explicit DescriptorIndexAllocator(uint32_t capacity = 0);
+
+    uint32_t allocate(); // Returns INVALID_INDEX when the array is full
+    void release(uint32_t index);
+    uint32_t capacity() const { return capacityLimit; }
+    uint32_t in_use() const { return nextIndex - static_cast<uint32_t>(freeList.size()); }
+
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+private:
+    uint32_t capacityLimit;
+    uint32_t nextIndex = 0;
+    std::vector<uint32_t> freeList;
+    std::vector<bool> inUse; // Per handed-out slot, so a second release is caught
+};
+
+// Push constants shared by every bindless pipeline; materials reference resources by index.
+struct BindlessPushConstants {
+    uint32_t textureIndex;
+    uint32_t samplerIndex;
+    uint32_t materialBufferIndex;
+    uint32_t instanceBufferIndex;
+    uint32_t userData[4];
+};
+
+// One global update-after-bind descriptor set holding every sampled image, sampler and
+// storage buffer in the engine. It is bound once per command buffer, so draws only push indices.
+class BindlessHeap {
+public:
+    enum Binding : uint32_t {
+        SAMPLED_IMAGE_BINDING = 0,
+        SAMPLER_BINDING = 1,
+        STORAGE_BUFFER_BINDING = 2,
+    };
+
+    BindlessHeap(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~BindlessHeap();
+
+    BindlessHeap(const BindlessHeap&) = delete;
+    BindlessHeap& operator=(const BindlessHeap&) = delete;
+
+    uint32_t register_image(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t register_sampler(VkSampler sampler);
+    uint32_t register_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // The caller must make sure no in-flight frame still reads the slot before releasing it
+    void release_image(uint32_t index);
+    void release_sampler(uint32_t index);
+    void release_storage_buffer(uint32_t index);
+
+    void bind(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint) const;
+    void push_constants(VkCommandBuffer cmdBuffer, const BindlessPushConstants& constants) const;
+
+    VkDescriptorSetLayout get_set_layout() const { return setLayout; }
+    VkPipelineLayout get_pipeline_layout() const { return pipelineLayout; }
+
+    // Checks the descriptor indexing features this heap relies on
+    static bool is_supported(const VkPhysicalDeviceVulkan12Features& features);
+
+private:
+    void create_layout();
+    void create_pool_and_set();
+
+    VkDevice device;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    DescriptorIndexAllocator images;
+    DescriptorIndexAllocator samplers;
+    DescriptorIndexAllocator storageBuffers;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Defers destruction of GPU resources until the frame that last used them has retired.
+// Frame numbers are monotonic and frames complete in submission order, so entries are
+// kept in a FIFO and collection stops at the first one that is still in flight.
+class DeletionQueue {
+public:
+    ~DeletionQueue();
+
+    void retire(uint64_t frame, std::function<void()> destroy);
+    void collect(uint64_t completedFrame);
+    void flush(); // Destroys everything; only valid once the device is idle
+    size_t pending() const { return entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t frame;
+        std::function<void()> destroy;
+    };
+    std::deque<Entry> entries;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// SPIR-V compiled, optimized and stripped at build time (see the engine_shaders target)
+struct EmbeddedShader {
+    const char* name; // Source file name, e.g. "gpu_cull.comp"
+    const uint32_t* code;
+    size_t wordCount;
+};
+
+// Defined in the generated embedded_shaders.cpp
+extern const EmbeddedShader EMBEDDED_SHADERS[];
+extern const size_t EMBEDDED_SHADER_COUNT;
+
+const EmbeddedShader* find_embedded_shader(const char* name); // Null when not embedded
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <wayland-client.h>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Single-threaded event pump over epoll. The Wayland display fd is read with
+// prepare_read/read_events/dispatch_pending instead of wl_display_dispatch, so no
+// call ever blocks on the socket alone: timerfds and other fds are watched in the
+// same epoll set, and an eventfd lets other threads wake the loop or hand it work.
+class EventLoop {
+public:
+    using Handler = std::function<void()>;
+
+    explicit EventLoop(wl_display* display);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Runs `handler` on the loop thread whenever `fd` is readable; the fd stays caller-owned
+    void watch(int fd, Handler handler);
+    void unwatch(int fd);
+
+    // Thread-safe. post() queues `task` to run on the loop thread; wake() only interrupts the wait.
+    void post(Handler task);
+    void wake();
+
+    // Dispatches whatever is ready, waiting up to `timeoutMs` (-1 forever, 0 never) for
+    // something to arrive. Returns false once the display connection has failed.
+    bool run_once(int timeoutMs);
+
+    wl_display* get_display() const { return display; }
+
+private:
+    void run_posted();
+
+    wl_display* display;
+    int displayFd;
+    int epollFd = -1;
+    int wakeFd = -1;
+    bool watchingWritable = false; // EPOLLOUT on the display while a flush is backed up
+
+    std::unordered_map<int, Handler> handlers;
+
+    std::mutex postedMutex;
+    std::vector<Handler> posted;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "platform/render_graph.hpp"
+#include "platform/vulkan_buffer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat {
+    Qoi,
+    Png, // Uncompressed deflate; larger files, no zlib dependency
+};
+
+// Stall-free frame capture. Selected images are copied into a ring of host-visible
+// readback buffers; once the frame's fence has signalled, a worker thread encodes the
+// mapped pixels straight to disk. If every slot is still busy the frame is skipped
+// rather than waiting on the GPU or the encoder.
+class FrameCapture {
+public:
+    struct Stats {
+        uint64_t captured = 0;
+        uint64_t dropped = 0;
+        double recordMicroseconds = 0.0; // Render-thread cost accumulated while capturing
+        double encodeMilliseconds = 0.0; // Worker time, off the render thread
+    };
+
+    using RetireFn = std::function<void(std::function<void()>)>;
+
+    FrameCapture(VkPhysicalDevice physicalDevice, VkDevice device, RetireFn retire, std::string directory,
+                 CaptureFormat format, uint32_t interval, uint32_t slotCount = 3);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Adds a copy pass for `image` when this frame is due for capture. `frame` is the
+    // number the frame will carry once submitted. Expects a 4-byte BGRA/RGBA format.
+    void add_to_graph(RenderGraph& graph, RGHandle image, VkExtent2D extent, VkFormat format, uint64_t frame);
+
+    // Hands slots whose frames have completed on the GPU to the encoder thread
+    void collect(uint64_t completedFrame);
+
+    Stats get_stats() const;
+
+private:
+    enum SlotState : int { SLOT_FREE, SLOT_IN_FLIGHT, SLOT_ENCODING };
+
+    struct Slot {
+        GpuBuffer buffer;
+        std::atomic<int> state{SLOT_FREE};
+        uint64_t frame = 0;
+        VkExtent2D extent{};
+        bool swizzle = false;
+    };
+
+    void worker_loop();
+    void encode(Slot& slot);
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+    RetireFn retire;
+    std::string directory;
+    CaptureFormat format;
+    uint32_t interval;
+    uint64_t framesSeen = 0;
+
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Slot*> pending;
+    bool stopping = false;
+    Stats stats;
+};
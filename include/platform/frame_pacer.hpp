@@ -0,0 +1,47 @@
+#pragma once
+
+#include <wayland-client.h>
+#include "platform/event_loop.hpp"
+#include <cstdint>
+
+// Paces rendering with wl_surface.frame callbacks, so frames line up with the
+// compositor's repaint cycle at whatever rate the output runs and stop while the
+// surface is hidden (compositors withhold callbacks then). Until the first callback
+// arrives a timerfd, watched by the event loop, paces at `fallbackHz` instead.
+class FramePacer {
+public:
+    enum class Wake {
+        Frame,  // Render now
+        Events, // Only Wayland events were dispatched; check quit state and wait again
+        Error,  // Display connection failed
+    };
+
+    FramePacer(EventLoop& loop, wl_surface* surface, uint32_t fallbackHz = 60);
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Call before the commit that presents the frame; the callback rides on that commit
+    void request_frame();
+    // Runs one pass of the event loop, blocking until something arrives
+    Wake wait();
+
+    bool is_callback_driven() const { return callbacksSeen; }
+    double get_refresh_interval_ms() const { return refreshIntervalMs; } // Measured from callback timestamps
+
+private:
+    static void frame_done(void* data, wl_callback* callback, uint32_t time);
+    static const wl_callback_listener frameListener;
+
+    void on_timer();
+
+    EventLoop& loop;
+    wl_surface* surface;
+    wl_callback* callback = nullptr;
+    int timerFd = -1;
+    bool frameDue = true; // The first frame needs no callback
+    bool callbacksSeen = false;
+    uint32_t lastCallbackTime = 0;
+    double refreshIntervalMs;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "platform/vulkan_buffer.hpp"
+#include <cstdint>
+
+// Persistently mapped, host-visible streaming buffer split into one region per frame in
+// flight. Each frame bump-allocates transient uniform/vertex/index data out of its region;
+// the region is reused wholesale once that frame's fence has signalled.
+class FrameRingBuffer {
+public:
+    struct Allocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* data = nullptr;
+        VkDeviceAddress address = 0; // Zero without bufferDeviceAddress
+
+        uint32_t dynamic_offset() const { return static_cast<uint32_t>(offset); }
+    };
+
+    FrameRingBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bytesPerFrame,
+                    uint32_t frameCount, bool deviceAddress);
+    ~FrameRingBuffer();
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+    // Call only after the fence of the frame that last used this slot has signalled
+    void begin_frame(uint32_t frameSlot);
+
+    Allocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+    Allocation allocate_uniform(VkDeviceSize size); // Aligned for dynamic uniform offsets
+    template <typename T>
+    Allocation push(const T& value) {
+        Allocation allocation = allocate_uniform(sizeof(T));
+        *static_cast<T*>(allocation.data) = value;
+        return allocation;
+    }
+
+    // Set 0-compatible layout with one UNIFORM_BUFFER_DYNAMIC at binding 0
+    VkDescriptorSetLayout get_set_layout() const { return setLayout; }
+    void bind_uniform(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout,
+                      uint32_t setIndex, const Allocation& allocation) const;
+
+    VkDeviceSize get_frame_usage() const { return cursor - regionStart; }
+    VkDeviceSize get_peak_usage() const { return peakUsage; }
+    VkDeviceSize get_uniform_range() const { return uniformRange; }
+
+private:
+    void create_descriptor_set();
+
+    VkDevice device;
+    GpuBuffer buffer;
+    VkDeviceSize bytesPerFrame;
+    VkDeviceSize uniformAlignment;
+    VkDeviceSize uniformRange;
+    VkDeviceAddress baseAddress = 0;
+
+    VkDeviceSize regionStart = 0;
+    VkDeviceSize cursor = 0;
+    VkDeviceSize peakUsage = 0;
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+};
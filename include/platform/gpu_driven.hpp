@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "platform/gpu_instance.hpp"
+#include "platform/pipeline_cache.hpp"
+#include "platform/render_graph.hpp"
+#include "platform/vulkan_buffer.hpp"
+#include <cstdint>
+#include <vector>
+
+class VulkanContext;
+
+// GPU-driven geometry path: a compute pass frustum-culls every instance and writes
+// VkDrawIndexedIndirectCommands, then the graphics pass issues one indirect draw per
+// material bucket. CPU work per frame does not depend on the instance count.
+class GpuDrivenRenderer {
+public:
+    GpuDrivenRenderer(VulkanContext& context, uint32_t maxInstances, uint32_t maxMeshes, uint32_t bucketCount);
+    ~GpuDrivenRenderer();
+
+    GpuDrivenRenderer(const GpuDrivenRenderer&) = delete;
+    GpuDrivenRenderer& operator=(const GpuDrivenRenderer&) = delete;
+
+    // Both are staged on the CPU and copied into a frame's own buffers when that frame is
+    // recorded, so frames still in flight keep reading what they were recorded with. Model
+    // matrices maintained by a TransformHierarchy need its invalidate_instances() afterwards.
+    void set_meshes(const std::vector<GpuMesh>& meshes);
+    void set_instances(const std::vector<GpuInstance>& instances); // Groups instances by bucket
+
+    // The recorded frame's mapped instance buffer, for TransformHierarchy::update() to
+    // write model matrices into in place. Valid from the frame's fence wait until it is
+    // submitted, i.e. while its graph is built; the other fields belong to set_instances().
+    GpuInstance* map_instances();
+
+    void set_bucket_pipeline(uint32_t bucket, VkPipeline pipeline, VkPipelineLayout layout);
+    void set_bucket_pipeline(uint32_t bucket, const GraphicsPipelineDesc& desc); // Via the context's pipeline cache
+    void set_geometry(VkBuffer vertexBuffer, VkBuffer indexBuffer, VkIndexType indexType);
+    void set_view_projection(const float viewProjection[16]); // Column-major
+
+    // Adds reset, cull and draw passes; the graph places every barrier between them
+    void add_to_graph(RenderGraph& graph, RGHandle colorTarget, RGHandle depthTarget = RG_INVALID_HANDLE);
+
+    // Slot of the recorded frame's instance buffer in the bindless heap, for vertex shaders (UINT32_MAX if none)
+    uint32_t get_instance_buffer_index() const;
+    bool uses_draw_count() const { return compactDraws; }
+
+private:
+    void create_buffers();
+    void create_cull_pipeline();
+    void upload_frame(uint32_t frameSlot);
+    void record_cull(VkCommandBuffer cmdBuffer, uint32_t frameSlot);
+    void record_draws(VkCommandBuffer cmdBuffer);
+
+    struct CullParams {
+        float planes[6][4];
+        uint32_t instanceCount;
+    };
+
+    struct Bucket {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        GraphicsPipelineDesc desc;
+        bool cached = false;
+    };
+
+    VulkanContext& context;
+    VkDevice device;
+    uint32_t maxInstances;
+    uint32_t maxMeshes;
+    uint32_t instanceCount = 0;
+    bool compactDraws;
+
+    // Host-written inputs, one copy per frame in flight
+    struct FrameInputs {
+        GpuBuffer instanceBuffer;
+        GpuBuffer meshBuffer;
+        GpuBuffer bucketOffsetBuffer;
+        VkDescriptorSet cullSet = VK_NULL_HANDLE;
+        uint32_t instanceBufferIndex = UINT32_MAX;
+    };
+
+    std::vector<Bucket> buckets;
+    CullParams cullParams{};
+
+    std::vector<GpuInstance> stagedInstances;
+    std::vector<GpuMesh> stagedMeshes;
+    std::vector<uint32_t> stagedBucketOffsets;
+    uint32_t staleInstanceFrames = 0; // Bit per frame slot whose copy predates the last set_*()
+    uint32_t staleMeshFrames = 0;
+
+    std::vector<FrameInputs> frames;
+    GpuBuffer drawBuffer;
+    GpuBuffer countBuffer;
+
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+    VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool cullPool = VK_NULL_HANDLE;
+    VkPipelineLayout cullLayout = VK_NULL_HANDLE;
+    VkPipeline cullPipeline = VK_NULL_HANDLE;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// std430 layouts shared with shaders/gpu_cull.comp. Kept free of Vulkan so scene code
+// can fill instance arrays without pulling in the renderer.
+struct GpuInstance {
+    float model[16];   // Column-major local-to-world
+    float center[3];   // Local bounding sphere
+    float radius;
+    uint32_t mesh;
+    uint32_t bucket;   // Material bucket, one indirect draw call each
+    uint32_t drawSlot; // Filled by GpuDrivenRenderer::set_instances()
+    uint32_t pad;
+};
+
+struct GpuMesh {
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t pad;
+};
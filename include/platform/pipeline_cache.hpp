@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "platform/shader_module.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Everything that selects a graphics pipeline for the dynamic rendering path. Viewport
+// and scissor are always dynamic state.
+struct GraphicsPipelineDesc {
+    // Vertex input interface
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    // Pre-rasterization
+    VkShaderModule vertexShader = VK_NULL_HANDLE;
+    SpecializationConstants vertexConstants;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    // Fragment shader
+    VkShaderModule fragmentShader = VK_NULL_HANDLE;
+    SpecializationConstants fragmentConstants;
+    bool depthTest = false;
+    bool depthWrite = false;
+    VkCompareOp depthCompare = VK_COMPARE_OP_GREATER_OR_EQUAL; // Reversed Z
+
+    // Fragment output interface
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    bool alphaBlend = false;
+};
+
+// Graphics pipelines keyed by GraphicsPipelineDesc, backed by an on-disk VkPipelineCache.
+// With VK_EXT_graphics_pipeline_library the four pipeline stages are compiled once as
+// libraries and shared between descriptors; a pipeline seen for the first time is only
+// linked, which takes microseconds, and a link-time-optimized build replaces it from a
+// background thread. Without the extension pipelines are compiled in full on first use.
+class GraphicsPipelineCache {
+public:
+    struct Stats {
+        uint64_t libraries = 0;      // Stage libraries compiled
+        uint64_t fastLinks = 0;      // Pipelines linked without optimization
+        uint64_t optimized = 0;      // Background upgrades swapped in
+        uint64_t fullCompiles = 0;   // Monolithic compiles, when libraries are unavailable
+        double firstUseMicroseconds = 0.0; // Render-thread time spent creating pipelines
+    };
+
+    using RetireFn = std::function<void(std::function<void()>)>;
+
+    GraphicsPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, RetireFn retire, bool useLibraries,
+                          std::string cachePath);
+    ~GraphicsPipelineCache();
+
+    GraphicsPipelineCache(const GraphicsPipelineCache&) = delete;
+    GraphicsPipelineCache& operator=(const GraphicsPipelineCache&) = delete;
+
+    // Compiles the stage libraries for `desc` ahead of time, e.g. at load; no-op without libraries
+    void prepare(const GraphicsPipelineDesc& desc);
+
+    // Returns the best pipeline available now. Call while recording: a linked pipeline
+    // is retired through the deletion queue once its optimized build has been swapped in.
+    VkPipeline get(const GraphicsPipelineDesc& desc);
+
+    // Swaps in finished background builds; call once per frame
+    void collect();
+
+    bool uses_libraries() const { return useLibraries; }
+    Stats get_stats() const { return stats; }
+
+private:
+    enum LibraryPart { VERTEX_INPUT, PRE_RASTERIZATION, FRAGMENT_SHADER, FRAGMENT_OUTPUT, PART_COUNT };
+
+    struct Entry {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        bool optimized = false;
+    };
+
+    struct UpgradeJob {
+        uint64_t key;
+        VkPipelineLayout layout;
+        VkPipeline libraries[PART_COUNT];
+        VkPipeline result = VK_NULL_HANDLE;
+    };
+
+    static uint64_t part_key(LibraryPart part, const GraphicsPipelineDesc& desc);
+
+    void load_cache_file();
+    void save_cache_file();
+
+    VkPipeline get_library(LibraryPart part, const GraphicsPipelineDesc& desc);
+    VkPipeline create_library(LibraryPart part, const GraphicsPipelineDesc& desc);
+    VkPipeline link(const VkPipeline* libraries, VkPipelineLayout layout, bool optimize);
+    VkPipeline compile_full(const GraphicsPipelineDesc& desc);
+    void worker_loop();
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+    RetireFn retire;
+    bool useLibraries;
+    std::string cachePath;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+
+    std::unordered_map<uint64_t, VkPipeline> libraries[PART_COUNT];
+    std::unordered_map<uint64_t, Entry> pipelines;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<UpgradeJob> queued;
+    std::vector<UpgradeJob> finished;
+    bool stopping = false;
+    Stats stats;
+};
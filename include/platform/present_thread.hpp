@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "core/spsc_queue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Owns vkAcquireNextImageKHR and vkQueuePresentKHR on a dedicated thread, so a FIFO
+// swapchain waiting for vblank never stalls simulation or command recording. The
+// render thread takes pre-acquired images and hands back submitted frames through
+// lock-free queues; it only sleeps when no image has been acquired yet.
+class PresentThread {
+public:
+    struct AcquiredImage {
+        uint32_t imageIndex = 0;
+        VkSemaphore semaphore = VK_NULL_HANDLE; // Signalled by the acquire; wait on it in the submit
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        double imageWaitMilliseconds = 0.0; // Render thread waiting for an acquired image
+        double imageWaitMaxMilliseconds = 0.0;
+        double acquireMilliseconds = 0.0;   // Present thread inside vkAcquireNextImageKHR
+        double acquireMaxMilliseconds = 0.0;
+        double presentMilliseconds = 0.0;   // Present thread inside vkQueuePresentKHR
+        double presentMaxMilliseconds = 0.0;
+    };
+
+    // `queueMutex` guards the queue shared with the render thread's submits
+    PresentThread(VkDevice device, VkQueue queue, std::mutex& queueMutex, VkSwapchainKHR swapchain);
+    ~PresentThread();
+
+    PresentThread(const PresentThread&) = delete;
+    PresentThread& operator=(const PresentThread&) = delete;
+
+    // Render thread. Returns false once the swapchain is out of date and every queued
+    // present has been issued; recreate it, then call resume().
+    bool acquire(AcquiredImage& image);
+    void present(uint32_t imageIndex, VkSemaphore renderFinished);
+    // Returns an acquire semaphore once the frame that waited on it has completed
+    void release_semaphore(VkSemaphore semaphore);
+    void resume(VkSwapchainKHR newSwapchain);
+    // Called on the present thread right before each vkQueuePresentKHR
+    void set_present_hook(std::function<void()> hook);
+
+    Stats get_stats() const;
+
+private:
+    struct PendingPresent {
+        uint32_t imageIndex;
+        VkSemaphore renderFinished;
+    };
+
+    // Rings sized above the semaphore pool, so pushes from either side never fail
+    static constexpr uint32_t SEMAPHORE_COUNT = 4;
+    static constexpr size_t QUEUE_CAPACITY = 8;
+
+    void thread_loop();
+    bool present_pending();
+    bool try_acquire();
+    void notify();
+
+    VkDevice device;
+    VkQueue queue;
+    std::mutex& queueMutex;
+    VkSwapchainKHR swapchain; // Only touched by the present thread while it is running
+
+    std::vector<VkSemaphore> semaphores;
+    VkSemaphore spareSemaphore = VK_NULL_HANDLE; // Present thread's semaphore after a failed acquire
+
+    SpscQueue<AcquiredImage, QUEUE_CAPACITY> acquired;      // Present thread -> render thread
+    SpscQueue<PendingPresent, QUEUE_CAPACITY> presents;     // Render thread -> present thread
+    SpscQueue<VkSemaphore, QUEUE_CAPACITY> freeSemaphores;  // Render thread -> present thread
+
+    std::atomic<uint32_t> presentsPending{0};
+    std::atomic<bool> recreateRequested{false};
+    std::atomic<bool> failed{false};
+    std::atomic<bool> stopping{false};
+    std::function<void()> presentHook; // Guarded by queueMutex
+
+    // Sleeping only; the queues themselves take no lock
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    mutable std::mutex statsMutex;
+    Stats stats;
+    std::thread thread;
+};
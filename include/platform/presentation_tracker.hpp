@@ -0,0 +1,87 @@
+#pragma once
+
+#include <wayland-client.h>
+#include <presentation-time-client-protocol.h>
+#include "core/latency_histogram.hpp"
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// Measures when frames actually reach the screen through wp_presentation. Call
+// frame_committed() right before the commit that carries a frame, whether that is an
+// SHM attach or a vkQueuePresentKHR, from whichever thread makes that commit (see
+// VulkanContext::set_present_hook); the compositor reports back the scan-out time,
+// refresh interval, vblank sequence and how the frame was presented. Input events
+// passed to note_input() are matched to the next committed frame for input-to-photon
+// latency. Without wp_presentation every call is a no-op.
+class PresentationTracker {
+public:
+    struct PresentedFrame {
+        uint64_t presentedNs = 0; // Presentation clock, see get_clock_id()
+        uint32_t refreshNs = 0;   // 0 when the output has no fixed refresh
+        uint64_t sequence = 0;    // Output vblank counter
+        uint32_t flags = 0;       // wp_presentation_feedback_kind bits
+    };
+
+    struct Stats {
+        uint64_t presented = 0;
+        uint64_t discarded = 0;        // Superseded before scan-out
+        uint64_t vsync = 0;            // Per-flag counts over presented frames
+        uint64_t zeroCopy = 0;
+        uint64_t hwCompletion = 0;
+        uint64_t hwClock = 0;
+        uint64_t missedRefreshes = 0;  // Vblanks between consecutive frames beyond the first
+        LatencyHistogram commitToPresent;
+        LatencyHistogram inputToPhoton;
+    };
+
+    PresentationTracker(wl_display* display, wl_surface* surface);
+    ~PresentationTracker();
+
+    PresentationTracker(const PresentationTracker&) = delete;
+    PresentationTracker& operator=(const PresentationTracker&) = delete;
+
+    bool is_available() const { return presentation != nullptr; }
+    uint32_t get_clock_id() const { return clockId; }
+
+    // `timeMs` is the timestamp of a wl_keyboard/wl_pointer event; the oldest one since
+    // the last committed frame is kept
+    void note_input(uint32_t timeMs);
+    void frame_committed();
+
+    const PresentedFrame& get_last_presented() const { return lastPresented; }
+    const Stats& get_stats() const { return stats; }
+
+private:
+    struct PendingFrame {
+        uint64_t commitNs;
+        uint64_t inputNs; // 0 without input
+    };
+
+    static void registry_global(void* data, wl_registry* registry, uint32_t id, const char* interface,
+                                uint32_t version);
+    static void registry_global_remove(void* data, wl_registry* registry, uint32_t id);
+    static void clock_id_event(void* data, wp_presentation* presentation, uint32_t clockId);
+    // `struct` is required: the feedback request function shares the type's name
+    static void sync_output(void* data, struct wp_presentation_feedback* feedback, wl_output* output);
+    static void presented(void* data, struct wp_presentation_feedback* feedback, uint32_t secondsHi, uint32_t secondsLo,
+                          uint32_t nanoseconds, uint32_t refresh, uint32_t sequenceHi, uint32_t sequenceLo,
+                          uint32_t flags);
+    static void discarded(void* data, struct wp_presentation_feedback* feedback);
+
+    static const wl_registry_listener registryListener;
+    static const wp_presentation_listener presentationListener;
+    static const wp_presentation_feedback_listener feedbackListener;
+
+    uint64_t now_ns() const;
+
+    wl_surface* surface;
+    wp_presentation* presentation = nullptr;
+    uint32_t clockId;
+    std::mutex mutex; // Guards the two below; frame_committed() may run on the present thread
+    uint64_t pendingInputNs = 0;
+    std::unordered_map<struct wp_presentation_feedback*, PendingFrame> pending;
+
+    PresentedFrame lastPresented;
+    Stats stats;
+};
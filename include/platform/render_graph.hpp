@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using RGHandle = uint32_t;
+constexpr RGHandle RG_INVALID_HANDLE = UINT32_MAX;
+
+// How a pass touches a resource; each maps to a fixed stage/access/layout triple
+enum class RGUsage {
+    ColorAttachment,
+    DepthAttachment,
+    DepthRead,
+    Sampled,
+    StorageRead,
+    StorageWrite,
+    TransferSrc,
+    TransferDst,
+    IndirectRead,
+    VertexRead,
+    Present,
+};
+
+struct RGTextureDesc {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageUsageFlags usage = 0;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+    bool operator==(const RGTextureDesc& other) const {
+        return width == other.width && height == other.height && format == other.format &&
+               usage == other.usage && aspect == other.aspect;
+    }
+};
+
+// Frame render graph. Passes declare the resources they read and write; compile() culls
+// passes nothing depends on, orders the rest, derives synchronization2 barriers and packs
+// transient textures with disjoint lifetimes into shared memory. Requires Vulkan 1.3.
+class RenderGraph {
+public:
+    class PassBuilder {
+    public:
+        RGHandle create_texture(const std::string& name, const RGTextureDesc& desc);
+        void read(RGHandle handle, RGUsage usage);
+        void write(RGHandle handle, RGUsage usage);
+        void color_attachment(RGHandle handle, const VkClearColorValue* clear = nullptr);
+        void depth_attachment(RGHandle handle, const VkClearDepthStencilValue* clear = nullptr);
+        void side_effect(); // Keeps the pass alive even if nothing reads its outputs
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t passIndex) : graph(graph), passIndex(passIndex) {}
+
+        RenderGraph& graph;
+        uint32_t passIndex;
+    };
+
+    using SetupFn = std::function<void(PassBuilder&)>;
+    using ExecuteFn = std::function<void(VkCommandBuffer)>;
+    using RetireFn = std::function<void(std::function<void()>)>;
+
+    struct Stats {
+        uint32_t declaredPasses = 0;
+        uint32_t culledPasses = 0;
+        uint32_t barriers = 0;
+        VkDeviceSize transientBytes = 0; // Sum of every transient texture's requirements
+        VkDeviceSize allocatedBytes = 0; // Memory actually backing them after aliasing
+    };
+
+    RenderGraph(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // Drops passes and virtual resources; physical transient memory is kept for the next frame
+    void reset();
+
+    // Lets replaced transient memory outlive the frames still using it
+    void set_retire_function(RetireFn retire) { retireFn = std::move(retire); }
+
+    // Imported resources are graph outputs and are never culled
+    RGHandle import_texture(const std::string& name, VkImage image, VkImageView view, VkExtent2D extent,
+                            VkImageLayout initialLayout, RGUsage finalUsage,
+                            VkPipelineStageFlags2 initialStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+    RGHandle import_buffer(const std::string& name, VkBuffer buffer, VkDeviceSize size);
+
+    void add_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute);
+
+    void compile();
+    void execute(VkCommandBuffer cmdBuffer);
+    void dump(std::ostream& out) const;
+
+    VkImage get_image(RGHandle handle) const;
+    VkImageView get_image_view(RGHandle handle) const;
+    VkBuffer get_buffer(RGHandle handle) const;
+    const Stats& get_stats() const { return stats; }
+
+private:
+    struct UsageState {
+        VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        bool write = false;
+    };
+
+    struct Resource {
+        std::string name;
+        bool isBuffer = false;
+        bool imported = false;
+        RGTextureDesc desc;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize bufferSize = 0;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 initialStage = VK_PIPELINE_STAGE_2_NONE;
+        bool hasFinalUsage = false;
+        RGUsage finalUsage = RGUsage::Present;
+
+        // Filled by compile()
+        int firstUse = -1;
+        int lastUse = -1;
+        int aliasBucket = -1;
+        int aliasPredecessor = -1;
+        VkMemoryRequirements requirements{};
+    };
+
+    struct Access {
+        RGHandle handle;
+        UsageState state;
+    };
+
+    struct Attachment {
+        RGHandle handle;
+        bool clear = false;
+        VkClearValue clearValue{};
+    };
+
+    struct Barrier {
+        RGHandle handle;
+        UsageState src;
+        UsageState dst;
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<Access> accesses;
+        std::vector<Attachment> colorAttachments;
+        bool hasDepth = false;
+        Attachment depthAttachment{};
+        bool sideEffect = false;
+        ExecuteFn execute;
+
+        // Filled by compile()
+        bool culled = false;
+        std::vector<Barrier> barriers;
+    };
+
+    struct AliasBucket {
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeBits = ~0u;
+        std::vector<uint32_t> occupants;
+    };
+
+    void add_access(uint32_t passIndex, RGHandle handle, RGUsage usage);
+    void cull_passes();
+    void order_passes();
+    void compute_lifetimes();
+    void plan_aliasing();
+    void realize_transients();
+    void build_barriers();
+    void destroy_transients();
+    void record_barriers(VkCommandBuffer cmdBuffer, const std::vector<Barrier>& barriers) const;
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<uint32_t> executionOrder;
+    std::vector<Barrier> finalBarriers;
+    std::vector<AliasBucket> buckets;
+    Stats stats;
+    bool compiled = false;
+    RetireFn retireFn;
+
+    // Physical transient resources survive reset() and are rebuilt only when the plan changes
+    struct PhysicalTexture {
+        RGTextureDesc desc;
+        int bucket;
+        VkImage image;
+        VkImageView view;
+    };
+    std::vector<PhysicalTexture> physicalTextures;
+    std::vector<VkDeviceMemory> bucketMemory;
+};
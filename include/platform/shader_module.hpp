@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Creates a module from the SPIR-V embedded at build time; `name` is the source file
+// name under shaders/, e.g. "gpu_cull.comp"
+VkShaderModule load_shader_module(VkDevice device, const std::string& name);
+
+// Values for a shader's specialization constants. Variants are selected at pipeline
+// creation from one module instead of embedding every permutation.
+class SpecializationConstants {
+public:
+    SpecializationConstants& set(uint32_t constantId, uint32_t value);
+    SpecializationConstants& set(uint32_t constantId, int32_t value);
+    SpecializationConstants& set(uint32_t constantId, float value);
+    SpecializationConstants& set(uint32_t constantId, bool value); // Stored as VkBool32
+
+    bool empty() const { return entries.empty(); }
+    // Points into this object; valid until the next set()
+    VkSpecializationInfo info() const;
+
+    const std::vector<VkSpecializationMapEntry>& get_entries() const { return entries; }
+    const std::vector<uint32_t>& get_data() const { return data; }
+
+private:
+    SpecializationConstants& set_word(uint32_t constantId, uint32_t word);
+
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint32_t> data;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "platform/render_graph.hpp"
+#include "platform/vulkan_buffer.hpp"
+#include <cstdint>
+#include <vector>
+
+class ShmRenderer;
+
+// Presents Vulkan-rendered frames through ShmRenderer's wl_shm buffers instead of a
+// VkSwapchainKHR, so the Vulkan path runs on any compositor and software ICD. With
+// VK_EXT_external_memory_host the wl_shm pool is imported and the GPU copies straight
+// into it; otherwise frames go through a host-visible staging buffer and one memcpy.
+class ShmPresenter {
+public:
+    struct Stats {
+        uint64_t presented = 0;
+        uint64_t dropped = 0;          // No free wl_shm buffer at record time
+        double copyMilliseconds = 0.0; // CPU memcpy time (staging mode only)
+    };
+
+    ShmPresenter(VkPhysicalDevice physicalDevice, VkDevice device, ShmRenderer& shmRenderer, VkExtent2D extent,
+                 uint32_t frameSlots, bool hostImport);
+    ~ShmPresenter();
+
+    ShmPresenter(const ShmPresenter&) = delete;
+    ShmPresenter& operator=(const ShmPresenter&) = delete;
+
+    VkImage get_image() const { return image; }
+    VkImageView get_image_view() const { return imageView; }
+    VkFormat get_format() const { return VK_FORMAT_B8G8R8A8_UNORM; } // Byte order of WL_SHM_FORMAT_ARGB8888
+    VkExtent2D get_extent() const { return extent; }
+    bool is_zero_copy() const { return zeroCopy; }
+    const Stats& get_stats() const { return stats; }
+
+    // Reserves a wl_shm buffer for this frame slot and adds the readback pass
+    void add_to_graph(RenderGraph& graph, RGHandle target, uint32_t frameSlot);
+    // Call after the slot's fence has signalled; commits the frame it rendered last time
+    void present_completed(uint32_t frameSlot);
+    bool has_completed(uint32_t frameSlot) const { return slotPoolIndex[frameSlot] >= 0; } // Something to commit
+
+private:
+    void create_image();
+    bool import_pool();
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+    ShmRenderer& shmRenderer;
+    VkExtent2D extent;
+    bool zeroCopy = false;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+    VkImageView imageView = VK_NULL_HANDLE;
+
+    // Zero-copy: the imported pool and one buffer per wl_shm buffer
+    VkDeviceMemory importedMemory = VK_NULL_HANDLE;
+    std::vector<VkBuffer> importedBuffers;
+
+    // Staging mode: one readback buffer per frame slot
+    std::vector<GpuBuffer> stagingBuffers;
+
+    std::vector<int> slotPoolIndex; // wl_shm buffer each slot is rendering into, or -1
+    Stats stats;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+struct GpuBuffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // Persistently mapped when host-visible memory was requested
+};
+
+// Throws when no memory type matches
+uint32_t find_memory_type(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags properties);
+
+// Tries required|preferred memory first, then required alone, also when the preferred heap is full
+GpuBuffer create_gpu_buffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size,
+                            VkBufferUsageFlags usage, VkMemoryPropertyFlags required,
+                            VkMemoryPropertyFlags preferred = 0);
+void destroy_gpu_buffer(VkDevice device, GpuBuffer& buffer);
@@ -3,16 +3,44 @@
 #include <vulkan/vulkan.h>
 #include <wayland-client.h>
 #include <xdg-shell-client-protocol.h>
+#include "platform/bindless_heap.hpp"
+#include "platform/render_graph.hpp"
+#include "platform/deletion_queue.hpp"
+#include "platform/vulkan_buffer.hpp"
+#include "platform/frame_ring_buffer.hpp"
+#include "platform/frame_capture.hpp"
+#include "platform/shm_presenter.hpp"
+#include "platform/pipeline_cache.hpp"
+#include "platform/present_thread.hpp"
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+class ShmRenderer;
+
+enum class PresentPath {
+    Swapchain, // VK_KHR_wayland_surface + vkQueuePresentKHR
+    Shm,       // Offscreen image read back into wl_shm buffers; needs no WSI support
+};
+
 class VulkanContext {
 public:
-    VulkanContext(wl_display* display, wl_surface* surface);
+    // Adds passes to the frame graph after the backbuffer clear; dynamic rendering path only
+    using FrameGraphBuilder = std::function<void(RenderGraph& graph, RGHandle backbuffer)>;
+
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+    static constexpr VkDeviceSize FRAME_RING_BYTES = 4 * 1024 * 1024; // Per frame in flight
+
+    VulkanContext(wl_display* display, wl_surface* surface, PresentPath presentPath = PresentPath::Swapchain);
     ~VulkanContext();
 
-    void draw_frame();
+    // False when no present was issued or queued, e.g. the swapchain was out of date; the
+    // caller then commits the surface itself so its frame callback request still goes out
+    bool draw_frame();
     void create_swapchain();
+    void recreate_swapchain();       // Rebuilds size-dependent objects after a resize
     void create_render_pass();       // Moved to public
     void create_framebuffers();      // Moved to public
     void create_command_pool();      // Moved to public
@@ -21,8 +49,35 @@ public:
     void process_wayland_events();   // Move this method to the public section
     wl_display* get_display() const; // Add this method
     wl_surface* get_surface() const; // Add method to retrieve the Wayland surface
+    bool uses_dynamic_rendering() const; // True when the Vulkan 1.3 rendering path is active
+    VkDevice get_device() const;
+    VkPhysicalDevice get_physical_device() const;
+    BindlessHeap* get_bindless_heap() const; // Null when descriptor indexing is unsupported
+    RenderGraph* get_render_graph() const;   // Null on the legacy render pass path
+    GraphicsPipelineCache* get_pipeline_cache() const; // Null on the legacy render pass path
+    FrameRingBuffer* get_frame_ring() const; // Per-draw streaming data for the frame being recorded
+    uint32_t get_frame_slot() const;         // Frame in flight being recorded; indexes per-frame resources
+
+    // Copies every `interval`-th presented frame to `directory` without stalling the GPU
+    void enable_capture(const std::string& directory, CaptureFormat format, uint32_t interval = 1);
+    void disable_capture();
+    FrameCapture* get_frame_capture() const;
+    bool supports_multi_draw_indirect() const;
+    bool supports_draw_indirect_count() const;
+    void set_frame_graph_builder(FrameGraphBuilder builder);
+    // Runs right before the commit that carries each frame, on whichever thread issues it
+    // (the present thread with ENGINE_PRESENT_THREAD); for wp_presentation feedback
+    void set_present_hook(std::function<void()> hook);
+
+    // Destroys the resource once every frame submitted so far has completed on the GPU
+    void defer_destroy(std::function<void()> destroy);
+    void defer_destroy(GpuBuffer& buffer); // Takes ownership and clears the caller's handle
+    uint64_t get_frame_number() const;    // Frames submitted so far
+    uint64_t get_completed_frame() const; // Newest frame whose fence has signalled
+    PresentPath get_present_path() const;
 
     wl_compositor* waylandCompositor; // Ensure this is accessible
+    wl_shm* waylandShm = nullptr;     // Bound for the SHM present path
 
 private:
     void init_instance();
@@ -30,30 +85,80 @@ private:
     void create_logical_device();
     void create_surface(wl_display* display, wl_surface* surface);
     void record_command_buffer(VkCommandBuffer cmdBuffer, uint32_t imageIndex);
+    void record_dynamic_rendering(VkCommandBuffer cmdBuffer, VkImage image, VkImageView view, RGUsage finalUsage);
+    void record_legacy_render_pass(VkCommandBuffer cmdBuffer, uint32_t imageIndex);
+    void destroy_swapchain_resources();
+    void create_present_semaphores();
+    void create_shm_presenter();
+    void begin_frame_slot();
+    bool draw_frame_swapchain();
+    bool draw_frame_async();
+    void submit(const VkSubmitInfo& submitInfo);
+    bool draw_frame_shm();
 
-    VkInstance instance;
+    VkInstance instance = VK_NULL_HANDLE;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    VkDevice device;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t graphicsQueueFamily = 0;
+
+    // Vulkan 1.3 dynamic rendering + synchronization2; falls back to VkRenderPass when unsupported
+    bool dynamicRenderingEnabled = false;
+    bool multiDrawIndirectEnabled = false;
+    bool drawIndirectCountEnabled = false;
+    bool bufferDeviceAddressEnabled = false;
+    bool hostMemoryImportEnabled = false; // VK_EXT_external_memory_host, for zero-copy SHM present
+    bool pipelineLibraryEnabled = false;  // VK_EXT_graphics_pipeline_library
+
+    PresentPath presentPath;
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
 
-    VkSurfaceKHR vkSurface;
+    VkSurfaceKHR vkSurface = VK_NULL_HANDLE;
 
-    VkSwapchainKHR swapchain;
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
     std::vector<VkImage> swapchainImages;
     std::vector<VkImageView> swapchainImageViews;
     VkFormat swapchainImageFormat;
+    VkImageUsageFlags swapchainUsage = 0;
     VkExtent2D swapchainExtent;
 
-    VkRenderPass renderPass;
-    std::vector<VkFramebuffer> framebuffers;
-    std::vector<VkFramebuffer> swapchainFramebuffers; // Add this member
-    VkCommandPool commandPool;
+    VkRenderPass renderPass = VK_NULL_HANDLE;        // Legacy path only
+    std::vector<VkFramebuffer> swapchainFramebuffers; // Legacy path only
+    VkCommandPool commandPool = VK_NULL_HANDLE;
     std::vector<VkCommandBuffer> commandBuffers;
-    std::vector<VkSemaphore> imageAvailableSemaphores;
-    std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
+    std::vector<VkSemaphore> imageAvailableSemaphores; // Per frame in flight
+    std::vector<VkSemaphore> renderFinishedSemaphores; // Per swapchain image
+    std::vector<VkFence> inFlightFences;               // Per frame in flight
+
+    uint32_t currentFrame = 0;
+    uint64_t frameNumber = 0;
+    uint64_t completedFrame = 0;
+    std::vector<uint64_t> frameSubmitted; // Frame number last submitted from each slot
+    DeletionQueue deletionQueue;
+
+    std::unique_ptr<BindlessHeap> bindlessHeap;
+    std::unique_ptr<RenderGraph> frameGraph;
+    std::unique_ptr<FrameRingBuffer> frameRing;
+    std::unique_ptr<FrameCapture> frameCapture;
+    std::unique_ptr<GraphicsPipelineCache> pipelineCache;
+
+    // Optional (ENGINE_PRESENT_THREAD=1): acquire and present run on their own thread
+    std::unique_ptr<PresentThread> presentThread;
+    std::vector<VkSemaphore> slotAcquireSemaphores; // Acquire semaphore each slot's last frame waited on
+    std::mutex queueMutex;                          // graphicsQueue is shared with the present thread
+    FrameGraphBuilder frameGraphBuilder;
+    std::function<void()> presentHook;
+    bool dumpFrameGraph = false;
+
+    std::unique_ptr<ShmRenderer> shmRenderer;
+    std::unique_ptr<ShmPresenter> shmPresenter;
+
+    // CPU time spent in draw_frame, reported at shutdown to compare present paths
+    uint64_t timedFrames = 0;
+    double frameMillisecondsTotal = 0.0;
+    double frameMillisecondsMax = 0.0;
+    double fenceWaitMilliseconds = 0.0;
 
     wl_display* waylandDisplay; // Store Wayland display
     wl_surface* waylandSurface; // Add member to store the Wayland surface
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "core/job_system.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct Aabb {
+    float min[3];
+    float max[3];
+};
+
+struct Ray {
+    float origin[3];
+    float direction[3]; // Need not be normalized; distances are in units of its length
+    float maxDistance;
+};
+
+struct RayHit {
+    uint32_t userData = UINT32_MAX; // UINT32_MAX when nothing was hit
+    float distance = 0.0f;          // Entry distance into the proxy's bounds
+};
+
+// Planes are (n, d) with dot(n, p) + d >= 0 inside, matching gpu_cull.comp
+struct Frustum {
+    float planes[6][4];
+
+    static Frustum from_view_projection(const float viewProjection[16]); // Column-major
+};
+
+// Dynamic AABB tree with four children per node. Child bounds are stored SoA inside each
+// node, so every query tests all four children with one SIMD pass per plane or slab.
+// Proxies carry fattened bounds: small moves stay inside them and cost nothing, larger
+// ones refit the path to the root. Insertions descend greedily by surface area, which
+// lets quality drift as objects move; rebuild() or the asynchronous begin/finish pair
+// replace the tree with a binned-SAH build.
+class DynamicBvh {
+public:
+    static constexpr uint32_t NULL_PROXY = UINT32_MAX;
+
+    explicit DynamicBvh(float margin = 0.1f);
+    ~DynamicBvh();
+
+    DynamicBvh(const DynamicBvh&) = delete;
+    DynamicBvh& operator=(const DynamicBvh&) = delete;
+
+    uint32_t insert(const Aabb& bounds, uint32_t userData);
+    void remove(uint32_t proxy);
+    // True when the bounds left the proxy's fat bounds and the tree was refit
+    bool move(uint32_t proxy, const Aabb& bounds);
+
+    uint32_t get_user_data(uint32_t proxy) const { return proxies[proxy].userData; }
+    const Aabb& get_fat_bounds(uint32_t proxy) const { return proxies[proxy].fat; }
+
+    // Queries append the user data of every proxy whose fat bounds pass the test
+    void query_frustum(const Frustum& frustum, std::vector<uint32_t>& out) const;
+    void query_aabb(const Aabb& bounds, std::vector<uint32_t>& out) const;
+    void query_sphere(const float center[3], float radius, std::vector<uint32_t>& out) const;
+    void query_ray(const Ray& ray, std::vector<uint32_t>& out) const;
+    // Nearest proxy bounds along each ray
+    void raycast(const Ray* rays, size_t count, RayHit* hits) const;
+
+    void rebuild();
+    // Builds from a snapshot of the current bounds on a worker. finish_rebuild() waits
+    // for it and swaps it in, refitting proxies that moved meanwhile; the result is
+    // dropped if proxies were inserted or removed since begin_rebuild().
+    void begin_rebuild(JobSystem& jobs);
+    bool is_rebuild_ready() const;
+    bool finish_rebuild();
+
+    // Summed surface area of every node relative to the root; grows as the tree degrades
+    float get_sah_cost() const;
+    size_t get_proxy_count() const { return proxyCount; }
+    size_t get_node_count() const { return nodes.size() - freeNodes.size(); }
+
+private:
+    static constexpr uint32_t NULL_NODE = UINT32_MAX;
+    static constexpr uint32_t PROXY_BIT = 0x80000000u; // Child is a proxy rather than a node
+
+    struct alignas(64) Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        uint32_t child[4];
+        uint32_t parent;
+        uint32_t parentSlot;
+        uint32_t count; // Children are packed into the first `count` slots
+    };
+
+    struct Proxy {
+        Aabb fat;
+        uint32_t userData;
+        uint32_t node = NULL_NODE; // NULL_NODE while on the free list
+        uint32_t slot;
+        uint32_t nextFree = NULL_PROXY;
+    };
+
+    struct BuildItem {
+        Aabb bounds;
+        float centroid[3];
+        uint32_t proxy;
+    };
+
+    struct PendingRebuild {
+        JobSystem* jobs;
+        JobCounter counter;
+        uint64_t structureVersion;
+        std::vector<BuildItem> items;
+        std::vector<Node> nodes;
+    };
+
+    uint32_t allocate_node(uint32_t parent, uint32_t parentSlot);
+    void free_node(uint32_t node);
+    void set_child(uint32_t node, uint32_t slot, uint32_t child, const Aabb& bounds);
+    void remove_child(uint32_t node, uint32_t slot);
+    Aabb node_bounds(uint32_t node) const;
+    void refit_upward(uint32_t node);
+    void collapse_upward(uint32_t node);
+    // Emits proxies in lanes of `test(node)`'s mask and descends into nodes in them
+    template <typename Test>
+    void traverse(Test&& test, std::vector<uint32_t>& out) const;
+    std::vector<BuildItem> gather_build_items() const;
+    void install(std::vector<Node>& built);
+
+    static void build(std::vector<BuildItem>& items, std::vector<Node>& built);
+    static uint32_t build_node(std::vector<Node>& built, BuildItem* items, uint32_t count, uint32_t parent,
+                               uint32_t parentSlot);
+    static uint32_t split_sah(BuildItem* items, uint32_t count);
+
+    float margin;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    uint32_t root = NULL_NODE;
+    std::vector<Proxy> proxies;
+    uint32_t freeProxy = NULL_PROXY;
+    size_t proxyCount = 0;
+    uint64_t structureVersion = 0; // Bumped by insert and remove
+    std::unique_ptr<PendingRebuild> pending;
+};
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "core/job_system.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Archetype ECS. Every distinct set of component types is an archetype; its entities
+// live in 16 KB chunks that hold one tightly packed array per component (SoA), so a
+// system touching two components streams exactly those two arrays. Components must be
+// trivially copyable: moving an entity between archetypes or chunks is a memcpy.
+
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+
+constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+constexpr size_t ECS_CHUNK_BYTES = 16 * 1024;
+
+// Index plus generation; a destroyed entity's index is reused with a new generation,
+// so stale handles are detected instead of aliasing the new entity
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+struct ComponentInfo {
+    uint32_t size;
+    uint32_t alignment;
+};
+
+class ComponentRegistry {
+public:
+    template <typename T>
+    static ComponentId id() {
+        using Component = std::remove_cv_t<std::remove_reference_t<T>>;
+        static_assert(std::is_trivially_copyable<Component>::value, "ECS components must be trivially copyable");
+        static const ComponentId componentId = register_component(sizeof(Component), alignof(Component));
+        return componentId;
+    }
+
+    template <typename... Ts>
+    static ComponentMask mask() {
+        return (ComponentMask(0) | ... | (ComponentMask(1) << id<Ts>()));
+    }
+
+    static const ComponentInfo& info(ComponentId id);
+
+private:
+    static ComponentId register_component(uint32_t size, uint32_t alignment);
+};
+
+struct alignas(64) ArchetypeChunk {
+    uint8_t data[ECS_CHUNK_BYTES];
+    uint32_t count = 0;
+};
+
+class Archetype {
+public:
+    explicit Archetype(ComponentMask mask);
+
+    ComponentMask get_mask() const { return mask; }
+    uint32_t get_capacity() const { return capacity; } // Entities per chunk
+    uint32_t get_entity_count() const { return entityCount; }
+    size_t get_chunk_count() const { return (entityCount + capacity - 1) / capacity; }
+    ArchetypeChunk* get_chunk(size_t index) const { return chunks[index].get(); }
+
+    // Column of `component` in this archetype's chunks, or -1
+    int column_of(ComponentId component) const { return columns[component]; }
+    uint8_t* column_data(ArchetypeChunk* chunk, int column) const { return chunk->data + offsets[column]; }
+    Entity* entities(ArchetypeChunk* chunk) const { return reinterpret_cast<Entity*>(chunk->data); }
+
+private:
+    friend class World;
+
+    ComponentMask mask;
+    std::vector<ComponentId> components;
+    std::array<int8_t, MAX_COMPONENT_TYPES> columns;
+    std::vector<uint32_t> offsets; // Per column, from the chunk start; entity handles sit at 0
+    std::vector<uint32_t> sizes;
+    uint32_t capacity = 0;
+    uint32_t entityCount = 0;
+    std::vector<std::unique_ptr<ArchetypeChunk>> chunks; // Only the last one is partly filled
+
+    // Archetype graph: where adding or removing one component leads, filled lazily
+    std::array<Archetype*, MAX_COMPONENT_TYPES> addEdges{};
+    std::array<Archetype*, MAX_COMPONENT_TYPES> removeEdges{};
+};
+
+// One chunk as seen by a system: `count` entities, each component as a plain array
+class ChunkView {
+public:
+    ChunkView(const Archetype& archetype, ArchetypeChunk* chunk) : archetype(archetype), chunk(chunk) {}
+
+    uint32_t count() const { return chunk->count; }
+    const Entity* entities() const { return archetype.entities(chunk); }
+
+    // Null when the archetype lacks T
+    template <typename T>
+    T* get() const {
+        int column = archetype.column_of(ComponentRegistry::id<T>());
+        return column < 0 ? nullptr : reinterpret_cast<T*>(archetype.column_data(chunk, column));
+    }
+
+private:
+    const Archetype& archetype;
+    ArchetypeChunk* chunk;
+};
+
+class World;
+
+// Cached query: the set of archetypes that have every required component and none of
+// the excluded ones. New matching archetypes are appended as the world creates them,
+// so iterating never re-scans the archetype list.
+class EntityQuery {
+public:
+    EntityQuery(ComponentMask required, ComponentMask excluded) : required(required), excluded(excluded) {}
+
+    bool matches(ComponentMask mask) const { return (mask & required) == required && (mask & excluded) == 0; }
+    size_t count() const;
+
+    template <typename Fn>
+    void each_chunk(Fn&& fn) const;
+
+    // fn(Ts&...) per entity
+    template <typename... Ts, typename Fn>
+    void each(Fn&& fn) const;
+
+    // Chunks are spread over the job system; fn must only write the chunk it is given and
+    // defer structural changes to an EntityCommandBuffer
+    template <typename Fn>
+    void par_each_chunk(JobSystem& jobs, Fn&& fn) const;
+
+    template <typename... Ts, typename Fn>
+    void par_each(JobSystem& jobs, Fn&& fn) const;
+
+private:
+    friend class World;
+
+    ComponentMask required;
+    ComponentMask excluded;
+    std::vector<Archetype*> archetypes;
+    World* world = nullptr;
+};
+
+// Structural changes recorded while systems iterate and applied later with
+// World::apply(). Recording is thread-safe, so parallel systems may share one buffer.
+class EntityCommandBuffer {
+public:
+    // Stand-in for an entity created at apply time; usable with add() in the same buffer
+    struct PendingEntity {
+        uint32_t index;
+    };
+
+    PendingEntity create();
+    void destroy(Entity entity);
+
+    template <typename T>
+    void add(Entity entity, const T& value) {
+        record(Op::Add, entity.index, entity.generation, ComponentRegistry::id<T>(), &value, sizeof(T));
+    }
+    template <typename T>
+    void add(PendingEntity entity, const T& value) {
+        record(Op::AddPending, entity.index, 0, ComponentRegistry::id<T>(), &value, sizeof(T));
+    }
+    template <typename T>
+    void remove(Entity entity) {
+        record(Op::Remove, entity.index, entity.generation, ComponentRegistry::id<T>(), nullptr, 0);
+    }
+
+    bool empty() const { return bytes.empty(); }
+    void clear();
+
+private:
+    friend class World;
+
+    enum class Op : uint32_t { Create, Destroy, Add, AddPending, Remove };
+
+    struct Header {
+        Op op;
+        uint32_t index;      // Entity index, or pending index
+        uint32_t generation;
+        ComponentId component;
+        uint32_t size;       // Payload bytes following the header
+    };
+
+    void record(Op op, uint32_t index, uint32_t generation, ComponentId component, const void* payload,
+                uint32_t size);
+
+    std::mutex mutex;
+    std::vector<uint8_t> bytes;
+    uint32_t pendingCount = 0;
+};
+
+class World {
+public:
+    World() = default;
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    template <typename... Ts>
+    Entity create(const Ts&... components) {
+        Entity entity = allocate_entity();
+        Archetype* archetype = get_archetype(ComponentRegistry::mask<Ts...>());
+        place(entity, archetype);
+        (write_component(entity, ComponentRegistry::id<Ts>(), &components), ...);
+        return entity;
+    }
+    void destroy(Entity entity);
+    bool is_alive(Entity entity) const;
+
+    template <typename T>
+    void add(Entity entity, const T& value) {
+        add_component(entity, ComponentRegistry::id<T>(), &value);
+    }
+    template <typename T>
+    void remove(Entity entity) {
+        remove_component(entity, ComponentRegistry::id<T>());
+    }
+    template <typename T>
+    bool has(Entity entity) const {
+        return is_alive(entity) && (records[entity.index].archetype->get_mask() & ComponentRegistry::mask<T>());
+    }
+    // Null when the entity is dead or lacks T. Invalidated by structural changes.
+    template <typename T>
+    T* get(Entity entity) {
+        return static_cast<T*>(component_pointer(entity, ComponentRegistry::id<T>()));
+    }
+
+    // Cached per component set; the reference stays valid for the world's lifetime
+    template <typename... Ts>
+    EntityQuery& query() {
+        return get_query(ComponentRegistry::mask<Ts...>(), 0);
+    }
+    EntityQuery& get_query(ComponentMask required, ComponentMask excluded);
+
+    template <typename... Ts, typename Fn>
+    void each(Fn&& fn) {
+        query<Ts...>().template each<Ts...>(std::forward<Fn>(fn));
+    }
+
+    void apply(EntityCommandBuffer& commands); // Replays and clears the buffer
+
+    size_t get_entity_count() const { return records.size() - freeIndices.size(); }
+    size_t get_archetype_count() const { return archetypes.size(); }
+
+private:
+    friend class EntityQuery;
+
+    struct EntityRecord {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    // Marks iteration so structural changes can be rejected while chunks are in use
+    struct IterationScope {
+        explicit IterationScope(const World* world) : world(const_cast<World*>(world)) { this->world->iterating++; }
+        ~IterationScope() { world->iterating--; }
+        World* world;
+    };
+
+    Entity allocate_entity();
+    Archetype* get_archetype(ComponentMask mask);
+    Archetype* archetype_with(Archetype* from, ComponentId component);
+    Archetype* archetype_without(Archetype* from, ComponentId component);
+    void place(Entity entity, Archetype* archetype);
+    void move_entity(Entity entity, Archetype* to);
+    void remove_row(Archetype* archetype, uint32_t chunk, uint32_t row);
+    void write_component(Entity entity, ComponentId component, const void* value);
+    void add_component(Entity entity, ComponentId component, const void* value);
+    void remove_component(Entity entity, ComponentId component);
+    void* component_pointer(Entity entity, ComponentId component);
+    void check_structural_change() const;
+    std::unique_ptr<ArchetypeChunk> take_chunk();
+
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndices;
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, std::unique_ptr<EntityQuery>> queries; // Keyed by required mask
+    std::vector<std::unique_ptr<EntityQuery>> excludingQueries;
+    std::vector<std::unique_ptr<ArchetypeChunk>> freeChunks; // Recycled when an archetype shrinks
+    std::atomic<int> iterating{0};
+};
+
+template <typename Fn>
+void EntityQuery::each_chunk(Fn&& fn) const {
+    World::IterationScope scope(world);
+    for (Archetype* archetype : archetypes) {
+        size_t chunkCount = archetype->get_chunk_count();
+        for (size_t i = 0; i < chunkCount; i++) {
+            ChunkView view(*archetype, archetype->get_chunk(i));
+            fn(view);
+        }
+    }
+}
+
+template <typename... Ts, typename Fn>
+void EntityQuery::each(Fn&& fn) const {
+    each_chunk([&fn](ChunkView& view) {
+        auto columns = std::make_tuple(view.get<Ts>()...);
+        uint32_t count = view.count();
+        for (uint32_t i = 0; i < count; i++) {
+            fn(std::get<Ts*>(columns)[i]...);
+        }
+    });
+}
+
+template <typename Fn>
+void EntityQuery::par_each_chunk(JobSystem& jobs, Fn&& fn) const {
+    World::IterationScope scope(world);
+    std::vector<ChunkView> views;
+    for (Archetype* archetype : archetypes) {
+        size_t chunkCount = archetype->get_chunk_count();
+        for (size_t i = 0; i < chunkCount; i++) {
+            views.emplace_back(*archetype, archetype->get_chunk(i));
+        }
+    }
+    jobs.parallel_for(0, static_cast<uint32_t>(views.size()), [&views, &fn](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            fn(views[i]);
+        }
+    });
+}
+
+template <typename... Ts, typename Fn>
+void EntityQuery::par_each(JobSystem& jobs, Fn&& fn) const {
+    par_each_chunk(jobs, [&fn](ChunkView& view) {
+        auto columns = std::make_tuple(view.get<Ts>()...);
+        uint32_t count = view.count();
+        for (uint32_t i = 0; i < count; i++) {
+            fn(std::get<Ts*>(columns)[i]...);
+        }
+    });
+}
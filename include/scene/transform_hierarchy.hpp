@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+struct GpuInstance;
+
+struct Transform {
+    float translation[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // Unit quaternion, xyzw
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+};
+
+struct alignas(16) Matrix4 {
+    float m[16]; // Column-major
+};
+
+// Scene graph transforms stored breadth-first: nodes are sorted by depth, so every
+// parent precedes its children and each depth level is one contiguous range. Local
+// transforms are SoA arrays; update() walks the levels in order, propagates dirty
+// flags from parent to child, and recomputes only dirty nodes, four per SIMD pass.
+// Levels large enough to be worth it are split across the job system.
+class TransformHierarchy {
+public:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    explicit TransformHierarchy(size_t reserveNodes = 0);
+
+    // Handles stay valid when the breadth-first layout is rebuilt; the parent must exist
+    uint32_t create(uint32_t parent = NO_NODE, const Transform& local = Transform());
+    void set_local(uint32_t node, const Transform& local);
+    Transform get_local(uint32_t node) const;
+    uint32_t get_parent(uint32_t node) const;
+
+    // Every update writes the node's world matrix straight into instances[instance].model
+    void bind_instance(uint32_t node, uint32_t instance);
+
+    // Instance arrays used in rotation, one per frame in flight (at most 8). Each update()
+    // names the one it writes and also copies in the matrices it missed while the others
+    // were written, so only changed matrices are ever stored.
+    void set_instance_buffer_count(uint32_t count);
+    // Every bound matrix is rewritten into each array on its next update, e.g. after
+    // GpuDrivenRenderer::set_instances() re-uploaded the instances
+    void invalidate_instances();
+
+    // As of the last update()
+    const Matrix4& get_world(uint32_t node) const { return world[slotOf[node]]; }
+
+    // `instances` is normally GpuDrivenRenderer::map_instances() for the frame being
+    // recorded, with `buffer` its frame slot. Without `jobs` every level runs on the
+    // calling thread.
+    void update(JobSystem* jobs = nullptr, GpuInstance* instances = nullptr, uint32_t buffer = 0);
+
+    size_t size() const { return nodeAt.size(); }
+    uint32_t get_level_count() const { return static_cast<uint32_t>(levelStart.size() - 1); }
+    size_t get_last_update_count() const { return lastUpdateCount.load(); } // Nodes recomputed
+
+private:
+    void rebuild_layout();
+    void catch_up(GpuInstance* instances, uint8_t bufferBit);
+    void update_range(uint32_t begin, uint32_t end, GpuInstance* instances);
+    void compute_four(uint32_t slot, GpuInstance* instances);
+    void compute_one(uint32_t slot, GpuInstance* instances);
+    void write_local(uint32_t slot, const Transform& local);
+
+    // Indexed by slot, the node's position in breadth-first order
+    std::vector<uint32_t> parentSlot;
+    std::vector<float> tx, ty, tz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+    std::vector<uint32_t> instance;
+    std::vector<uint32_t> depth;
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> stale; // Bit per instance array still holding an older matrix
+    std::vector<Matrix4> world;
+    std::vector<uint32_t> nodeAt;
+
+    std::vector<uint32_t> slotOf;     // Indexed by handle
+    std::vector<uint32_t> levelStart; // Slot ranges per depth, plus one end marker
+    bool layoutDirty = false;         // Nodes appended since the last sort
+    bool anyDirty = false;
+    uint32_t instanceBufferCount = 1;
+    uint8_t staleBuffers = 0;     // Arrays with any stale matrix
+    uint8_t staleAfterWrite = 0;  // Arrays the matrices computed by this update still miss
+    std::atomic<size_t> lastUpdateCount{0};
+};
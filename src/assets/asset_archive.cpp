@@ -0,0 +1,232 @@
+#include "assets/asset_archive.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef ENGINE_HAVE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef ENGINE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+constexpr uint64_t FNV_OFFSET = 1469598103934665603ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+constexpr int ZSTD_PACK_LEVEL = 19; // Packing is offline; decode speed barely depends on it
+
+[[noreturn]] void corrupt(const std::string& path) {
+    throw std::runtime_error("Asset archive " + path + " is truncated or corrupt!");
+}
+}
+
+AssetArchive::AssetArchive(const std::string& path) {
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open asset archive " + path + "!");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ArchiveHeader)) {
+        close(fd);
+        corrupt(path);
+    }
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map asset archive " + path + "!");
+    }
+    base = static_cast<const uint8_t*>(mapping);
+
+    header = reinterpret_cast<const ArchiveHeader*>(base);
+    uint64_t indexSize = static_cast<uint64_t>(header->entryCount) * sizeof(ArchiveEntry);
+    bool valid = std::memcmp(header->magic, "APAK", 4) == 0 && header->fileSize == size &&
+                 header->indexOffset == sizeof(ArchiveHeader) + FANOUT_SIZE * sizeof(uint32_t) &&
+                 header->namesOffset == header->indexOffset + indexSize && header->namesSize > 0 &&
+                 header->namesOffset + header->namesSize <= size && base[header->namesOffset + header->namesSize - 1] == 0;
+    if (!valid || header->version != VERSION) {
+        munmap(mapping, size);
+        close(fd);
+        if (valid) {
+            throw std::runtime_error("Asset archive " + path + " has an unsupported version!");
+        }
+        corrupt(path);
+    }
+    fanout = reinterpret_cast<const uint32_t*>(base + sizeof(ArchiveHeader));
+    entries = reinterpret_cast<const ArchiveEntry*>(base + header->indexOffset);
+    names = reinterpret_cast<const char*>(base + header->namesOffset);
+    // Lookups hop around the index, so only it skips readahead; blobs are read front to
+    // back once found and keep the default. The whole index is wanted soon anyway.
+    size_t metadataSize = header->namesOffset + header->namesSize;
+    madvise(mapping, metadataSize, MADV_RANDOM);
+    madvise(mapping, metadataSize, MADV_WILLNEED);
+}
+
+AssetArchive::~AssetArchive() {
+    munmap(const_cast<uint8_t*>(base), size);
+    close(fd);
+}
+
+const ArchiveEntry* AssetArchive::find(std::string_view path) const {
+    uint64_t hash = hash_path(path);
+    uint32_t bucket = static_cast<uint32_t>(hash >> 56);
+    uint32_t high = std::min(fanout[bucket], header->entryCount);
+    uint32_t low = bucket > 0 ? std::min(fanout[bucket - 1], high) : 0;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (entries[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low >= header->entryCount || entries[low].hash != hash) {
+        return nullptr;
+    }
+    // The packer rejects colliding hashes, so the name only guards against foreign paths
+    const ArchiveEntry& entry = entries[low];
+    if (entry.nameOffset >= header->namesSize || path != std::string_view(get_name(entry))) {
+        return nullptr;
+    }
+    if (entry.offset > size || entry.storedSize > size - entry.offset) {
+        throw std::runtime_error("Asset archive entry " + std::string(path) + " lies outside the file!");
+    }
+    return &entry;
+}
+
+const uint8_t* AssetArchive::get_in_place(const ArchiveEntry& entry) const {
+    return entry.compression == static_cast<uint8_t>(AssetCompression::None) ? base + entry.offset : nullptr;
+}
+
+void AssetArchive::extract(const ArchiveEntry& entry, void* destination) const {
+    const uint8_t* stored = base + entry.offset;
+    switch (static_cast<AssetCompression>(entry.compression)) {
+    case AssetCompression::None:
+        std::memcpy(destination, stored, entry.size);
+        return;
+    case AssetCompression::Lz4:
+#ifdef ENGINE_HAVE_LZ4
+        if (LZ4_decompress_safe(reinterpret_cast<const char*>(stored), static_cast<char*>(destination),
+                                static_cast<int>(entry.storedSize), static_cast<int>(entry.size)) !=
+            static_cast<int>(entry.size)) {
+            throw std::runtime_error(std::string("Failed to decompress ") + get_name(entry) + "!");
+        }
+        return;
+#else
+        break;
+#endif
+    case AssetCompression::Zstd:
+#ifdef ENGINE_HAVE_ZSTD
+        if (ZSTD_decompress(destination, entry.size, stored, entry.storedSize) != entry.size) {
+            throw std::runtime_error(std::string("Failed to decompress ") + get_name(entry) + "!");
+        }
+        return;
+#else
+        break;
+#endif
+    }
+    throw std::runtime_error(std::string("No decoder for the compression of ") + get_name(entry) + "!");
+}
+
+bool AssetArchive::verify(const ArchiveEntry& entry) const {
+    return checksum(base + entry.offset, entry.storedSize) == entry.checksum;
+}
+
+uint64_t AssetArchive::hash_path(std::string_view path) {
+    uint64_t hash = FNV_OFFSET;
+    for (char c : path) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// CRC-32 (IEEE), sliced by 8 so verifying large blobs keeps up with the disk
+uint32_t AssetArchive::checksum(const void* data, size_t length) {
+    static const std::array<std::array<uint32_t, 256>, 8> tables = [] {
+        std::array<std::array<uint32_t, 256>, 8> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; ++n) {
+            for (int slice = 1; slice < 8; ++slice) {
+                t[slice][n] = t[0][t[slice - 1][n] & 0xff] ^ (t[slice - 1][n] >> 8);
+            }
+        }
+        return t;
+    }();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t crc = ~0u;
+    for (; length >= 8; bytes += 8, length -= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, bytes, 4);
+        std::memcpy(&high, bytes + 4, 4);
+        low ^= crc;
+        crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^
+              tables[4][low >> 24] ^ tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^
+              tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+    }
+    for (; length > 0; bytes++, length--) {
+        crc = tables[0][(crc ^ *bytes) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool AssetArchive::supports(AssetCompression compression) {
+    switch (compression) {
+    case AssetCompression::None:
+        return true;
+    case AssetCompression::Lz4:
+#ifdef ENGINE_HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    case AssetCompression::Zstd:
+#ifdef ENGINE_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::vector<uint8_t> AssetArchive::compress(AssetCompression compression, const void* data, size_t length) {
+    std::vector<uint8_t> out;
+    switch (compression) {
+    case AssetCompression::None:
+        out.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + length);
+        break;
+    case AssetCompression::Lz4:
+#ifdef ENGINE_HAVE_LZ4
+        if (length <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+            out.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(length))));
+            int written = LZ4_compress_HC(static_cast<const char*>(data), reinterpret_cast<char*>(out.data()),
+                                          static_cast<int>(length), static_cast<int>(out.size()), LZ4HC_CLEVEL_MAX);
+            out.resize(written > 0 ? static_cast<size_t>(written) : 0);
+        }
+#endif
+        break;
+    case AssetCompression::Zstd:
+#ifdef ENGINE_HAVE_ZSTD
+    {
+        out.resize(ZSTD_compressBound(length));
+        size_t written = ZSTD_compress(out.data(), out.size(), data, length, ZSTD_PACK_LEVEL);
+        out.resize(ZSTD_isError(written) ? 0 : written);
+    }
+#endif
+        break;
+    }
+    return out;
+}
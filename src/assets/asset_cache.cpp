@@ -0,0 +1,342 @@
+#include "assets/asset_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+AssetCache::AssetCache(JobSystem& jobs, AsyncIO& io, const AssetArchive* archive)
+    : jobs(jobs), io(io), archive(archive) {}
+
+AssetCache::~AssetCache() {
+    while (loadsInFlight.load(std::memory_order_acquire) > 0) {
+        io.wait_idle();
+        jobs.wait(decodeJobs);
+    }
+    jobs.wait(decodeJobs);
+
+    // Whatever is still referenced at shutdown goes too
+    for (uint32_t index = 0; index < slotCount; index++) {
+        Slot& slot = slot_at(index);
+        void* object = slot.object.load(std::memory_order_relaxed);
+        if (object) {
+            types[slot.type].destroy(object);
+        }
+    }
+    for (std::atomic<Slot*>& block : blocks) {
+        delete[] block.load(std::memory_order_relaxed);
+    }
+}
+
+AssetTypeId AssetCache::next_type_id() {
+    static std::atomic<AssetTypeId> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AssetCache::register_type_erased(AssetTypeId type, const AssetBudget& budget, ErasedDecoder decode,
+                                      void (*destroy)(void*)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (type >= types.size()) {
+        types.resize(type + 1);
+    }
+    TypeInfo& info = types[type];
+    if (info.registered) {
+        throw std::runtime_error("Asset type registered twice!");
+    }
+    info.registered = true;
+    info.decode = std::move(decode);
+    info.destroy = destroy;
+    info.budget = budget;
+    info.stats.budget = budget;
+}
+
+void AssetCache::set_budget(AssetTypeId type, const AssetBudget& budget) {
+    std::vector<Victim> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (type >= types.size() || !types[type].registered) {
+            throw std::runtime_error("Asset type is not registered!");
+        }
+        types[type].budget = budget;
+        types[type].stats.budget = budget;
+        evict_over_budget(type, victims);
+    }
+    destroy_victims(victims);
+}
+
+void AssetCache::acquire(AssetTypeId type, const std::string& path, uint32_t& index, uint32_t& generation) {
+    ErasedDecoder decoder;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (type >= types.size() || !types[type].registered) {
+            throw std::runtime_error("Asset type is not registered!");
+        }
+        auto found = slotByPath.find(path);
+        if (found != slotByPath.end()) {
+            Slot& slot = slot_at(found->second);
+            if (slot.type != type) {
+                throw std::runtime_error("Asset " + path + " was already loaded as another type!");
+            }
+            // Revived from the LRU list, or shared with a load still in flight
+            if (slot.references.fetch_add(1, std::memory_order_relaxed) == 0 && slot.inLru) {
+                lru_unlink(slot);
+            }
+            types[type].stats.sharedLoads++;
+            index = found->second;
+            generation = slot.generation.load(std::memory_order_relaxed);
+            return;
+        }
+
+        index = allocate_slot();
+        Slot& slot = slot_at(index);
+        slot.type = type;
+        slot.usage = AssetUsage{};
+        slot.path = path;
+        slot.resident = false;
+        slot.references.store(1, std::memory_order_relaxed);
+        slot.state.store(AssetState::Loading, std::memory_order_release);
+        generation = slot.generation.load(std::memory_order_relaxed);
+        slotByPath.emplace(path, index);
+        decoder = types[type].decode;
+    }
+    start_load(index, std::move(decoder), path);
+}
+
+void AssetCache::release(uint32_t index, uint32_t generation) {
+    Slot* slot = const_cast<Slot*>(find_slot(index, generation));
+    if (!slot) {
+        return;
+    }
+    // Only the last reference needs the lock; dropping it under the lock keeps load() and
+    // finish_load() from seeing the count at zero before the slot has been filed
+    uint32_t references = slot->references.load(std::memory_order_relaxed);
+    while (references > 1) {
+        if (slot->references.compare_exchange_weak(references, references - 1, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+    std::vector<Victim> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (slot->generation.load(std::memory_order_relaxed) != generation ||
+            slot->references.load(std::memory_order_relaxed) == 0 ||
+            slot->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        AssetState state = slot->state.load(std::memory_order_relaxed);
+        if (state == AssetState::Failed) {
+            evict(index, victims); // Nothing to keep; a later load retries
+        } else if (state == AssetState::Ready) {
+            lru_link(*slot, index);
+            evict_over_budget(slot->type, victims);
+        }
+        // Still loading: finish_load() files it
+    }
+    destroy_victims(victims);
+}
+
+AssetCache::TypeStats AssetCache::get_stats(AssetTypeId type) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return type < types.size() ? types[type].stats : TypeStats{};
+}
+
+void AssetCache::evict_unreferenced() {
+    std::vector<Victim> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (TypeInfo& info : types) {
+            while (info.lruHead != NO_SLOT) {
+                evict(info.lruHead, victims);
+            }
+        }
+    }
+    destroy_victims(victims);
+}
+
+const AssetCache::Slot* AssetCache::find_slot(uint32_t index, uint32_t generation) const {
+    if (index / SLOTS_PER_BLOCK >= MAX_BLOCKS) {
+        return nullptr;
+    }
+    const Slot* block = blocks[index / SLOTS_PER_BLOCK].load(std::memory_order_acquire);
+    if (!block) {
+        return nullptr;
+    }
+    const Slot& slot = block[index % SLOTS_PER_BLOCK];
+    return slot.generation.load(std::memory_order_acquire) == generation ? &slot : nullptr;
+}
+
+uint32_t AssetCache::allocate_slot() {
+    if (!freeSlots.empty()) {
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+        return index;
+    }
+    if (slotCount == SLOTS_PER_BLOCK * MAX_BLOCKS) {
+        throw std::runtime_error("Asset cache is out of slots!");
+    }
+    if (slotCount % SLOTS_PER_BLOCK == 0) {
+        blocks[slotCount / SLOTS_PER_BLOCK].store(new Slot[SLOTS_PER_BLOCK], std::memory_order_release);
+    }
+    return slotCount++;
+}
+
+void AssetCache::start_load(uint32_t index, ErasedDecoder decoder, const std::string& path) {
+    loadsInFlight.fetch_add(1, std::memory_order_relaxed);
+    const ArchiveEntry* entry = nullptr;
+    try {
+        entry = archive ? archive->find(path) : nullptr;
+    } catch (const std::exception& error) {
+        // A corrupt entry fails this load instead of leaving it loading forever
+        std::cout << "[AssetCache] " << error.what() << std::endl;
+        finish_load(index, nullptr, AssetUsage{});
+        return;
+    }
+    if (entry) {
+        jobs.run(
+            [this, index, entry, decoder = std::move(decoder)] {
+                const uint8_t* bytes = archive->get_in_place(*entry);
+                std::unique_ptr<uint8_t[]> extracted;
+                if (!bytes) {
+                    try {
+                        extracted.reset(new uint8_t[std::max<uint64_t>(entry->size, 1)]);
+                        archive->extract(*entry, extracted.get());
+                    } catch (const std::exception& error) {
+                        std::cout << "[AssetCache] " << error.what() << std::endl;
+                        finish_load(index, nullptr, AssetUsage{});
+                        return;
+                    }
+                    bytes = extracted.get();
+                }
+                decode(index, decoder, bytes, entry->size);
+            },
+            &decodeJobs);
+        return;
+    }
+    io.read_file(path, [this, index, decoder = std::move(decoder)](AsyncIO::Result& result) {
+        if (result.error != 0) {
+            std::cout << "[AssetCache] Failed to read " << result.path << ": " << std::strerror(result.error)
+                      << std::endl;
+            finish_load(index, nullptr, AssetUsage{});
+            return;
+        }
+        decode(index, decoder, result.bytes, result.size);
+    });
+}
+
+void AssetCache::decode(uint32_t index, const ErasedDecoder& decoder, const uint8_t* bytes, size_t size) {
+    AssetUsage usage;
+    void* object = nullptr;
+    try {
+        object = decoder(bytes, size, usage);
+    } catch (const std::exception& error) {
+        std::cout << "[AssetCache] Failed to decode: " << error.what() << std::endl;
+    }
+    finish_load(index, object, usage);
+}
+
+void AssetCache::finish_load(uint32_t index, void* object, const AssetUsage& usage) {
+    std::vector<Victim> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& slot = slot_at(index);
+        TypeInfo& info = types[slot.type];
+        if (object) {
+            slot.usage = usage;
+            slot.resident = true;
+            slot.object.store(object, std::memory_order_release);
+            slot.state.store(AssetState::Ready, std::memory_order_release);
+            info.stats.usage.cpuBytes += usage.cpuBytes;
+            info.stats.usage.gpuBytes += usage.gpuBytes;
+            info.stats.resident++;
+            info.stats.loads++;
+        } else {
+            slot.state.store(AssetState::Failed, std::memory_order_release);
+            info.stats.failures++;
+        }
+
+        // Everyone let go while it loaded
+        if (slot.references.load(std::memory_order_relaxed) == 0) {
+            if (object) {
+                lru_link(slot, index);
+            } else {
+                evict(index, victims);
+            }
+        }
+        evict_over_budget(slot.type, victims);
+    }
+    destroy_victims(victims);
+    loadsInFlight.fetch_sub(1, std::memory_order_release);
+}
+
+void AssetCache::lru_link(Slot& slot, uint32_t index) {
+    if (slot.inLru) {
+        return;
+    }
+    TypeInfo& info = types[slot.type];
+    slot.lruPrev = info.lruTail;
+    slot.lruNext = NO_SLOT;
+    if (info.lruTail != NO_SLOT) {
+        slot_at(info.lruTail).lruNext = index;
+    } else {
+        info.lruHead = index;
+    }
+    info.lruTail = index;
+    slot.inLru = true;
+    info.stats.unreferenced++;
+}
+
+void AssetCache::lru_unlink(Slot& slot) {
+    TypeInfo& info = types[slot.type];
+    if (slot.lruPrev != NO_SLOT) {
+        slot_at(slot.lruPrev).lruNext = slot.lruNext;
+    } else {
+        info.lruHead = slot.lruNext;
+    }
+    if (slot.lruNext != NO_SLOT) {
+        slot_at(slot.lruNext).lruPrev = slot.lruPrev;
+    } else {
+        info.lruTail = slot.lruPrev;
+    }
+    slot.lruPrev = slot.lruNext = NO_SLOT;
+    slot.inLru = false;
+    info.stats.unreferenced--;
+}
+
+void AssetCache::evict(uint32_t index, std::vector<Victim>& victims) {
+    Slot& slot = slot_at(index);
+    TypeInfo& info = types[slot.type];
+    if (slot.inLru) {
+        lru_unlink(slot);
+    }
+    slotByPath.erase(slot.path);
+    slot.path.clear();
+    if (slot.resident) {
+        info.stats.usage.cpuBytes -= slot.usage.cpuBytes;
+        info.stats.usage.gpuBytes -= slot.usage.gpuBytes;
+        info.stats.resident--;
+        info.stats.evictions++;
+        slot.resident = false;
+    }
+    void* object = slot.object.exchange(nullptr, std::memory_order_acq_rel);
+    if (object) {
+        victims.push_back(Victim{object, info.destroy});
+    }
+    // Stale handles stop resolving before the slot is reused
+    slot.generation.fetch_add(1, std::memory_order_release);
+    slot.state.store(AssetState::Failed, std::memory_order_release);
+    freeSlots.push_back(index);
+}
+
+void AssetCache::evict_over_budget(AssetTypeId type, std::vector<Victim>& victims) {
+    TypeInfo& info = types[type];
+    while (info.lruHead != NO_SLOT && (info.stats.usage.cpuBytes > info.budget.cpuBytes ||
+                                       info.stats.usage.gpuBytes > info.budget.gpuBytes)) {
+        evict(info.lruHead, victims);
+    }
+}
+
+void AssetCache::destroy_victims(std::vector<Victim>& victims) {
+    for (const Victim& victim : victims) {
+        victim.destroy(victim.object);
+    }
+    victims.clear();
+}
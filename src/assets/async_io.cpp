@@ -0,0 +1,634 @@
+#include "assets/async_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t DIRECT_ALIGNMENT = 4096;
+constexpr uint64_t WAKE_TAG = 0;  // user_data of the eventfd read
+constexpr uint64_t CLOSE_TAG = 1; // user_data of closes nobody waits for
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+} // namespace
+
+struct IoRequest {
+    enum class Kind { File, Range, Direct };
+    enum class Stage { Open, Stat, Read };
+
+    Kind kind;
+    Stage stage;
+    int fd = -1;
+    uint64_t offset = 0;    // File offset of the first byte read
+    uint64_t length = 0;    // Bytes to read from `offset`
+    uint64_t done = 0;
+    uint8_t* target = nullptr;
+    uint64_t skip = 0;      // Direct reads: bytes before the requested range
+    uint64_t requested = 0; // Direct reads: the caller's size
+    struct statx stat;
+    AsyncIO::Completion completion;
+    AsyncIO::Result result;
+};
+
+AsyncIO::AsyncIO(JobSystem& jobs, const AsyncIOConfig& config) : jobs(jobs), config(config) {
+    if (this->config.bufferSize % DIRECT_ALIGNMENT != 0) {
+        throw std::runtime_error("Async I/O buffer size must be a multiple of 4096!");
+    }
+    if (config.bufferCount > 0) {
+        size_t bytes = static_cast<size_t>(config.bufferCount) * config.bufferSize;
+        void* memory = std::aligned_alloc(DIRECT_ALIGNMENT, bytes);
+        if (!memory) {
+            throw std::runtime_error("Failed to allocate async I/O buffers!");
+        }
+        bufferMemory = std::unique_ptr<uint8_t[], void (*)(void*)>(static_cast<uint8_t*>(memory), std::free);
+        for (uint32_t i = config.bufferCount; i-- > 0;) {
+            freeBuffers.push_back(i);
+        }
+    }
+
+    if (!config.forceFallback && setup_ring(std::max(config.queueDepth, 8u))) {
+        threads.emplace_back(&AsyncIO::ring_loop, this);
+        return;
+    }
+    for (uint32_t i = 0; i < std::max(config.fallbackThreads, 1u); i++) {
+        threads.emplace_back(&AsyncIO::fallback_loop, this);
+    }
+}
+
+AsyncIO::~AsyncIO() {
+    wait_idle();
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queueCondition.notify_all();
+    }
+    if (ringFd >= 0) {
+        wake_service();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    teardown_ring();
+}
+
+bool AsyncIO::setup_ring(uint32_t entries) {
+    io_uring_params params{};
+    int fd = io_uring_setup(entries, &params);
+    if (fd < 0) {
+        std::cout << "[AsyncIO] io_uring unavailable (" << std::strerror(errno) << "), using pread threads"
+                  << std::endl;
+        return false;
+    }
+    ringFd = fd;
+
+    // Every op the service issues must be there; otherwise fall back wholesale
+    constexpr unsigned PROBE_OPS = 256;
+    std::vector<uint8_t> probeMemory(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op));
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+    bool supported = io_uring_register(fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) == 0;
+    for (unsigned op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_CLOSE}) {
+        supported = supported && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+    if (!supported) {
+        std::cout << "[AsyncIO] io_uring lacks required ops, using pread threads" << std::endl;
+        teardown_ring();
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        teardown_ring();
+        return false;
+    }
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            teardown_ring();
+            return false;
+        }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqeMemory == MAP_FAILED) {
+        teardown_ring();
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(sqeMemory);
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqEntries = params.cq_entries;
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        teardown_ring();
+        return false;
+    }
+
+    // Fixed buffers pin memory against RLIMIT_MEMLOCK; without them direct reads use plain READ
+    if (config.bufferCount > 0) {
+        std::vector<iovec> iovecs(config.bufferCount);
+        for (uint32_t i = 0; i < config.bufferCount; i++) {
+            iovecs[i].iov_base = bufferMemory.get() + static_cast<size_t>(i) * config.bufferSize;
+            iovecs[i].iov_len = config.bufferSize;
+        }
+        buffersRegistered = io_uring_register(fd, IORING_REGISTER_BUFFERS, iovecs.data(), config.bufferCount) == 0;
+    }
+    return true;
+}
+
+void AsyncIO::teardown_ring() {
+    if (sqes) {
+        munmap(sqes, sqesSize);
+        sqes = nullptr;
+    }
+    if (cqRing && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing) {
+        munmap(sqRing, sqRingSize);
+    }
+    sqRing = cqRing = nullptr;
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+        ringFd = -1;
+    }
+}
+
+void AsyncIO::read_file(const std::string& path, Completion completion) {
+    IoRequest* request = new IoRequest{};
+    request->kind = IoRequest::Kind::File;
+    request->stage = IoRequest::Stage::Open;
+    request->result.path = path;
+    request->completion = std::move(completion);
+    post(request);
+}
+
+void AsyncIO::read(int fd, uint64_t offset, void* destination, uint32_t size, Completion completion) {
+    IoRequest* request = new IoRequest{};
+    request->kind = IoRequest::Kind::Range;
+    request->stage = IoRequest::Stage::Read;
+    request->fd = fd;
+    request->offset = offset;
+    request->length = size;
+    request->target = static_cast<uint8_t*>(destination);
+    request->completion = std::move(completion);
+    post(request);
+}
+
+void AsyncIO::read_direct(int fd, uint64_t offset, uint32_t size, Completion completion) {
+    uint64_t alignedOffset = offset & ~(DIRECT_ALIGNMENT - 1);
+    uint64_t alignedEnd = (offset + size + DIRECT_ALIGNMENT - 1) & ~(DIRECT_ALIGNMENT - 1);
+    if (alignedEnd - alignedOffset > config.bufferSize) {
+        throw std::runtime_error("Direct read does not fit in an async I/O buffer!");
+    }
+    IoRequest* request = new IoRequest{};
+    request->kind = IoRequest::Kind::Direct;
+    request->stage = IoRequest::Stage::Read;
+    request->fd = fd;
+    request->offset = alignedOffset;
+    request->length = alignedEnd - alignedOffset;
+    request->skip = offset - alignedOffset;
+    request->requested = size;
+    request->completion = std::move(completion);
+    post(request);
+}
+
+void AsyncIO::release_buffer(uint32_t buffer) {
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        freeBuffers.push_back(buffer);
+    }
+    bufferCondition.notify_one();
+    if (ringFd >= 0) {
+        wake_service(); // Requests may be parked waiting for it
+    }
+}
+
+void AsyncIO::wait_idle() {
+    while (inFlight.load(std::memory_order_acquire) > 0) {
+        jobs.wait(completions);
+        if (inFlight.load(std::memory_order_acquire) > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    jobs.wait(completions);
+}
+
+AsyncIO::Stats AsyncIO::get_stats() const {
+    Stats stats;
+    stats.reads = readCount.load(std::memory_order_relaxed);
+    stats.bytes = byteCount.load(std::memory_order_relaxed);
+    stats.submitCalls = submitCalls.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AsyncIO::post(IoRequest* request) {
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        wasEmpty = queue.empty();
+        queue.push_back(request);
+    }
+    if (ringFd < 0 || ringFailed.load(std::memory_order_acquire)) {
+        queueCondition.notify_one();
+    } else if (wasEmpty) {
+        // One wake per batch: the service drains everything queued before it runs again
+        wake_service();
+    }
+}
+
+void AsyncIO::wake_service() {
+    uint64_t one = 1;
+    while (write(wakeFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+uint32_t AsyncIO::acquire_buffer(bool wait) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (wait) {
+        bufferCondition.wait(lock, [&] { return !freeBuffers.empty(); });
+    } else if (freeBuffers.empty()) {
+        return NO_BUFFER;
+    }
+    uint32_t buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+void AsyncIO::complete(IoRequest* request) {
+    Result& result = request->result;
+    if (result.error == 0) {
+        readCount.fetch_add(1, std::memory_order_relaxed);
+        byteCount.fetch_add(request->done, std::memory_order_relaxed);
+    }
+    switch (request->kind) {
+    case IoRequest::Kind::File:
+        result.bytes = result.data.get();
+        result.size = request->done;
+        break;
+    case IoRequest::Kind::Range:
+        result.bytes = request->target;
+        result.size = request->done;
+        break;
+    case IoRequest::Kind::Direct:
+        result.bytes = request->target + request->skip;
+        result.size = request->done > request->skip ? std::min(request->done - request->skip, request->requested) : 0;
+        break;
+    }
+    jobs.run(
+        [this, request] {
+            if (request->completion) {
+                request->completion(request->result);
+            } else if (request->result.buffer != NO_BUFFER) {
+                release_buffer(request->result.buffer);
+            }
+            delete request;
+            inFlight.fetch_sub(1, std::memory_order_acq_rel);
+        },
+        &completions);
+}
+
+io_uring_sqe* AsyncIO::get_sqe() {
+    if (ringFailed.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    // Keep the completion ring from overflowing: every op in flight owns one CQE
+    if (sqLocalTail - head >= sqEntries || opsInFlight >= cqEntries) {
+        return nullptr;
+    }
+    unsigned index = sqLocalTail & sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqLocalTail++;
+    opsInFlight++;
+    return sqe;
+}
+
+bool AsyncIO::prepare(IoRequest* request) {
+    if (request->kind == IoRequest::Kind::Direct && request->result.buffer == NO_BUFFER) {
+        uint32_t buffer = acquire_buffer(false);
+        if (buffer == NO_BUFFER) {
+            return false;
+        }
+        request->result.buffer = buffer;
+        request->target = bufferMemory.get() + static_cast<size_t>(buffer) * config.bufferSize;
+    }
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    switch (request->stage) {
+    case IoRequest::Stage::Open:
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(request->result.path.c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        break;
+    case IoRequest::Stage::Stat:
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = request->fd;
+        sqe->addr = reinterpret_cast<uint64_t>("");
+        sqe->statx_flags = AT_EMPTY_PATH;
+        sqe->len = STATX_SIZE;
+        sqe->off = reinterpret_cast<uint64_t>(&request->stat);
+        break;
+    case IoRequest::Stage::Read: {
+        bool fixed = request->kind == IoRequest::Kind::Direct && buffersRegistered;
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = request->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(request->target + request->done);
+        sqe->len = static_cast<uint32_t>(request->length - request->done);
+        sqe->off = request->offset + request->done;
+        if (fixed) {
+            sqe->buf_index = static_cast<uint16_t>(request->result.buffer);
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+void AsyncIO::handle_completion(IoRequest* request, int result) {
+    if (result == -EINTR || result == -EAGAIN) {
+        ready.push_back(request);
+        return;
+    }
+    bool finished = false;
+    if (result < 0) {
+        request->result.error = -result;
+        finished = true;
+    } else {
+        switch (request->stage) {
+        case IoRequest::Stage::Open:
+            request->fd = result;
+            request->stage = IoRequest::Stage::Stat;
+            break;
+        case IoRequest::Stage::Stat:
+            request->length = request->stat.stx_size;
+            request->result.data.reset(new uint8_t[std::max<uint64_t>(request->length, 1)]);
+            request->target = request->result.data.get();
+            request->stage = IoRequest::Stage::Read;
+            finished = request->length == 0;
+            break;
+        case IoRequest::Stage::Read:
+            request->done += static_cast<uint64_t>(result);
+            finished = result == 0 || request->done == request->length;
+            break;
+        }
+    }
+    if (!finished) {
+        ready.push_back(request);
+        return;
+    }
+
+    if (request->kind == IoRequest::Kind::File && request->fd >= 0) {
+        io_uring_sqe* sqe = get_sqe();
+        if (sqe) {
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = request->fd;
+            sqe->user_data = CLOSE_TAG;
+        } else {
+            close(request->fd);
+        }
+        request->fd = -1;
+    }
+    complete(request);
+}
+
+void AsyncIO::ring_loop() {
+    std::deque<IoRequest*> incoming;
+    bool wakeArmed = false;
+    unsigned submittedTail = sqLocalTail;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            incoming.insert(incoming.end(), queue.begin(), queue.end());
+            queue.clear();
+        }
+        if (stopping.load(std::memory_order_acquire) && incoming.empty() && ready.empty() &&
+            opsInFlight == (wakeArmed ? 1u : 0u)) {
+            break;
+        }
+
+        if (!wakeArmed) {
+            io_uring_sqe* sqe = get_sqe();
+            if (sqe) {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = wakeFd;
+                sqe->addr = reinterpret_cast<uint64_t>(&wakeValue);
+                sqe->len = sizeof(wakeValue);
+                sqe->user_data = WAKE_TAG;
+                wakeArmed = true;
+            }
+        }
+        // Follow-up ops first so started requests finish before new ones begin. Requests
+        // waiting for a buffer stay queued in order; anything else stops at a full ring.
+        for (std::deque<IoRequest*>* source : {&ready, &incoming}) {
+            std::deque<IoRequest*> parked;
+            while (!source->empty()) {
+                IoRequest* request = source->front();
+                if (!prepare(request)) {
+                    if (request->result.buffer == NO_BUFFER && request->kind == IoRequest::Kind::Direct) {
+                        parked.push_back(request);
+                        source->pop_front();
+                        continue;
+                    }
+                    break;
+                }
+                source->pop_front();
+            }
+            source->insert(source->begin(), parked.begin(), parked.end());
+        }
+
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+        unsigned toSubmit = sqLocalTail - submittedTail;
+        int submitted = io_uring_enter(ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+        submitCalls.fetch_add(1, std::memory_order_relaxed);
+        if (submitted < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+            std::cout << "[AsyncIO] io_uring_enter failed (" << std::strerror(errno)
+                      << "), finishing reads with blocking syscalls" << std::endl;
+            ring_failed_loop(incoming, wakeArmed);
+            return;
+        }
+        submittedTail = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE); // Anything past it goes in next time
+        reap_completions(wakeArmed);
+    }
+}
+
+void AsyncIO::reap_completions(bool& wakeArmed) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const io_uring_cqe& cqe = cqes[head & cqMask];
+        opsInFlight--;
+        if (cqe.user_data == WAKE_TAG) {
+            wakeArmed = false;
+        } else if (cqe.user_data != CLOSE_TAG) {
+            handle_completion(reinterpret_cast<IoRequest*>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    }
+}
+
+// Throwing here would terminate the process, and dropping requests would strand their
+// callers. Ops the kernel has taken may still write into their requests, so those are
+// waited for by polling the completion ring; everything else, including whatever is
+// posted from now on, finishes with blocking syscalls on this thread.
+void AsyncIO::ring_failed_loop(std::deque<IoRequest*>& incoming, bool wakeArmed) {
+    ringFailed.store(true, std::memory_order_release);
+
+    // SQEs past the kernel's head were never consumed, and without another enter never will be
+    for (unsigned index = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE); index != sqLocalTail; index++) {
+        const io_uring_sqe& sqe = sqes[index & sqMask];
+        opsInFlight--;
+        if (sqe.user_data == WAKE_TAG) {
+            wakeArmed = false;
+        } else if (sqe.user_data == CLOSE_TAG) {
+            close(sqe.fd);
+        } else {
+            ready.push_back(reinterpret_cast<IoRequest*>(sqe.user_data));
+        }
+    }
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (queue.empty() && ready.empty() && incoming.empty()) {
+                // Bounded, to keep polling for the kernel's outstanding completions
+                queueCondition.wait_for(lock, std::chrono::milliseconds(1),
+                                        [&] { return !queue.empty() || stopping.load(std::memory_order_acquire); });
+            }
+            incoming.insert(incoming.end(), queue.begin(), queue.end());
+            queue.clear();
+        }
+        if (stopping.load(std::memory_order_acquire) && incoming.empty() && ready.empty() &&
+            opsInFlight == (wakeArmed ? 1u : 0u)) {
+            return;
+        }
+
+        reap_completions(wakeArmed); // Follow-up stages land in `ready`
+        for (std::deque<IoRequest*>* source : {&ready, &incoming}) {
+            while (!source->empty()) {
+                IoRequest* request = source->front();
+                source->pop_front();
+                run_blocking(request);
+            }
+        }
+    }
+}
+
+void AsyncIO::fallback_loop() {
+    while (true) {
+        IoRequest* request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [&] { return !queue.empty() || stopping.load(std::memory_order_acquire); });
+            if (queue.empty()) {
+                return;
+            }
+            request = queue.front();
+            queue.pop_front();
+        }
+        run_blocking(request);
+    }
+}
+
+// Also picks up requests the ring had taken part of the way, after it failed
+void AsyncIO::run_blocking(IoRequest* request) {
+    if (request->kind == IoRequest::Kind::File && request->stage != IoRequest::Stage::Read) {
+        if (request->stage == IoRequest::Stage::Open) {
+            request->fd = open(request->result.path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        struct stat info;
+        if (request->fd < 0 || fstat(request->fd, &info) != 0) {
+            request->result.error = errno;
+            if (request->fd >= 0) {
+                close(request->fd);
+            }
+            complete(request);
+            return;
+        }
+        request->length = static_cast<uint64_t>(info.st_size);
+        request->result.data.reset(new uint8_t[std::max<uint64_t>(request->length, 1)]);
+        request->target = request->result.data.get();
+        submitCalls.fetch_add(2, std::memory_order_relaxed);
+    } else if (request->kind == IoRequest::Kind::Direct && request->result.buffer == NO_BUFFER) {
+        request->result.buffer = acquire_buffer(true);
+        request->target = bufferMemory.get() + static_cast<size_t>(request->result.buffer) * config.bufferSize;
+    }
+
+    while (request->done < request->length) {
+        ssize_t bytes = pread(request->fd, request->target + request->done, request->length - request->done,
+                              static_cast<off_t>(request->offset + request->done));
+        submitCalls.fetch_add(1, std::memory_order_relaxed);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0) {
+            request->result.error = errno;
+            break;
+        }
+        if (bytes == 0) {
+            break;
+        }
+        request->done += static_cast<uint64_t>(bytes);
+    }
+    if (request->kind == IoRequest::Kind::File) {
+        close(request->fd);
+        request->fd = -1;
+        submitCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+    complete(request);
+}
@@ -0,0 +1,152 @@
+#include "core/arena.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+constexpr size_t SCRATCH_BLOCK_SIZE = 256 * 1024;
+constexpr size_t MAX_CACHED_FRAME_ARENAS = 4;
+
+struct CachedArena {
+    uint64_t owner;
+    LinearArena* arena;
+};
+
+std::atomic<uint64_t> nextFrameArenasId{1};
+thread_local CachedArena cachedArenas[MAX_CACHED_FRAME_ARENAS] = {};
+thread_local size_t cachedArenaCount = 0;
+
+LinearArena& thread_scratch_arena() {
+    thread_local LinearArena arena(SCRATCH_BLOCK_SIZE);
+    return arena;
+}
+
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+LinearArena::LinearArena(size_t blockSize) : blockSize(blockSize) {
+}
+
+size_t LinearArena::get_capacity() const {
+    size_t capacity = 0;
+    for (const Block& block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void LinearArena::add_block(size_t minimumSize) {
+    size_t size = std::max(blockSize, minimumSize);
+    blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]), size, 0});
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment) {
+    if (blocks.empty()) {
+        add_block(size + alignment);
+    }
+
+    while (true) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+        size_t start = align_up(base + block.offset, alignment) - base;
+        if (start + size <= block.size) {
+            used += start + size - block.offset;
+            peak = std::max(peak, used);
+            block.offset = start + size;
+            return block.memory.get() + start;
+        }
+
+        // Later blocks may be left over from before a rewind; reuse them when they fit
+        used += block.size - block.offset; // The tail of this block is skipped
+        block.offset = block.size;
+        if (current + 1 == blocks.size()) {
+            add_block(size + alignment);
+        }
+        current++;
+        blocks[current].offset = 0;
+    }
+}
+
+void LinearArena::rewind(Marker marker) {
+    if (blocks.empty()) {
+        return;
+    }
+    for (size_t i = marker.block + 1; i <= current; i++) {
+        used -= blocks[i].offset;
+        blocks[i].offset = 0;
+    }
+    used -= blocks[marker.block].offset - marker.offset;
+    blocks[marker.block].offset = marker.offset;
+    current = marker.block;
+}
+
+void LinearArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = get_capacity();
+        blocks.clear();
+        add_block(total);
+    }
+    if (!blocks.empty()) {
+        blocks[0].offset = 0;
+    }
+    current = 0;
+    used = 0;
+    peak = 0;
+}
+
+ScratchScope::ScratchScope() : arena(thread_scratch_arena()), marker(arena.mark()) {
+}
+
+FrameArenas::FrameArenas(size_t blockSize) : id(nextFrameArenasId++), blockSize(blockSize) {
+}
+
+FrameArenas::~FrameArenas() = default;
+
+LinearArena& FrameArenas::local() {
+    for (size_t i = 0; i < cachedArenaCount; i++) {
+        if (cachedArenas[i].owner == id) {
+            return *cachedArenas[i].arena;
+        }
+    }
+    return register_thread();
+}
+
+// First use from this thread, or its cache entry was evicted
+LinearArena& FrameArenas::register_thread() {
+    std::thread::id thread = std::this_thread::get_id();
+    LinearArena* arena = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : arenas) {
+            if (entry.first == thread) {
+                arena = entry.second.get();
+                break;
+            }
+        }
+        if (!arena) {
+            arenas.emplace_back(thread, std::make_unique<LinearArena>(blockSize));
+            arena = arenas.back().second.get();
+        }
+    }
+
+    size_t slot = cachedArenaCount < MAX_CACHED_FRAME_ARENAS ? cachedArenaCount++ : 0;
+    cachedArenas[slot] = {id, arena};
+    return *arena;
+}
+
+void FrameArenas::end_frame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t framePeak = 0;
+    for (auto& entry : arenas) {
+        framePeak += entry.second->get_peak();
+        entry.second->reset();
+    }
+    lastFramePeak = framePeak;
+    maxFramePeak = std::max(maxFramePeak, framePeak);
+}
+
+size_t FrameArenas::get_thread_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return arenas.size();
+}
@@ -0,0 +1,271 @@
+#include "core/job_system.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+thread_local JobSystem* currentSystem = nullptr;
+thread_local int currentWorker = -1; // Index into the pool, or -1 outside it
+thread_local uint32_t externalSeed = 0x9e3779b9u;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+uint32_t next_random(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+}
+
+JobSystem::JobSystem(uint32_t workerCount, bool pinThreads) : startNs(now_ns()) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workerCount = std::min(workerCount, MAX_WORKERS);
+
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->stealSeed = 0x9e3779b9u * (i + 1);
+    }
+
+    // The creating thread is worker 0 and only runs jobs from inside wait()
+    currentSystem = this;
+    currentWorker = 0;
+    for (uint32_t i = 1; i < workerCount; i++) {
+        workers[i]->thread = std::thread(&JobSystem::worker_loop, this, i, pinThreads);
+    }
+    std::cout << "[JobSystem] " << workerCount << " workers" << (pinThreads ? ", pinned" : "") << ".\n";
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // Jobs still queued run here, so their counters and continuations are honoured
+    while (Job* job = take_job(-1)) {
+        execute(job, nullptr);
+    }
+    if (currentSystem == this) {
+        currentSystem = nullptr;
+        currentWorker = -1;
+    }
+}
+
+void JobSystem::run(std::function<void()> function, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    submit(new Job{std::move(function), counter});
+}
+
+void JobSystem::run_after(JobCounter& dependency, std::function<void()> function, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    Job* job = new Job{std::move(function), counter};
+    {
+        std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+        if (dependency.pending.load(std::memory_order_acquire) != 0) {
+            dependency.continuations.push_back(job);
+            return;
+        }
+    }
+    submit(job);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (!counter.done()) {
+        if (!try_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallel_for(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& body,
+                             uint32_t grain) {
+    if (begin >= end) {
+        return;
+    }
+    uint32_t count = end - begin;
+    if (grain == 0) {
+        grain = std::max(1u, count / (get_worker_count() * 4));
+    }
+    if (count <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    JobCounter counter;
+    uint32_t chunkBegin = begin;
+    for (; end - chunkBegin > grain; chunkBegin += grain) {
+        uint32_t chunkEnd = chunkBegin + grain;
+        run([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, &counter);
+    }
+    body(chunkBegin, end); // The caller takes the last chunk itself
+    wait(counter);
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::get_stats() const {
+    double elapsedSeconds = static_cast<double>(now_ns() - startNs) * 1e-9;
+    std::vector<WorkerStats> stats(workers.size());
+    for (size_t i = 0; i < workers.size(); i++) {
+        const Worker& worker = *workers[i];
+        stats[i].executed = worker.executed.load(std::memory_order_relaxed);
+        stats[i].steals = worker.steals.load(std::memory_order_relaxed);
+        stats[i].failedSteals = worker.failedSteals.load(std::memory_order_relaxed);
+        stats[i].busySeconds = static_cast<double>(worker.busyNs.load(std::memory_order_relaxed)) * 1e-9;
+        stats[i].utilization = elapsedSeconds > 0.0 ? stats[i].busySeconds / elapsedSeconds : 0.0;
+    }
+    return stats;
+}
+
+void JobSystem::submit(Job* job) {
+    // Counted before it becomes visible, so a worker that sees zero can safely sleep
+    queuedJobs.fetch_add(1);
+
+    if (currentSystem == this && currentWorker >= 0) {
+        Worker* worker = workers[currentWorker].get();
+        if (!worker->deque.push(job)) {
+            queuedJobs.fetch_sub(1);
+            execute(job, worker); // Deque full: running it now is the cheapest back-pressure
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        injected.push_back(job);
+    }
+
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::execute(Job* job, Worker* worker) {
+    uint64_t start = now_ns();
+    job->function();
+    if (worker) {
+        worker->busyNs.fetch_add(now_ns() - start, std::memory_order_relaxed);
+        worker->executed.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (job->counter) {
+        finish(job->counter);
+    }
+    delete job;
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    counter->finishing.fetch_add(1, std::memory_order_acq_rel);
+    std::vector<Job*> ready;
+    if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(counter->continuationMutex);
+        ready.swap(counter->continuations);
+    }
+    counter->finishing.fetch_sub(1, std::memory_order_release); // Last touch; waiters may free it now
+
+    for (Job* job : ready) {
+        submit(job);
+    }
+}
+
+bool JobSystem::try_run_one() {
+    int index = currentSystem == this ? currentWorker : -1;
+    Job* job = take_job(index);
+    if (!job) {
+        return false;
+    }
+    execute(job, index >= 0 ? workers[index].get() : nullptr);
+    return true;
+}
+
+// Own deque first, then work from outside the pool, then a sweep of the others from a random victim
+JobSystem::Job* JobSystem::take_job(int index) {
+    if (queuedJobs.load(std::memory_order_relaxed) <= 0) {
+        return nullptr;
+    }
+
+    Job* job = nullptr;
+    Worker* self = index >= 0 ? workers[index].get() : nullptr;
+    if (self && self->deque.pop(job)) {
+        queuedJobs.fetch_sub(1);
+        return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if (!injected.empty()) {
+            job = injected.front();
+            injected.pop_front();
+        }
+    }
+    if (job) {
+        queuedJobs.fetch_sub(1);
+        return job;
+    }
+
+    uint32_t count = static_cast<uint32_t>(workers.size());
+    uint32_t first = next_random(self ? self->stealSeed : externalSeed) % count;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t victim = (first + i) % count;
+        if (static_cast<int>(victim) == index || workers[victim]->deque.empty()) {
+            continue;
+        }
+        if (workers[victim]->deque.steal(job)) {
+            queuedJobs.fetch_sub(1);
+            if (self) {
+                self->steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+        if (self) {
+            self->failedSteals.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::worker_loop(uint32_t index, bool pin) {
+    currentSystem = this;
+    currentWorker = static_cast<int>(index);
+
+    if (pin) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    uint32_t idleSpins = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (try_run_one()) {
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins < SPINS_BEFORE_SLEEP) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        wake.wait(lock, [this]() { return stopping.load() || queuedJobs.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+        idleSpins = 0;
+    }
+}
@@ -1,29 +1,310 @@
 #include "engine.hpp"
 #include <iostream> // For debugging/logging
 #include <wayland-client.h> // For Wayland event polling
-#include <unistd.h> // For usleep
+#include <algorithm>
+#include <cerrno>
+#include <cstdio> // For perror
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+// ENGINE_PRESENT_PATH=shm presents through wl_shm, for hosts without a WSI-capable driver
+static PresentPath present_path_from_env() {
+    const char* path = getenv("ENGINE_PRESENT_PATH");
+    return (path && strcmp(path, "shm") == 0) ? PresentPath::Shm : PresentPath::Swapchain;
+}
+
+// Malformed values fall back to the default and out-of-range ones are clamped, so a typo
+// cannot wrap around into a huge unsigned count
+static long long_from_env(const char* name, long fallback, long low, long high) {
+    const char* text = getenv(name);
+    if (!text) {
+        return fallback;
+    }
+    char* end = nullptr;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0') {
+        std::cout << "[Engine] Ignoring " << name << "=" << text << ", not a number\n";
+        return fallback;
+    }
+    long clamped = std::clamp(value, low, high);
+    if (clamped != value) {
+        std::cout << "[Engine] " << name << "=" << text << " clamped to " << clamped << "\n";
+    }
+    return clamped;
+}
+
+// ENGINE_SIM_HZ sets the simulation rate independently of the display's refresh rate
+static uint32_t simulation_hz_from_env() {
+    return static_cast<uint32_t>(long_from_env("ENGINE_SIM_HZ", 60, 1, SimulationClock::MAX_HZ));
+}
+
+static uint64_t monotonic_ns() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+// ENGINE_JOB_THREADS overrides the one-worker-per-core default; ENGINE_JOB_PIN pins them
+static uint32_t job_threads_from_env() {
+    return static_cast<uint32_t>(long_from_env("ENGINE_JOB_THREADS", 0, 0, JobSystem::MAX_WORKERS));
+}
+
+// ENGINE_IO_FALLBACK reads assets with blocking pread threads even where io_uring works
+static AsyncIOConfig asset_io_config_from_env() {
+    AsyncIOConfig config;
+    config.forceFallback = getenv("ENGINE_IO_FALLBACK") != nullptr;
+    return config;
+}
+
+// ENGINE_ASSET_ARCHIVE names the archive; by default it is assets.pak beside the executable
+static std::unique_ptr<AssetArchive> open_asset_archive() {
+    std::string path;
+    if (const char* configured = getenv("ENGINE_ASSET_ARCHIVE")) {
+        path = configured;
+    } else {
+        char executable[4096];
+        ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+        if (length <= 0) {
+            return nullptr;
+        }
+        path.assign(executable, static_cast<size_t>(length));
+        path = path.substr(0, path.rfind('/') + 1) + "assets.pak";
+    }
+    if (access(path.c_str(), R_OK) != 0) {
+        std::cout << "[Assets] No archive at " << path << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>(path);
+    std::cout << "[Assets] Mapped " << archive->get_entry_count() << " assets from " << path << std::endl;
+    return archive;
+}
+
+// Only the events a user causes carry a timestamp worth matching to a frame
+static void keyboard_key(void* data, wl_keyboard*, uint32_t, uint32_t time, uint32_t, uint32_t) {
+    static_cast<Engine*>(data)->note_input(time);
+}
+
+static void pointer_motion(void* data, wl_pointer*, uint32_t time, wl_fixed_t, wl_fixed_t) {
+    static_cast<Engine*>(data)->note_input(time);
+}
+
+static void pointer_button(void* data, wl_pointer*, uint32_t, uint32_t time, uint32_t, uint32_t) {
+    static_cast<Engine*>(data)->note_input(time);
+}
+
+static void pointer_axis(void* data, wl_pointer*, uint32_t time, uint32_t, wl_fixed_t) {
+    static_cast<Engine*>(data)->note_input(time);
+}
+
+// wl_seat is bound at version 1, so only the version 1 events can arrive
+static const wl_keyboard_listener keyboardListener = {
+    [](void*, wl_keyboard*, uint32_t, int fd, uint32_t) { close(fd); },
+    [](void*, wl_keyboard*, uint32_t, wl_surface*, wl_array*) {},
+    [](void*, wl_keyboard*, uint32_t, wl_surface*) {},
+    keyboard_key,
+    [](void*, wl_keyboard*, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) {},
+    nullptr,
+};
+
+static const wl_pointer_listener pointerListener = {
+    [](void*, wl_pointer*, uint32_t, wl_surface*, wl_fixed_t, wl_fixed_t) {},
+    [](void*, wl_pointer*, uint32_t, wl_surface*) {},
+    pointer_motion,
+    pointer_button,
+    pointer_axis,
+};
+
+const wl_seat_listener Engine::seatListener = {
+    Engine::seat_capabilities,
+    nullptr,
+};
+
+static void seat_registry_global(void* data, wl_registry* registry, uint32_t id, const char* interface, uint32_t) {
+    wl_seat** seat = static_cast<wl_seat**>(data);
+    if (!*seat && strcmp(interface, wl_seat_interface.name) == 0) {
+        *seat = static_cast<wl_seat*>(wl_registry_bind(registry, id, &wl_seat_interface, 1));
+    }
+}
+
+static const wl_registry_listener seatRegistryListener = {
+    seat_registry_global,
+    [](void*, wl_registry*, uint32_t) {},
+};
 
 Engine::Engine(wl_display* display, wl_surface* surface)
-    : vkContext(display, surface) { // Initialize VulkanContext with arguments
+    : vkContext(display, surface, present_path_from_env()), // Initialize VulkanContext with arguments
+      eventLoop(display),
+      framePacer(eventLoop, surface),
+      presentation(display, surface),
+      jobs(job_threads_from_env(), getenv("ENGINE_JOB_PIN") != nullptr),
+      assetIO(jobs, asset_io_config_from_env()),
+      assetArchive(open_asset_archive()),
+      assetCache(jobs, assetIO, assetArchive.get()),
+      simClock(simulation_hz_from_env()),
+      simLockstep(getenv("ENGINE_SIM_LOCKSTEP") != nullptr) {
+    // Feedback goes on the commit that actually presents, which the present thread may make
+    vkContext.set_present_hook([this] { presentation.frame_committed(); });
+    if (presentation.is_available()) {
+        bind_seat(display);
+    }
     std::cout << "Engine initialized with Wayland display and surface." << std::endl;
 }
 
-Engine::~Engine() {}
+Engine::~Engine() {
+    vkContext.set_present_hook(nullptr); // The present thread outlives the tracker
+    if (keyboard) {
+        wl_keyboard_destroy(keyboard);
+    }
+    if (pointer) {
+        wl_pointer_destroy(pointer);
+    }
+    if (seat) {
+        wl_seat_destroy(seat);
+    }
+    if (simulationThread.joinable()) {
+        simulationRunning = false;
+        simulationThread.join();
+    }
+    if (simClock.get_tick() > 0) {
+        std::cout << "[Engine] " << simClock.get_tick() << " simulation steps of " << simClock.get_step_seconds() * 1000.0
+                  << " ms; " << simClock.get_dropped_seconds() << " s dropped by the catch-up clamp\n";
+    }
+
+    if (frameArenas.get_max_frame_peak() > 0 || simulationArenas.get_max_frame_peak() > 0) {
+        std::cout << "[Arena] peak per frame: render " << frameArenas.get_max_frame_peak() / 1024 << " KB over "
+                  << frameArenas.get_thread_count() << " threads, simulation " << simulationArenas.get_max_frame_peak() / 1024
+                  << " KB over " << simulationArenas.get_thread_count() << " threads\n";
+    }
+
+    AsyncIO::Stats ioStats = assetIO.get_stats();
+    if (ioStats.reads > 0) {
+        std::cout << "[AsyncIO] " << ioStats.reads << " reads, " << ioStats.bytes / 1024 << " KB in "
+                  << ioStats.submitCalls << (assetIO.uses_io_uring() ? " io_uring submissions\n" : " syscalls\n");
+    }
+
+    std::vector<JobSystem::WorkerStats> workerStats = jobs.get_stats();
+    for (size_t i = 0; i < workerStats.size(); i++) {
+        const JobSystem::WorkerStats& stats = workerStats[i];
+        if (stats.executed > 0) {
+            std::cout << "[JobSystem] worker " << i << ": " << stats.executed << " jobs, " << stats.steals << " steals ("
+                      << stats.failedSteals << " failed), " << stats.utilization * 100.0 << "% busy\n";
+        }
+    }
+}
+
+// A registry of its own, like the presentation tracker's, so the application's seat
+// handling is left alone; the compositor sends input to every keyboard and pointer object
+void Engine::bind_seat(wl_display* display) {
+    wl_registry* registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &seatRegistryListener, &seat);
+    wl_display_roundtrip(display);
+    wl_registry_destroy(registry);
+    if (seat) {
+        wl_seat_add_listener(seat, &seatListener, this);
+    }
+}
+
+void Engine::seat_capabilities(void* data, wl_seat* seat, uint32_t capabilities) {
+    Engine* engine = static_cast<Engine*>(data);
+    if ((capabilities & WL_SEAT_CAPABILITY_KEYBOARD) && !engine->keyboard) {
+        engine->keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(engine->keyboard, &keyboardListener, engine);
+    }
+    if ((capabilities & WL_SEAT_CAPABILITY_POINTER) && !engine->pointer) {
+        engine->pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(engine->pointer, &pointerListener, engine);
+    }
+}
+
+void Engine::set_simulation_step(SimulationStep step) {
+    simulationStep = std::move(step);
+}
+
+void Engine::set_snapshot_builder(SnapshotBuilder builder) {
+    snapshotBuilder = std::move(builder);
+}
+
+void Engine::set_render_interpolation(RenderInterpolation interpolate) {
+    renderInterpolation = std::move(interpolate);
+}
+
+// Runs however many fixed steps real time owes and publishes the result
+bool Engine::run_simulation_steps() {
+    uint64_t now = monotonic_ns();
+    if (simLockstep) {
+        simClock.accumulate(simClock.get_step_ns());
+    } else if (lastStepNs != 0) {
+        simClock.accumulate(static_cast<int64_t>(now - lastStepNs));
+    }
+    lastStepNs = now;
+
+    bool stepped = false;
+    while (simClock.step()) {
+        if (simulationStep) {
+            simulationStep(simClock.get_step_seconds(), simClock.get_tick());
+        }
+        // Every step, so removing the last body still reports its pairs as ended
+        broadphase.update_pairs(&jobs); // Pairs for the next step's contacts
+        stepped = true;
+    }
+    if (!stepped) {
+        return false;
+    }
+
+    Snapshot& snapshot = snapshots.write_buffer();
+    snapshot.tick = simClock.get_tick();
+    snapshot.stepSeconds = simClock.get_step_seconds();
+    snapshot.publishedNs = now;
+    snapshot.publishedAlpha = simClock.get_alpha();
+    if (snapshotBuilder) {
+        snapshotBuilder(snapshot);
+    }
+    snapshots.publish();
+    simulationArenas.end_frame(); // Nothing allocated by the steps may outlive the snapshot copy
+    return true;
+}
+
+// Sleeps on its own deadline between steps; never waits for the render thread
+void Engine::simulation_loop() {
+    while (simulationRunning) {
+        run_simulation_steps();
+
+        uint64_t wake = monotonic_ns() + static_cast<uint64_t>(simClock.get_until_next_step_ns());
+        timespec deadline;
+        deadline.tv_sec = static_cast<time_t>(wake / 1000000000ull);
+        deadline.tv_nsec = static_cast<long>(wake % 1000000000ull);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+        }
+    }
+}
+
+// Blends between the two states of the newest snapshot by how far real time has moved
+// past it; in lockstep mode only the clock's own remainder counts, keeping runs repeatable
+void Engine::interpolate_latest_snapshot() {
+    snapshots.update();
+    const Snapshot& snapshot = snapshots.read_buffer();
+    if (!renderInterpolation || snapshot.tick == 0) {
+        return;
+    }
+    double alpha = snapshot.publishedAlpha;
+    if (!simLockstep) {
+        alpha += static_cast<double>(monotonic_ns() - snapshot.publishedNs) * 1e-9 / snapshot.stepSeconds;
+    }
+    renderInterpolation(snapshot, std::min(alpha, 1.0));
+}
 
 void Engine::initialize() {
     // Perform any necessary setup or resource loading here.
+    // VulkanContext builds its swapchain, command and sync objects in its constructor;
+    // creating them again here would leak the originals while frames may still use them.
     std::cout << "[Engine] Initialization complete.\n";
-    vkContext.create_swapchain();
-    vkContext.create_render_pass();
-    vkContext.create_framebuffers();
-    vkContext.create_command_pool();
-    vkContext.create_command_buffers();
-    vkContext.create_sync_objects();
 }
 
-void Engine::render_frame() {
+bool Engine::render_frame() {
     try {
-        vkContext.draw_frame(); // Render a frame using Vulkan
+        return vkContext.draw_frame(); // Render a frame using Vulkan
     } catch (const std::exception& e) {
         std::cerr << "[Engine] Error during frame rendering: " << e.what() << "\n";
         throw;
@@ -32,22 +313,32 @@ void Engine::render_frame() {
 
 void Engine::main_loop() {
     while (true) {
-        int dispatchResult = wl_display_dispatch(vkContext.get_display());
-        if (dispatchResult == -1) {
+        // Dispatches input as it arrives and returns whenever the next frame is due, so
+        // neither waits on the other
+        FramePacer::Wake wake = framePacer.wait();
+        if (wake == FramePacer::Wake::Error) {
             perror("[Engine] Wayland event dispatch failed");
             break;
         }
+        if (wake != FramePacer::Wake::Frame) {
+            continue;
+        }
 
-        render_frame(); // Render a frame
-
-        // Commit the surface after rendering
-        wl_surface_commit(vkContext.get_surface());
+        framePacer.request_frame(); // Must precede the commit made by present
+        if (simLockstep) {
+            run_simulation_steps();
+        }
+        interpolate_latest_snapshot();
+        // Presentation feedback is requested by the present hook, right before the present's own commit
+        if (!render_frame()) {
+            // Commits the frame request when present was skipped (dropped or out-of-date frame)
+            wl_surface_commit(vkContext.get_surface());
+        }
 
         // Flush the Wayland display to ensure events are sent
         wl_display_flush(vkContext.get_display());
 
-        // Optional: Sleep to limit frame rate (e.g., ~60fps)
-        usleep(16000);
+        frameArenas.end_frame();
     }
 }
 
@@ -55,5 +346,16 @@ void Engine::run() {
     // Placeholder for the main engine loop
     std::cout << "Engine is running..." << std::endl;
     initialize();
+
+    // The render thread keeps Wayland dispatch, pacing and Vulkan; the simulation gets a thread of its own
+    if (!simLockstep) {
+        simulationRunning = true;
+        simulationThread = std::thread(&Engine::simulation_loop, this);
+    }
     main_loop();
+
+    if (simulationThread.joinable()) {
+        simulationRunning = false;
+        simulationThread.join();
+    }
 }
@@ -4,8 +4,9 @@
 #include <cstring>
 #include <unistd.h>
 #include "platform/shm_renderer.hpp"
-#include <chrono>
-#include <bits/this_thread_sleep.h>
+#include "platform/event_loop.hpp"
+#include "platform/frame_pacer.hpp"
+#include "platform/presentation_tracker.hpp"
 
 // Global variables for Wayland objects
 wl_compositor* compositor = nullptr;
@@ -15,6 +16,8 @@ wl_seat* seat = nullptr;
 wl_keyboard* keyboard = nullptr;
 wl_pointer* pointer = nullptr;
 
+PresentationTracker* presentationTracker = nullptr; // Input timestamps feed input-to-photon latency
+
 bool configured = false;
 bool running = true;
 
@@ -29,6 +32,9 @@ static const xdg_surface_listener xdgSurfaceListener = {
 
 void handle_key_event(void* data, wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state) {
     std::cout << "Key event: key=" << key << ", state=" << (state == WL_KEYBOARD_KEY_STATE_PRESSED ? "PRESSED" : "RELEASED") << std::endl;
+    if (presentationTracker) {
+        presentationTracker->note_input(time);
+    }
 
     if (key == 1 && state == WL_KEYBOARD_KEY_STATE_PRESSED) {
         std::cout << "ESC pressed, exiting.\n";
@@ -45,9 +51,15 @@ static const wl_pointer_listener pointer_listener = {
     },
     .motion = [](void* data, wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y) {
         std::cout << "[DEBUG] Pointer motion event: time=" << time << ", x=" << wl_fixed_to_double(x) << ", y=" << wl_fixed_to_double(y) << std::endl;
+        if (presentationTracker) {
+            presentationTracker->note_input(time);
+        }
     },
     .button = [](void*data, wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state) {
         std::cout << "[DEBUG] Pointer button event: serial=" << serial << ", time=" << time << ", button=" << button << ", state=" << state << std::endl;
+        if (presentationTracker) {
+            presentationTracker->note_input(time);
+        }
     },
     .axis = [](void* data, wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value) {
         std::cout << "[DEBUG] Pointer axis event: time=" << time << ", axis=" << axis << ", value=" << wl_fixed_to_double(value) << std::endl;
@@ -188,9 +200,13 @@ int main() {
     wl_display_flush(display);
     std::cout << "Committed Wayland surface." << std::endl;
 
+    EventLoop eventLoop(display);
     while (!configured) {
         std::cout << "Waiting for configure event..." << std::endl;
-        wl_display_dispatch(display);
+        if (!eventLoop.run_once(-1)) {
+            std::cerr << "Wayland connection lost before configure!" << std::endl;
+            return -1;
+        }
     }
     std::cout << "Configure event received." << std::endl;
 
@@ -198,25 +214,23 @@ int main() {
     wl_display_flush(display);
     std::cout << "Re-committed Wayland surface after configure and flushed display." << std::endl;
 
-    using clock = std::chrono::high_resolution_clock;
-    auto frame_duration = std::chrono::milliseconds(1000 / 60);
+    // Frames follow the compositor's repaint cycle and stop while the window is hidden
+    FramePacer framePacer(eventLoop, surface);
+    PresentationTracker presentation(display, surface);
+    presentationTracker = &presentation;
 
     while (running) {
-        int ret = wl_display_dispatch(display);
-        if (ret == -1) break;
-
-        auto frame_start = clock::now();
+        FramePacer::Wake wake = framePacer.wait();
+        if (wake == FramePacer::Wake::Error) break;
+        if (wake != FramePacer::Wake::Frame) continue;
 
+        framePacer.request_frame();
         shmRenderer.draw_background(0xFF0000FF);
+        presentation.frame_committed();
         wl_surface_commit(surface);
         wl_display_flush(display);
-
-        auto frame_end = clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(frame_end - frame_start);
-        if (elapsed < frame_duration) {
-            std::this_thread::sleep_for(frame_duration - elapsed);
-        }
     }
+    presentationTracker = nullptr;
     std::cout << "Exiting main loop." << std::endl;
 
     return 0;
@@ -0,0 +1,343 @@
+#include "physics/broadphase.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Ranges per worker, so thieves can even out uneven sweep lengths
+constexpr uint32_t SWEEP_RANGES_PER_WORKER = 8;
+constexpr uint32_t MIN_BODIES_PER_RANGE = 512;
+
+// Bodies spanning more columns than this on either axis skip the grid
+constexpr int32_t MAX_COLUMN_SPAN = 8;
+constexpr float MAX_CELL = 1 << 22;
+// Lower endpoints are quantized to this many bits below the column in the sort key
+constexpr uint32_t ENDPOINT_BITS = 16;
+constexpr uint32_t RADIX_BITS = 11;
+
+uint64_t key_of(uint64_t key) {
+    return key;
+}
+
+template <typename Entry>
+uint64_t key_of(const Entry& entry) {
+    return entry.key;
+}
+
+// LSD radix sort on the low `keyBits` bits, skipping digits every key shares
+template <typename T>
+void radix_sort(std::vector<T>& items, std::vector<T>& scratch, uint32_t keyBits) {
+    constexpr uint32_t BUCKETS = 1u << RADIX_BITS;
+    scratch.resize(items.size());
+    for (uint32_t shift = 0; shift < keyBits; shift += RADIX_BITS) {
+        uint32_t counts[BUCKETS] = {};
+        for (const T& item : items) {
+            counts[(key_of(item) >> shift) & (BUCKETS - 1)]++;
+        }
+        if (counts[(key_of(items[0]) >> shift) & (BUCKETS - 1)] == items.size()) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& count : counts) {
+            uint32_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const T& item : items) {
+            scratch[counts[(key_of(item) >> shift) & (BUCKETS - 1)]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+int32_t cell_of(float value, float inverseCellSize) {
+    return static_cast<int32_t>(std::floor(std::clamp(value * inverseCellSize, -MAX_CELL, MAX_CELL)));
+}
+
+uint32_t bit_width(uint64_t value) {
+    uint32_t bits = 0;
+    for (; value; value >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+bool overlaps(const float* lo, const float* hi, uint32_t a, uint32_t b) {
+    return lo[a] <= hi[b] && hi[a] >= lo[b];
+}
+
+BroadphasePair pair_from_key(uint64_t key) {
+    return {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)};
+}
+}
+
+uint32_t Broadphase::add(const Aabb& bounds, uint32_t data) {
+    uint32_t body;
+    if (!freeBodies.empty()) {
+        body = freeBodies.back();
+        freeBodies.pop_back();
+    } else {
+        body = static_cast<uint32_t>(alive.size());
+        for (auto* array : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ}) {
+            array->push_back(0.0f);
+        }
+        userData.push_back(0);
+        alive.push_back(0);
+    }
+    alive[body] = 1;
+    userData[body] = data;
+    bodyCount++;
+    update(body, bounds);
+    return body;
+}
+
+void Broadphase::remove(uint32_t body) {
+    alive[body] = 0;
+    releasedBodies.push_back(body);
+    bodyCount--;
+}
+
+void Broadphase::update(uint32_t body, const Aabb& bounds) {
+    minX[body] = bounds.min[0];
+    minY[body] = bounds.min[1];
+    minZ[body] = bounds.min[2];
+    maxX[body] = bounds.max[0];
+    maxY[body] = bounds.max[1];
+    maxZ[body] = bounds.max[2];
+}
+
+// Entries from `begin` on in sweep order, each against the later entries of its column
+// whose lower endpoint lies before its upper one. Quantizing only merges endpoints, so
+// the key bound never stops early; the exact test follows. A pair sharing several
+// columns is reported only from the column holding the low corner of the two boxes'
+// intersection.
+void Broadphase::sweep(uint32_t begin, uint32_t end, std::vector<uint64_t>& out, uint64_t& candidates) const {
+    const uint64_t* key = sweepKey.data();
+    const uint32_t* upperKey = sweepUpperKey.data();
+    const float* lo = sweepMin[0].data();
+    const float* hi = sweepMax[0].data();
+    const float* loU = sweepMin[1].data();
+    const float* hiU = sweepMax[1].data();
+    const float* loV = sweepMin[2].data();
+    const float* hiV = sweepMax[2].data();
+    float inverseCellSize = 1.0f / activeCellSize;
+    uint32_t count = static_cast<uint32_t>(sweepBody.size());
+
+    uint64_t tested = 0;
+    for (uint32_t i = begin; i < end; i++) {
+        uint64_t limit = (key[i] >> ENDPOINT_BITS << ENDPOINT_BITS) | upperKey[i];
+        for (uint32_t j = i + 1; j < count && key[j] <= limit; j++) {
+            tested++;
+            if (lo[j] > hi[i] || lo[i] > hi[j] || loU[j] > hiU[i] || hiU[j] < loU[i] || loV[j] > hiV[i] ||
+                hiV[j] < loV[i]) {
+                continue;
+            }
+            int32_t cornerU = cell_of(std::max(loU[i], loU[j]), inverseCellSize);
+            int32_t cornerV = cell_of(std::max(loV[i], loV[j]), inverseCellSize);
+            if (cornerU != sweepCellU[i] || cornerV != sweepCellV[i] || cornerU != sweepCellU[j] ||
+                cornerV != sweepCellV[j]) {
+                continue;
+            }
+            uint32_t a = std::min(sweepBody[i], sweepBody[j]);
+            uint32_t b = std::max(sweepBody[i], sweepBody[j]);
+            out.push_back(static_cast<uint64_t>(a) << 32 | b);
+        }
+    }
+    candidates = tested;
+}
+
+void Broadphase::update_pairs(JobSystem* jobs) {
+    // Cheap to call every step: with no bodies, pairs or pending handles there is nothing
+    // to sweep, only the last step's diff to retire
+    if (bodyCount == 0 && pairKeys.empty() && releasedBodies.empty()) {
+        addedPairs.clear();
+        removedPairs.clear();
+        candidateCount = 0;
+        return;
+    }
+    // Sweep the axis with the largest spread of centres and grid the other two
+    const std::vector<float>* mins[3] = {&minX, &minY, &minZ};
+    const std::vector<float>* maxs[3] = {&maxX, &maxY, &maxZ};
+    double sum[3] = {}, sumSquares[3] = {}, extent[3] = {};
+    for (uint32_t body = 0; body < alive.size(); body++) {
+        if (!alive[body]) {
+            continue;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            double center = 0.5 * (static_cast<double>((*mins[axis])[body]) + (*maxs[axis])[body]);
+            sum[axis] += center;
+            sumSquares[axis] += center * center;
+            extent[axis] += static_cast<double>((*maxs[axis])[body]) - (*mins[axis])[body];
+        }
+    }
+    double bestVariance = -1.0;
+    for (int axis = 0; axis < 3; axis++) {
+        double variance = bodyCount ? sumSquares[axis] - sum[axis] * sum[axis] / static_cast<double>(bodyCount) : 0.0;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            sweepAxis = axis;
+        }
+    }
+    int axes[3] = {sweepAxis, (sweepAxis + 1) % 3, (sweepAxis + 2) % 3};
+    activeCellSize = cellSize;
+    if (activeCellSize <= 0.0f) {
+        double meanExtent = bodyCount ? (extent[axes[1]] + extent[axes[2]]) / (2.0 * static_cast<double>(bodyCount)) : 0.0;
+        activeCellSize = meanExtent > 0.0 ? static_cast<float>(2.0 * meanExtent) : 1.0f;
+    }
+    float inverseCellSize = 1.0f / activeCellSize;
+
+    // Cell range and sweep-axis range of the gridded bodies, to size the sort key
+    const std::vector<float>& sweepMins = *mins[axes[0]];
+    const std::vector<float>& sweepMaxs = *maxs[axes[0]];
+    const std::vector<float>& uMins = *mins[axes[1]];
+    const std::vector<float>& uMaxs = *maxs[axes[1]];
+    const std::vector<float>& vMins = *mins[axes[2]];
+    const std::vector<float>& vMaxs = *maxs[axes[2]];
+    oversized.clear();
+    int32_t uLow = INT32_MAX, uHigh = INT32_MIN, vLow = INT32_MAX, vHigh = INT32_MIN;
+    float sweepLow = FLT_MAX, sweepHigh = -FLT_MAX;
+    for (uint32_t body = 0; body < alive.size(); body++) {
+        if (!alive[body]) {
+            continue;
+        }
+        int32_t u0 = cell_of(uMins[body], inverseCellSize), u1 = cell_of(uMaxs[body], inverseCellSize);
+        int32_t v0 = cell_of(vMins[body], inverseCellSize), v1 = cell_of(vMaxs[body], inverseCellSize);
+        if (u1 - u0 >= MAX_COLUMN_SPAN || v1 - v0 >= MAX_COLUMN_SPAN) {
+            oversized.push_back(body);
+            continue;
+        }
+        uLow = std::min(uLow, u0);
+        uHigh = std::max(uHigh, u1);
+        vLow = std::min(vLow, v0);
+        vHigh = std::max(vHigh, v1);
+        sweepLow = std::min(sweepLow, sweepMins[body]);
+        sweepHigh = std::max(sweepHigh, sweepMaxs[body]);
+    }
+    uint64_t vSpan = vLow <= vHigh ? static_cast<uint64_t>(static_cast<int64_t>(vHigh) - vLow + 1) : 1;
+    uint64_t columnCount = uLow <= uHigh ? static_cast<uint64_t>(static_cast<int64_t>(uHigh) - uLow + 1) * vSpan : 1;
+    float quantize = sweepHigh > sweepLow ? static_cast<float>((1u << ENDPOINT_BITS) - 1) / (sweepHigh - sweepLow) : 0.0f;
+    auto quantized = [&](float value) {
+        float scaled = std::clamp((value - sweepLow) * quantize, 0.0f, static_cast<float>((1u << ENDPOINT_BITS) - 1));
+        return static_cast<uint32_t>(scaled);
+    };
+
+    entries.clear();
+    for (uint32_t body = 0; body < alive.size(); body++) {
+        if (!alive[body]) {
+            continue;
+        }
+        int32_t u0 = cell_of(uMins[body], inverseCellSize), u1 = cell_of(uMaxs[body], inverseCellSize);
+        int32_t v0 = cell_of(vMins[body], inverseCellSize), v1 = cell_of(vMaxs[body], inverseCellSize);
+        if (u1 - u0 >= MAX_COLUMN_SPAN || v1 - v0 >= MAX_COLUMN_SPAN) {
+            continue;
+        }
+        uint64_t endpoint = quantized(sweepMins[body]);
+        for (int32_t u = u0; u <= u1; u++) {
+            for (int32_t v = v0; v <= v1; v++) {
+                uint64_t column = static_cast<uint64_t>(u - uLow) * vSpan + static_cast<uint64_t>(v - vLow);
+                entries.push_back({column << ENDPOINT_BITS | endpoint, body});
+            }
+        }
+    }
+    if (!entries.empty()) {
+        radix_sort(entries, entryScratch, bit_width(columnCount - 1) + ENDPOINT_BITS);
+    }
+
+    // Gathered once into sweep order so the sweep reads every array linearly
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    sweepKey.resize(count);
+    sweepUpperKey.resize(count);
+    sweepBody.resize(count);
+    sweepCellU.resize(count);
+    sweepCellV.resize(count);
+    for (int i = 0; i < 3; i++) {
+        sweepMin[i].resize(count);
+        sweepMax[i].resize(count);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const SweepEntry& entry = entries[i];
+        uint64_t column = entry.key >> ENDPOINT_BITS;
+        sweepKey[i] = entry.key;
+        sweepUpperKey[i] = quantized(sweepMaxs[entry.body]);
+        sweepBody[i] = entry.body;
+        sweepCellU[i] = static_cast<int32_t>(static_cast<int64_t>(column / vSpan) + uLow);
+        sweepCellV[i] = static_cast<int32_t>(static_cast<int64_t>(column % vSpan) + vLow);
+        for (int k = 0; k < 3; k++) {
+            sweepMin[k][i] = (*mins[axes[k]])[entry.body];
+            sweepMax[k][i] = (*maxs[axes[k]])[entry.body];
+        }
+    }
+
+    // Sweep ranges first, then one task per oversized body
+    uint32_t ranges = 1;
+    if (jobs && count >= 2 * MIN_BODIES_PER_RANGE) {
+        ranges = std::min(jobs->get_worker_count() * SWEEP_RANGES_PER_WORKER, count / MIN_BODIES_PER_RANGE);
+    }
+    uint32_t tasks = ranges + static_cast<uint32_t>(oversized.size());
+    rangePairs.resize(std::max<size_t>(rangePairs.size(), tasks));
+    rangeCandidates.assign(tasks, 0);
+    auto run_tasks = [&](uint32_t first, uint32_t last) {
+        for (uint32_t task = first; task < last; task++) {
+            std::vector<uint64_t>& out = rangePairs[task];
+            out.clear();
+            if (task < ranges) {
+                uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * task / ranges);
+                uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (task + 1) / ranges);
+                sweep(begin, end, out, rangeCandidates[task]);
+                continue;
+            }
+            uint32_t big = oversized[task - ranges];
+            for (uint32_t body = 0; body < alive.size(); body++) {
+                bool otherOversized = std::binary_search(oversized.begin(), oversized.end(), body);
+                if (!alive[body] || body == big || (otherOversized && body < big)) {
+                    continue;
+                }
+                if (overlaps(minX.data(), maxX.data(), big, body) && overlaps(minY.data(), maxY.data(), big, body) &&
+                    overlaps(minZ.data(), maxZ.data(), big, body)) {
+                    out.push_back(static_cast<uint64_t>(std::min(big, body)) << 32 | std::max(big, body));
+                }
+            }
+            rangeCandidates[task] = bodyCount - 1;
+        }
+    };
+    if (jobs && tasks > 1) {
+        jobs->parallel_for(0, tasks, run_tasks, 1);
+    } else {
+        run_tasks(0, tasks);
+    }
+
+    previousKeys.swap(pairKeys);
+    pairKeys.clear();
+    candidateCount = 0;
+    for (uint32_t task = 0; task < tasks; task++) {
+        pairKeys.insert(pairKeys.end(), rangePairs[task].begin(), rangePairs[task].end());
+        candidateCount += rangeCandidates[task];
+    }
+    if (!pairKeys.empty()) {
+        radix_sort(pairKeys, pairScratch, 64);
+    }
+    // Both lists are sorted, so one merge pass finds what began and what ended
+    pairs.resize(pairKeys.size());
+    for (size_t i = 0; i < pairKeys.size(); i++) {
+        pairs[i] = pair_from_key(pairKeys[i]);
+    }
+    addedPairs.clear();
+    removedPairs.clear();
+    size_t i = 0, j = 0;
+    while (i < pairKeys.size() || j < previousKeys.size()) {
+        if (j == previousKeys.size() || (i < pairKeys.size() && pairKeys[i] < previousKeys[j])) {
+            addedPairs.push_back(pair_from_key(pairKeys[i++]));
+        } else if (i == pairKeys.size() || previousKeys[j] < pairKeys[i]) {
+            removedPairs.push_back(pair_from_key(previousKeys[j++]));
+        } else {
+            i++;
+            j++;
+        }
+    }
+
+    // Handles freed since the last update are only reused now that their pairs were diffed
+    freeBodies.insert(freeBodies.end(), releasedBodies.begin(), releasedBodies.end());
+    releasedBodies.clear();
+}
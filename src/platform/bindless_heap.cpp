@@ -0,0 +1,262 @@
+#include "platform/bindless_heap.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+// Upper bounds before device limits are applied
+constexpr uint32_t MAX_SAMPLED_IMAGES = 65536;
+constexpr uint32_t MAX_SAMPLERS = 2048;
+constexpr uint32_t MAX_STORAGE_BUFFERS = 65536;
+}
+
+DescriptorIndexAllocator::DescriptorIndexAllocator(uint32_t capacity)
+    : capacityLimit(capacity) {}
+
+uint32_t DescriptorIndexAllocator::allocate() {
+    if (!freeList.empty()) {
+        uint32_t index = freeList.back();
+        freeList.pop_back();
+        inUse[index] = true;
+        return index;
+    }
+    if (nextIndex >= capacityLimit) {
+        return INVALID_INDEX;
+    }
+    inUse.push_back(true);
+    return nextIndex++;
+}
+
+void DescriptorIndexAllocator::release(uint32_t index) {
+    if (index >= nextIndex) {
+        return;
+    }
+    // A second release would put the slot on the free list twice and hand it to two owners
+    if (!inUse[index]) {
+        throw std::runtime_error("Descriptor index released twice!");
+    }
+    inUse[index] = false;
+    freeList.push_back(index);
+}
+
+BindlessHeap::BindlessHeap(VkPhysicalDevice physicalDevice, VkDevice device)
+    : device(device) {
+    VkPhysicalDeviceVulkan12Properties props12{};
+    props12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    VkPhysicalDeviceProperties2 props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &props12;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &props);
+
+    uint32_t counts[3] = {
+        std::min({MAX_SAMPLED_IMAGES, props12.maxDescriptorSetUpdateAfterBindSampledImages,
+                  props12.maxPerStageDescriptorUpdateAfterBindSampledImages}),
+        std::min({MAX_SAMPLERS, props12.maxDescriptorSetUpdateAfterBindSamplers,
+                  props12.maxPerStageDescriptorUpdateAfterBindSamplers}),
+        std::min({MAX_STORAGE_BUFFERS, props12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                  props12.maxPerStageDescriptorUpdateAfterBindStorageBuffers}),
+    };
+
+    // Every binding is visible to all stages, so together they must also fit the per-stage
+    // resource limit, less the fragment stage's color attachments that count towards it
+    uint64_t total = uint64_t(counts[0]) + counts[1] + counts[2];
+    uint32_t attachments = props.properties.limits.maxColorAttachments;
+    uint32_t limit = props12.maxPerStageUpdateAfterBindResources;
+    uint64_t budget = limit > attachments ? limit - attachments : 0;
+    if (total > budget) {
+        for (uint32_t& count : counts) {
+            count = std::max<uint32_t>(1, static_cast<uint32_t>(count * budget / total));
+        }
+        std::cout << "[Bindless] Scaled descriptor counts down to fit " << limit << " resources per stage.\n";
+    }
+
+    images = DescriptorIndexAllocator(counts[0]);
+    samplers = DescriptorIndexAllocator(counts[1]);
+    storageBuffers = DescriptorIndexAllocator(counts[2]);
+
+    create_layout();
+    create_pool_and_set();
+
+    std::cout << "[Bindless] Heap created: " << images.capacity() << " images, "
+              << samplers.capacity() << " samplers, " << storageBuffers.capacity() << " storage buffers.\n";
+}
+
+BindlessHeap::~BindlessHeap() {
+    vkDestroyDescriptorPool(device, pool, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+}
+
+bool BindlessHeap::is_supported(const VkPhysicalDeviceVulkan12Features& features) {
+    return features.descriptorIndexing &&
+           features.runtimeDescriptorArray &&
+           features.descriptorBindingPartiallyBound &&
+           features.descriptorBindingUpdateUnusedWhilePending &&
+           features.descriptorBindingSampledImageUpdateAfterBind &&
+           features.descriptorBindingStorageBufferUpdateAfterBind &&
+           features.shaderSampledImageArrayNonUniformIndexing &&
+           features.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+void BindlessHeap::create_layout() {
+    VkDescriptorSetLayoutBinding bindings[3]{};
+    bindings[SAMPLED_IMAGE_BINDING] = {SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                                       images.capacity(), VK_SHADER_STAGE_ALL, nullptr};
+    bindings[SAMPLER_BINDING] = {SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER,
+                                 samplers.capacity(), VK_SHADER_STAGE_ALL, nullptr};
+    bindings[STORAGE_BUFFER_BINDING] = {STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                        storageBuffers.capacity(), VK_SHADER_STAGE_ALL, nullptr};
+
+    const VkDescriptorBindingFlags bindingFlag = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorBindingFlags bindingFlags[3] = {bindingFlag, bindingFlag, bindingFlag};
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = 3;
+    flagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 3;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor set layout!");
+    }
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_ALL;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(BindlessPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless pipeline layout!");
+    }
+}
+
+void BindlessHeap::create_pool_and_set() {
+    VkDescriptorPoolSize poolSizes[3] = {
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, images.capacity()},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, samplers.capacity()},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers.capacity()},
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 3;
+    poolInfo.pPoolSizes = poolSizes;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate bindless descriptor set!");
+    }
+}
+
+uint32_t BindlessHeap::register_image(VkImageView view, VkImageLayout layout) {
+    uint32_t index = images.allocate();
+    if (index == DescriptorIndexAllocator::INVALID_INDEX) {
+        throw std::runtime_error("Bindless heap is out of sampled image slots!");
+    }
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = SAMPLED_IMAGE_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return index;
+}
+
+uint32_t BindlessHeap::register_sampler(VkSampler sampler) {
+    uint32_t index = samplers.allocate();
+    if (index == DescriptorIndexAllocator::INVALID_INDEX) {
+        throw std::runtime_error("Bindless heap is out of sampler slots!");
+    }
+
+    VkDescriptorImageInfo samplerInfo{};
+    samplerInfo.sampler = sampler;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = SAMPLER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    write.pImageInfo = &samplerInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return index;
+}
+
+uint32_t BindlessHeap::register_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    uint32_t index = storageBuffers.allocate();
+    if (index == DescriptorIndexAllocator::INVALID_INDEX) {
+        throw std::runtime_error("Bindless heap is out of storage buffer slots!");
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = STORAGE_BUFFER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return index;
+}
+
+// Partially bound arrays let a released slot keep its stale descriptor until it is reused
+void BindlessHeap::release_image(uint32_t index) {
+    images.release(index);
+}
+
+void BindlessHeap::release_sampler(uint32_t index) {
+    samplers.release(index);
+}
+
+void BindlessHeap::release_storage_buffer(uint32_t index) {
+    storageBuffers.release(index);
+}
+
+void BindlessHeap::bind(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint) const {
+    vkCmdBindDescriptorSets(cmdBuffer, bindPoint, pipelineLayout, 0, 1, &set, 0, nullptr);
+}
+
+void BindlessHeap::push_constants(VkCommandBuffer cmdBuffer, const BindlessPushConstants& constants) const {
+    vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(BindlessPushConstants), &constants);
+}
@@ -0,0 +1,23 @@
+#include "platform/deletion_queue.hpp"
+
+DeletionQueue::~DeletionQueue() {
+    flush();
+}
+
+void DeletionQueue::retire(uint64_t frame, std::function<void()> destroy) {
+    entries.push_back({frame, std::move(destroy)});
+}
+
+void DeletionQueue::collect(uint64_t completedFrame) {
+    while (!entries.empty() && entries.front().frame <= completedFrame) {
+        entries.front().destroy();
+        entries.pop_front();
+    }
+}
+
+void DeletionQueue::flush() {
+    while (!entries.empty()) {
+        entries.front().destroy();
+        entries.pop_front();
+    }
+}
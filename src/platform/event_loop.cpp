@@ -0,0 +1,153 @@
+#include "platform/event_loop.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+constexpr int MAX_EVENTS = 16;
+}
+
+EventLoop::EventLoop(wl_display* display) : display(display), displayFd(wl_display_get_fd(display)) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Failed to create epoll instance!");
+    }
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        close(epollFd);
+        throw std::runtime_error("Failed to create wake eventfd!");
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = displayFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, displayFd, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+EventLoop::~EventLoop() {
+    close(wakeFd);
+    close(epollFd);
+}
+
+void EventLoop::watch(int fd, Handler handler) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        throw std::runtime_error("Failed to watch file descriptor!");
+    }
+    handlers[fd] = std::move(handler);
+}
+
+void EventLoop::unwatch(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    handlers.erase(fd);
+}
+
+void EventLoop::post(Handler task) {
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        posted.push_back(std::move(task));
+    }
+    wake();
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written; // EAGAIN means the counter is already non-zero, so the loop wakes anyway
+}
+
+void EventLoop::run_posted() {
+    uint64_t count;
+    while (read(wakeFd, &count, sizeof(count)) > 0) {
+    }
+
+    std::vector<Handler> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        tasks.swap(posted);
+    }
+    for (Handler& task : tasks) {
+        task();
+    }
+}
+
+bool EventLoop::run_once(int timeoutMs) {
+    // Queued events must be dispatched before the read may be prepared
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) < 0) {
+            return false;
+        }
+    }
+
+    // A full socket buffer leaves requests queued; watch for writability instead of blocking
+    bool backedUp = false;
+    if (wl_display_flush(display) < 0) {
+        if (errno != EAGAIN) {
+            wl_display_cancel_read(display);
+            return false;
+        }
+        backedUp = true;
+    }
+    if (backedUp != watchingWritable) {
+        epoll_event event{};
+        event.events = backedUp ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = displayFd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, displayFd, &event);
+        watchingWritable = backedUp;
+    }
+
+    epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (count < 0) {
+        wl_display_cancel_read(display);
+        return errno == EINTR;
+    }
+
+    bool displayReadable = false;
+    bool displayFailed = false;
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.fd == displayFd) {
+            displayReadable = (events[i].events & EPOLLIN) != 0;
+            displayFailed = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+        }
+    }
+
+    // The read intent is settled before any handler runs, since handlers may issue requests
+    if (displayReadable) {
+        if (wl_display_read_events(display) < 0) {
+            return false;
+        }
+    } else {
+        wl_display_cancel_read(display);
+        if (displayFailed) {
+            return false;
+        }
+    }
+    if (wl_display_dispatch_pending(display) < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == displayFd) {
+            continue;
+        }
+        if (fd == wakeFd) {
+            run_posted();
+            continue;
+        }
+        auto handler = handlers.find(fd);
+        if (handler != handlers.end()) {
+            Handler run = handler->second; // The handler may unwatch its own fd
+            run();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,325 @@
+#include "platform/frame_capture.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+void put_u32_be(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Reference QOI encoder (qoiformat.org), RGBA input
+std::vector<uint8_t> encode_qoi(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> out;
+    out.reserve(14 + static_cast<size_t>(width) * height * 2);
+    const uint8_t magic[4] = {'q', 'o', 'i', 'f'};
+    out.insert(out.end(), magic, magic + 4);
+    put_u32_be(out, width);
+    put_u32_be(out, height);
+    out.push_back(4); // Channels
+    out.push_back(0); // sRGB with linear alpha
+
+    std::array<uint32_t, 64> index{};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    uint32_t run = 0;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint8_t* px = rgba + i * 4;
+        if (std::memcmp(px, prev, 4) == 0) {
+            if (++run == 62 || i + 1 == pixelCount) {
+                out.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+            run = 0;
+        }
+
+        uint32_t packed;
+        std::memcpy(&packed, px, 4);
+        uint32_t hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (index[hash] == packed) {
+            out.push_back(static_cast<uint8_t>(hash));
+        } else {
+            index[hash] = packed;
+            if (px[3] == prev[3]) {
+                // Channel deltas wrap around like the reference encoder's signed chars
+                int dr = static_cast<int8_t>(px[0] - prev[0]);
+                int dg = static_cast<int8_t>(px[1] - prev[1]);
+                int db = static_cast<int8_t>(px[2] - prev[2]);
+                int drg = dr - dg;
+                int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back(static_cast<uint8_t>(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    out.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+                    out.push_back(static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8)));
+                } else {
+                    out.push_back(0xfe);
+                    out.insert(out.end(), px, px + 3);
+                }
+            } else {
+                out.push_back(0xff);
+                out.insert(out.end(), px, px + 4);
+            }
+        }
+        std::memcpy(prev, px, 4);
+    }
+
+    const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    out.insert(out.end(), padding, padding + 8);
+    return out;
+}
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put_png_chunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+    put_u32_be(out, static_cast<uint32_t>(data.size()));
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32_be(out, crc32(out.data() + typeStart, data.size() + 4));
+}
+
+// PNG with stored (uncompressed) deflate blocks, RGBA input
+std::vector<uint8_t> encode_png(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> raw;
+    raw.reserve((static_cast<size_t>(width) * 4 + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0); // Filter: none
+        const uint8_t* row = rgba + static_cast<size_t>(y) * width * 4;
+        raw.insert(raw.end(), row, row + static_cast<size_t>(width) * 4);
+    }
+
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    for (size_t offset = 0; offset < raw.size(); offset += 65535) {
+        size_t length = std::min<size_t>(65535, raw.size() - offset);
+        bool last = offset + length >= raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(length));
+        zlib.push_back(static_cast<uint8_t>(length >> 8));
+        zlib.push_back(static_cast<uint8_t>(~length));
+        zlib.push_back(static_cast<uint8_t>(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        if (last) {
+            break;
+        }
+    }
+    put_u32_be(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> header;
+    put_u32_be(header, width);
+    put_u32_be(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA, no interlace
+    put_png_chunk(out, "IHDR", header);
+    put_png_chunk(out, "IDAT", zlib);
+    put_png_chunk(out, "IEND", {});
+    return out;
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(VkPhysicalDevice physicalDevice, VkDevice device, RetireFn retire, std::string directory,
+                           CaptureFormat format, uint32_t interval, uint32_t slotCount)
+    : physicalDevice(physicalDevice), device(device), retire(std::move(retire)), directory(std::move(directory)),
+      format(format), interval(interval ? interval : 1) {
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        slots.push_back(std::make_unique<Slot>());
+    }
+    worker = std::thread(&FrameCapture::worker_loop, this);
+    std::cout << "[Capture] Writing every " << this->interval << " frame(s) to " << this->directory << "\n";
+}
+
+FrameCapture::~FrameCapture() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    // Owners destroy this after the device is idle, so buffers can go immediately
+    for (auto& slot : slots) {
+        destroy_gpu_buffer(device, slot->buffer);
+    }
+
+    Stats final = get_stats();
+    double perFrame = final.captured ? final.recordMicroseconds / static_cast<double>(final.captured) : 0.0;
+    std::cout << "[Capture] " << final.captured << " captured, " << final.dropped << " dropped, "
+              << perFrame << " us render-thread cost per capture\n";
+}
+
+void FrameCapture::add_to_graph(RenderGraph& graph, RGHandle image, VkExtent2D extent, VkFormat imageFormat,
+                                uint64_t frame) {
+    if (framesSeen++ % interval != 0) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    Slot* target = nullptr;
+    for (auto& slot : slots) {
+        if (slot->state.load(std::memory_order_acquire) == SLOT_FREE) {
+            target = slot.get();
+            break;
+        }
+    }
+    if (!target) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.dropped++;
+        return;
+    }
+
+    VkDeviceSize bytes = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    if (target->buffer.size < bytes) {
+        if (target->buffer.buffer != VK_NULL_HANDLE) {
+            GpuBuffer old = target->buffer;
+            VkDevice dev = device;
+            retire([dev, old]() mutable { destroy_gpu_buffer(dev, old); });
+        }
+        // Cached memory keeps the encoder's reads fast
+        target->buffer = create_gpu_buffer(physicalDevice, device, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    }
+    target->frame = frame;
+    target->extent = extent;
+    target->swizzle = imageFormat == VK_FORMAT_B8G8R8A8_UNORM || imageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+    target->state.store(SLOT_IN_FLIGHT, std::memory_order_release);
+
+    VkBuffer destination = target->buffer.buffer;
+    graph.add_pass("capture",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.read(image, RGUsage::TransferSrc);
+            builder.side_effect();
+        },
+        [&graph, image, destination, extent](VkCommandBuffer cmdBuffer) {
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            region.imageExtent = {extent.width, extent.height, 1};
+            vkCmdCopyImageToBuffer(cmdBuffer, graph.get_image(image), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   destination, 1, &region);
+
+            // The fence alone does not make the copy visible to host reads
+            VkMemoryBarrier2 toHost{};
+            toHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            toHost.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+            toHost.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            toHost.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+            toHost.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+            VkDependencyInfo dependency{};
+            dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependency.memoryBarrierCount = 1;
+            dependency.pMemoryBarriers = &toHost;
+            vkCmdPipelineBarrier2(cmdBuffer, &dependency);
+        });
+
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.recordMicroseconds += elapsed;
+}
+
+void FrameCapture::collect(uint64_t completedFrame) {
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& slot : slots) {
+            if (slot->state.load(std::memory_order_acquire) == SLOT_IN_FLIGHT && slot->frame <= completedFrame) {
+                slot->state.store(SLOT_ENCODING, std::memory_order_release);
+                pending.push_back(slot.get());
+                queued = true;
+            }
+        }
+    }
+    if (queued) {
+        wake.notify_one();
+    }
+}
+
+FrameCapture::Stats FrameCapture::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void FrameCapture::worker_loop() {
+    while (true) {
+        Slot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                return; // Stopping with nothing left to write
+            }
+            slot = pending.front();
+            pending.pop_front();
+        }
+        encode(*slot);
+        slot->state.store(SLOT_FREE, std::memory_order_release);
+    }
+}
+
+void FrameCapture::encode(Slot& slot) {
+    auto start = std::chrono::steady_clock::now();
+
+    const size_t pixelBytes = static_cast<size_t>(slot.extent.width) * slot.extent.height * 4;
+    std::vector<uint8_t> rgba(pixelBytes);
+    std::memcpy(rgba.data(), slot.buffer.mapped, pixelBytes);
+    if (slot.swizzle) {
+        for (size_t i = 0; i < pixelBytes; i += 4) {
+            std::swap(rgba[i], rgba[i + 2]);
+        }
+    }
+
+    std::vector<uint8_t> encoded = format == CaptureFormat::Qoi
+        ? encode_qoi(rgba.data(), slot.extent.width, slot.extent.height)
+        : encode_png(rgba.data(), slot.extent.width, slot.extent.height);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "/frame_%08llu.%s", static_cast<unsigned long long>(slot.frame),
+                  format == CaptureFormat::Qoi ? "qoi" : "png");
+    std::ofstream file(directory + name, std::ios::binary);
+    if (!file) {
+        std::cerr << "[Capture] Failed to open " << directory << name << std::endl;
+    } else {
+        file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.captured++;
+    stats.encodeMilliseconds += elapsed;
+}
@@ -0,0 +1,95 @@
+#include "platform/frame_pacer.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+constexpr double MAX_REFRESH_INTERVAL_MS = 100.0; // Longer gaps are hidden periods, not refresh
+}
+
+const wl_callback_listener FramePacer::frameListener = {
+    .done = FramePacer::frame_done
+};
+
+FramePacer::FramePacer(EventLoop& loop, wl_surface* surface, uint32_t fallbackHz)
+    : loop(loop), surface(surface), refreshIntervalMs(1000.0 / std::max(fallbackHz, 1u)) {
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timerFd < 0) {
+        throw std::runtime_error("Failed to create frame pacing timer!");
+    }
+
+    // tv_nsec must stay below a second, which 1 Hz alone already reaches
+    uint64_t periodNs = 1000000000ull / std::max(fallbackHz, 1u);
+    itimerspec period{};
+    period.it_interval.tv_sec = static_cast<time_t>(periodNs / 1000000000ull);
+    period.it_interval.tv_nsec = static_cast<long>(periodNs % 1000000000ull);
+    period.it_value = period.it_interval;
+    if (timerfd_settime(timerFd, 0, &period, nullptr) != 0) {
+        close(timerFd);
+        throw std::runtime_error("Failed to arm frame pacing timer!");
+    }
+    loop.watch(timerFd, [this]() { on_timer(); });
+}
+
+FramePacer::~FramePacer() {
+    if (callback) {
+        wl_callback_destroy(callback);
+    }
+    if (!callbacksSeen) {
+        loop.unwatch(timerFd);
+    }
+    close(timerFd);
+}
+
+void FramePacer::request_frame() {
+    if (callback) {
+        return; // Still waiting on the previous one; it fires on the next repaint either way
+    }
+    callback = wl_surface_frame(surface);
+    wl_callback_add_listener(callback, &frameListener, this);
+}
+
+void FramePacer::frame_done(void* data, wl_callback* callback, uint32_t time) {
+    FramePacer* pacer = static_cast<FramePacer*>(data);
+    wl_callback_destroy(callback);
+    pacer->callback = nullptr;
+    pacer->frameDue = true;
+
+    if (pacer->callbacksSeen) {
+        double interval = static_cast<double>(time - pacer->lastCallbackTime);
+        if (interval > 0.0 && interval < MAX_REFRESH_INTERVAL_MS) {
+            pacer->refreshIntervalMs += (interval - pacer->refreshIntervalMs) * 0.1;
+        }
+    } else {
+        // The compositor drives pacing from now on; the timer would only add stray frames
+        itimerspec disarm{};
+        timerfd_settime(pacer->timerFd, 0, &disarm, nullptr);
+        pacer->loop.unwatch(pacer->timerFd);
+        pacer->callbacksSeen = true;
+        std::cout << "[FramePacer] Pacing on wl_surface.frame callbacks.\n";
+    }
+    pacer->lastCallbackTime = time;
+}
+
+void FramePacer::on_timer() {
+    uint64_t expirations;
+    if (read(timerFd, &expirations, sizeof(expirations)) > 0) {
+        frameDue = true;
+    }
+}
+
+FramePacer::Wake FramePacer::wait() {
+    if (!frameDue) {
+        // No timeout: with callbacks, a hidden surface sleeps here until it is shown again
+        if (!loop.run_once(-1)) {
+            return Wake::Error;
+        }
+    }
+    if (frameDue) {
+        frameDue = false;
+        return Wake::Frame;
+    }
+    return Wake::Events;
+}
@@ -0,0 +1,135 @@
+#include "platform/frame_ring_buffer.hpp"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+constexpr VkDeviceSize MAX_UNIFORM_RANGE = 65536;
+
+// Any alignment, not only powers of two: vertex strides such as 12 bytes are valid
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+FrameRingBuffer::FrameRingBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bytesPerFrame,
+                                 uint32_t frameCount, bool deviceAddress)
+    : device(device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    uniformAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+    uniformRange = std::min<VkDeviceSize>(properties.limits.maxUniformBufferRange, MAX_UNIFORM_RANGE);
+    this->bytesPerFrame = align_up(bytesPerFrame, uniformAlignment);
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (deviceAddress) {
+        usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+
+    // The tail padding keeps offset + uniformRange inside the buffer for the last allocation
+    buffer = create_gpu_buffer(physicalDevice, device, this->bytesPerFrame * frameCount + uniformRange, usage,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (deviceAddress) {
+        VkBufferDeviceAddressInfo addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = buffer.buffer;
+        baseAddress = vkGetBufferDeviceAddress(device, &addressInfo);
+    }
+
+    create_descriptor_set();
+    begin_frame(0);
+
+    std::cout << "[FrameRing] " << frameCount << " x " << (this->bytesPerFrame / 1024) << " KiB streaming regions.\n";
+}
+
+FrameRingBuffer::~FrameRingBuffer() {
+    vkDestroyDescriptorPool(device, pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    destroy_gpu_buffer(device, buffer);
+}
+
+void FrameRingBuffer::create_descriptor_set() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create ring buffer descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create ring buffer descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate ring buffer descriptor set!");
+    }
+
+    // Written once; every draw selects its data with a dynamic offset
+    VkDescriptorBufferInfo bufferInfo{buffer.buffer, 0, uniformRange};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void FrameRingBuffer::begin_frame(uint32_t frameSlot) {
+    regionStart = bytesPerFrame * frameSlot;
+    cursor = regionStart;
+}
+
+FrameRingBuffer::Allocation FrameRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    // A multiple of both the requested alignment and the 4-byte minimum
+    VkDeviceSize offset = align_up(cursor, std::lcm<VkDeviceSize>(std::max<VkDeviceSize>(alignment, 1), 4));
+    if (offset + size > regionStart + bytesPerFrame) {
+        throw std::runtime_error("Frame ring buffer exhausted; raise its per-frame size!");
+    }
+    cursor = offset + size;
+    peakUsage = std::max(peakUsage, cursor - regionStart);
+
+    Allocation allocation;
+    allocation.buffer = buffer.buffer;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.data = static_cast<uint8_t*>(buffer.mapped) + offset;
+    allocation.address = baseAddress ? baseAddress + offset : 0;
+    return allocation;
+}
+
+FrameRingBuffer::Allocation FrameRingBuffer::allocate_uniform(VkDeviceSize size) {
+    if (size > uniformRange) {
+        throw std::runtime_error("Uniform allocation exceeds the dynamic uniform range!");
+    }
+    return allocate(size, uniformAlignment);
+}
+
+void FrameRingBuffer::bind_uniform(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout,
+                                   uint32_t setIndex, const Allocation& allocation) const {
+    uint32_t dynamicOffset = allocation.dynamic_offset();
+    vkCmdBindDescriptorSets(cmdBuffer, bindPoint, layout, setIndex, 1, &set, 1, &dynamicOffset);
+}
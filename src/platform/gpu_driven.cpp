@@ -0,0 +1,375 @@
+#include "platform/gpu_driven.hpp"
+#include "platform/shader_module.hpp"
+#include "platform/vulkan_context.hpp"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+constexpr uint32_t CULL_BINDINGS = 5;
+}
+
+GpuDrivenRenderer::GpuDrivenRenderer(VulkanContext& context, uint32_t maxInstances, uint32_t maxMeshes,
+                                     uint32_t bucketCount)
+    : context(context), device(context.get_device()), maxInstances(maxInstances), maxMeshes(maxMeshes),
+      compactDraws(context.supports_draw_indirect_count()), buckets(bucketCount), stagedBucketOffsets(bucketCount, 0),
+      frames(VulkanContext::MAX_FRAMES_IN_FLIGHT) {
+    if (!context.supports_multi_draw_indirect()) {
+        throw std::runtime_error("GPU-driven rendering requires multiDrawIndirect!");
+    }
+
+    create_buffers();
+    create_cull_pipeline();
+
+    if (BindlessHeap* heap = context.get_bindless_heap()) {
+        for (FrameInputs& frame : frames) {
+            frame.instanceBufferIndex = heap->register_storage_buffer(frame.instanceBuffer.buffer);
+        }
+    }
+
+    std::cout << "[GpuDriven] " << maxInstances << " instances, " << bucketCount << " buckets, "
+              << (compactDraws ? "vkCmdDrawIndexedIndirectCount" : "vkCmdDrawIndexedIndirect fallback") << "\n";
+}
+
+GpuDrivenRenderer::~GpuDrivenRenderer() {
+    if (BindlessHeap* heap = context.get_bindless_heap()) {
+        for (FrameInputs& frame : frames) {
+            if (frame.instanceBufferIndex != UINT32_MAX) {
+                heap->release_storage_buffer(frame.instanceBufferIndex);
+            }
+        }
+    }
+
+    vkDestroyPipeline(device, cullPipeline, nullptr);
+    vkDestroyPipelineLayout(device, cullLayout, nullptr);
+    vkDestroyDescriptorPool(device, cullPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, cullSetLayout, nullptr);
+
+    for (FrameInputs& frame : frames) {
+        destroy_gpu_buffer(device, frame.instanceBuffer);
+        destroy_gpu_buffer(device, frame.meshBuffer);
+        destroy_gpu_buffer(device, frame.bucketOffsetBuffer);
+    }
+    destroy_gpu_buffer(device, drawBuffer);
+    destroy_gpu_buffer(device, countBuffer);
+}
+
+void GpuDrivenRenderer::create_buffers() {
+    VkPhysicalDevice physicalDevice = context.get_physical_device();
+    const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    // CPU-written inputs prefer device-local host-visible memory (ReBAR) when it exists
+    for (FrameInputs& frame : frames) {
+        frame.instanceBuffer = create_gpu_buffer(physicalDevice, device, sizeof(GpuInstance) * maxInstances,
+                                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible,
+                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.meshBuffer = create_gpu_buffer(physicalDevice, device, sizeof(GpuMesh) * maxMeshes,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.bucketOffsetBuffer = create_gpu_buffer(physicalDevice, device, sizeof(uint32_t) * buckets.size(),
+                                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+    }
+
+    // GPU-written outputs stay in device-local memory
+    drawBuffer = create_gpu_buffer(physicalDevice, device, sizeof(VkDrawIndexedIndirectCommand) * maxInstances,
+                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    countBuffer = create_gpu_buffer(physicalDevice, device, sizeof(uint32_t) * buckets.size(),
+                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void GpuDrivenRenderer::create_cull_pipeline() {
+    VkDescriptorSetLayoutBinding bindings[CULL_BINDINGS]{};
+    for (uint32_t i = 0; i < CULL_BINDINGS; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = CULL_BINDINGS;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &cullSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create cull descriptor set layout!");
+    }
+
+    const uint32_t frameCount = VulkanContext::MAX_FRAMES_IN_FLIGHT;
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CULL_BINDINGS * frameCount};
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = frameCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &cullPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create cull descriptor pool!");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(frameCount, cullSetLayout);
+    std::vector<VkDescriptorSet> sets(frameCount);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = cullPool;
+    allocInfo.descriptorSetCount = frameCount;
+    allocInfo.pSetLayouts = setLayouts.data();
+    if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate cull descriptor set!");
+    }
+
+    // The buffers never change size, so each frame's set is written exactly once
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        FrameInputs& frame = frames[f];
+        frame.cullSet = sets[f];
+        const GpuBuffer* sources[CULL_BINDINGS] = {&frame.instanceBuffer, &frame.meshBuffer, &frame.bucketOffsetBuffer,
+                                                   &drawBuffer, &countBuffer};
+        VkDescriptorBufferInfo bufferInfos[CULL_BINDINGS];
+        VkWriteDescriptorSet writes[CULL_BINDINGS]{};
+        for (uint32_t i = 0; i < CULL_BINDINGS; ++i) {
+            bufferInfos[i] = {sources[i]->buffer, 0, VK_WHOLE_SIZE};
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.cullSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(device, CULL_BINDINGS, writes, 0, nullptr);
+    }
+
+    VkPushConstantRange pushRange{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams)};
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &cullSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &cullLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create cull pipeline layout!");
+    }
+
+    VkShaderModule module = load_shader_module(device, "gpu_cull.comp");
+
+    // Workgroup size and the draw mode are baked in, so the compact branch compiles away
+    SpecializationConstants constants;
+    constants.set(0, CULL_GROUP_SIZE).set(1, compactDraws);
+    VkSpecializationInfo specialization = constants.info();
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = &specialization;
+    pipelineInfo.layout = cullLayout;
+
+    VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullPipeline);
+    vkDestroyShaderModule(device, module, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create cull compute pipeline!");
+    }
+}
+
+void GpuDrivenRenderer::set_meshes(const std::vector<GpuMesh>& meshes) {
+    if (meshes.size() > maxMeshes) {
+        throw std::runtime_error("Too many meshes for the GPU-driven renderer!");
+    }
+    stagedMeshes = meshes;
+    staleMeshFrames = (1u << frames.size()) - 1;
+}
+
+void GpuDrivenRenderer::set_instances(const std::vector<GpuInstance>& instances) {
+    if (instances.size() > maxInstances) {
+        throw std::runtime_error("Too many instances for the GPU-driven renderer!");
+    }
+
+    // Each bucket owns a contiguous range of draw slots sized to its instance count
+    for (Bucket& bucket : buckets) {
+        bucket.count = 0;
+    }
+    for (const GpuInstance& instance : instances) {
+        if (instance.bucket >= buckets.size()) {
+            throw std::runtime_error("GPU instance references an unknown material bucket!");
+        }
+        buckets[instance.bucket].count++;
+    }
+
+    uint32_t offset = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        buckets[b].offset = offset;
+        stagedBucketOffsets[b] = offset;
+        offset += buckets[b].count;
+    }
+
+    std::vector<uint32_t> cursor(buckets.size(), 0);
+    stagedInstances = instances;
+    for (GpuInstance& instance : stagedInstances) {
+        instance.drawSlot = buckets[instance.bucket].offset + cursor[instance.bucket]++;
+    }
+    instanceCount = static_cast<uint32_t>(instances.size());
+    cullParams.instanceCount = instanceCount;
+    staleInstanceFrames = (1u << frames.size()) - 1;
+}
+
+GpuInstance* GpuDrivenRenderer::map_instances() {
+    const uint32_t frameSlot = context.get_frame_slot();
+    upload_frame(frameSlot); // A pending set_instances() copy must land before matrices are written over it
+    return static_cast<GpuInstance*>(frames[frameSlot].instanceBuffer.mapped);
+}
+
+uint32_t GpuDrivenRenderer::get_instance_buffer_index() const {
+    return frames[context.get_frame_slot()].instanceBufferIndex;
+}
+
+// Runs while the frame is recorded, after its fence wait, so the GPU is done with these copies
+void GpuDrivenRenderer::upload_frame(uint32_t frameSlot) {
+    FrameInputs& frame = frames[frameSlot];
+    const uint32_t bit = 1u << frameSlot;
+    if (staleInstanceFrames & bit) {
+        std::memcpy(frame.instanceBuffer.mapped, stagedInstances.data(), stagedInstances.size() * sizeof(GpuInstance));
+        std::memcpy(frame.bucketOffsetBuffer.mapped, stagedBucketOffsets.data(),
+                    stagedBucketOffsets.size() * sizeof(uint32_t));
+        staleInstanceFrames &= ~bit;
+    }
+    if (staleMeshFrames & bit) {
+        std::memcpy(frame.meshBuffer.mapped, stagedMeshes.data(), stagedMeshes.size() * sizeof(GpuMesh));
+        staleMeshFrames &= ~bit;
+    }
+}
+
+void GpuDrivenRenderer::set_bucket_pipeline(uint32_t bucket, VkPipeline pipeline, VkPipelineLayout layout) {
+    buckets.at(bucket).pipeline = pipeline;
+    buckets.at(bucket).layout = layout;
+    buckets.at(bucket).cached = false;
+}
+
+void GpuDrivenRenderer::set_bucket_pipeline(uint32_t bucket, const GraphicsPipelineDesc& desc) {
+    GraphicsPipelineCache* cache = context.get_pipeline_cache();
+    if (!cache) {
+        throw std::runtime_error("Pipeline cache requires the dynamic rendering path!");
+    }
+    cache->prepare(desc); // Compile the stage libraries now rather than mid-frame
+    buckets.at(bucket).desc = desc;
+    buckets.at(bucket).layout = desc.layout;
+    buckets.at(bucket).cached = true;
+}
+
+void GpuDrivenRenderer::set_geometry(VkBuffer vertexBuffer, VkBuffer indexBuffer, VkIndexType indexType) {
+    this->vertexBuffer = vertexBuffer;
+    this->indexBuffer = indexBuffer;
+    this->indexType = indexType;
+}
+
+// Gribb-Hartmann plane extraction for Vulkan's [0, 1] clip depth
+void GpuDrivenRenderer::set_view_projection(const float m[16]) {
+    auto row = [&](int r, int c) { return m[c * 4 + r]; };
+    for (int c = 0; c < 4; ++c) {
+        cullParams.planes[0][c] = row(3, c) + row(0, c); // Left
+        cullParams.planes[1][c] = row(3, c) - row(0, c); // Right
+        cullParams.planes[2][c] = row(3, c) + row(1, c); // Bottom
+        cullParams.planes[3][c] = row(3, c) - row(1, c); // Top
+        cullParams.planes[4][c] = row(2, c);             // Near
+        cullParams.planes[5][c] = row(3, c) - row(2, c); // Far
+    }
+    for (auto& plane : cullParams.planes) {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (float& value : plane) {
+                value /= length;
+            }
+        }
+    }
+}
+
+void GpuDrivenRenderer::add_to_graph(RenderGraph& graph, RGHandle colorTarget, RGHandle depthTarget) {
+    const uint32_t frameSlot = context.get_frame_slot();
+    upload_frame(frameSlot);
+    const FrameInputs& frame = frames[frameSlot];
+
+    RGHandle instances = graph.import_buffer("gpu_instances", frame.instanceBuffer.buffer, frame.instanceBuffer.size);
+    RGHandle meshes = graph.import_buffer("gpu_meshes", frame.meshBuffer.buffer, frame.meshBuffer.size);
+    RGHandle draws = graph.import_buffer("gpu_draws", drawBuffer.buffer, drawBuffer.size);
+    RGHandle counts = graph.import_buffer("gpu_draw_counts", countBuffer.buffer, countBuffer.size);
+
+    if (compactDraws) {
+        graph.add_pass("gpu_cull_reset",
+            [&](RenderGraph::PassBuilder& builder) { builder.write(counts, RGUsage::TransferDst); },
+            [this](VkCommandBuffer cmdBuffer) {
+                vkCmdFillBuffer(cmdBuffer, countBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+            });
+    }
+
+    graph.add_pass("gpu_cull",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.read(instances, RGUsage::StorageRead);
+            builder.read(meshes, RGUsage::StorageRead);
+            builder.write(draws, RGUsage::StorageWrite);
+            builder.write(counts, RGUsage::StorageWrite);
+        },
+        [this, frameSlot](VkCommandBuffer cmdBuffer) { record_cull(cmdBuffer, frameSlot); });
+
+    graph.add_pass("gpu_draw",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.color_attachment(colorTarget);
+            if (depthTarget != RG_INVALID_HANDLE) {
+                builder.depth_attachment(depthTarget);
+            }
+            builder.read(draws, RGUsage::IndirectRead);
+            builder.read(counts, RGUsage::IndirectRead);
+            builder.read(instances, RGUsage::StorageRead);
+        },
+        [this](VkCommandBuffer cmdBuffer) { record_draws(cmdBuffer); });
+}
+
+void GpuDrivenRenderer::record_cull(VkCommandBuffer cmdBuffer, uint32_t frameSlot) {
+    if (instanceCount == 0) {
+        return;
+    }
+
+    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullLayout, 0, 1, &frames[frameSlot].cullSet, 0,
+                            nullptr);
+    vkCmdPushConstants(cmdBuffer, cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &cullParams);
+    vkCmdDispatch(cmdBuffer, (instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+// One draw call per bucket regardless of how many instances survive culling
+void GpuDrivenRenderer::record_draws(VkCommandBuffer cmdBuffer) {
+    if (instanceCount == 0 || vertexBuffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    VkDeviceSize vertexOffset = 0;
+    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+    vkCmdBindIndexBuffer(cmdBuffer, indexBuffer, 0, indexType);
+
+    BindlessHeap* heap = context.get_bindless_heap();
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        const Bucket& bucket = buckets[b];
+        // Cached pipelines are looked up every frame so background upgrades get picked up
+        VkPipeline pipeline = bucket.cached ? context.get_pipeline_cache()->get(bucket.desc) : bucket.pipeline;
+        if (bucket.count == 0 || pipeline == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        if (heap && bucket.layout == heap->get_pipeline_layout()) {
+            heap->bind(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+        }
+
+        VkDeviceSize drawOffset = static_cast<VkDeviceSize>(bucket.offset) * stride;
+        if (compactDraws) {
+            vkCmdDrawIndexedIndirectCount(cmdBuffer, drawBuffer.buffer, drawOffset, countBuffer.buffer,
+                                          b * sizeof(uint32_t), bucket.count, stride);
+        } else {
+            vkCmdDrawIndexedIndirect(cmdBuffer, drawBuffer.buffer, drawOffset, bucket.count, stride);
+        }
+    }
+}
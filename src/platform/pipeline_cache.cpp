@@ -0,0 +1,454 @@
+#include "platform/pipeline_cache.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+constexpr uint64_t FNV_OFFSET = 1469598103934665603ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+void hash_bytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+template <typename T>
+void hash_value(uint64_t& hash, const T& value) {
+    hash_bytes(hash, &value, sizeof(T));
+}
+
+template <typename T>
+void hash_vector(uint64_t& hash, const std::vector<T>& values) {
+    hash_value(hash, values.size());
+    hash_bytes(hash, values.data(), values.size() * sizeof(T));
+}
+
+void hash_constants(uint64_t& hash, const SpecializationConstants& constants) {
+    hash_vector(hash, constants.get_entries());
+    hash_vector(hash, constants.get_data());
+}
+
+// Every create-info a graphics pipeline (or one of its libraries) needs, built in place
+// so the internal pointers stay valid
+struct PipelineState {
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    VkPipelineShaderStageCreateInfo stages[2]{};
+    VkSpecializationInfo specialization[2]{};
+    uint32_t stageCount = 0;
+    VkPipelineViewportStateCreateInfo viewport{};
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+    VkPipelineColorBlendStateCreateInfo colorBlend{};
+    VkDynamicState dynamicStates[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    VkPipelineRenderingCreateInfo rendering{};
+
+    explicit PipelineState(const GraphicsPipelineDesc& desc) {
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.vertexBindings.size());
+        vertexInput.pVertexBindingDescriptions = desc.vertexBindings.data();
+        vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.vertexAttributes.size());
+        vertexInput.pVertexAttributeDescriptions = desc.vertexAttributes.data();
+
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = desc.topology;
+
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = desc.vertexShader;
+        stages[0].pName = "main";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = desc.fragmentShader;
+        stages[1].pName = "main";
+        specialization[0] = desc.vertexConstants.info();
+        specialization[1] = desc.fragmentConstants.info();
+        stages[0].pSpecializationInfo = desc.vertexConstants.empty() ? nullptr : &specialization[0];
+        stages[1].pSpecializationInfo = desc.fragmentConstants.empty() ? nullptr : &specialization[1];
+        stageCount = desc.fragmentShader != VK_NULL_HANDLE ? 2 : 1; // Depth-only pipelines have no fragment stage
+
+        viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewport.viewportCount = 1;
+        viewport.scissorCount = 1;
+
+        rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterization.polygonMode = desc.polygonMode;
+        rasterization.cullMode = desc.cullMode;
+        rasterization.frontFace = desc.frontFace;
+        rasterization.lineWidth = 1.0f;
+
+        multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+        depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+        depthStencil.depthCompareOp = desc.depthCompare;
+
+        VkPipelineColorBlendAttachmentState attachment{};
+        attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        if (desc.alphaBlend) {
+            attachment.blendEnable = VK_TRUE;
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.colorBlendOp = VK_BLEND_OP_ADD;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+        }
+        blendAttachments.assign(desc.colorFormats.size(), attachment);
+        colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlend.attachmentCount = static_cast<uint32_t>(blendAttachments.size());
+        colorBlend.pAttachments = blendAttachments.data();
+
+        dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamic.dynamicStateCount = 2;
+        dynamic.pDynamicStates = dynamicStates;
+
+        rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        rendering.colorAttachmentCount = static_cast<uint32_t>(desc.colorFormats.size());
+        rendering.pColorAttachmentFormats = desc.colorFormats.data();
+        rendering.depthAttachmentFormat = desc.depthFormat;
+    }
+
+    PipelineState(const PipelineState&) = delete;
+    PipelineState& operator=(const PipelineState&) = delete;
+};
+}
+
+GraphicsPipelineCache::GraphicsPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, RetireFn retire,
+                                             bool useLibraries, std::string cachePath)
+    : physicalDevice(physicalDevice), device(device), retire(std::move(retire)), useLibraries(useLibraries),
+      cachePath(std::move(cachePath)) {
+    load_cache_file();
+    if (useLibraries) {
+        worker = std::thread(&GraphicsPipelineCache::worker_loop, this);
+    }
+    std::cout << "[Pipelines] " << (useLibraries ? "graphics pipeline libraries with background optimization"
+                                                 : "monolithic compiles") << "\n";
+}
+
+GraphicsPipelineCache::~GraphicsPipelineCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    // The owner idles the device first, so nothing here can still be in use
+    for (UpgradeJob& job : finished) {
+        vkDestroyPipeline(device, job.result, nullptr);
+    }
+    for (auto& entry : pipelines) {
+        vkDestroyPipeline(device, entry.second.pipeline, nullptr);
+    }
+    for (auto& parts : libraries) {
+        for (auto& library : parts) {
+            vkDestroyPipeline(device, library.second, nullptr);
+        }
+    }
+
+    save_cache_file();
+    vkDestroyPipelineCache(device, cache, nullptr);
+
+    std::cout << "[Pipelines] " << stats.libraries << " libraries, " << stats.fastLinks << " fast links, "
+              << stats.optimized << " optimized, " << stats.fullCompiles << " full compiles, "
+              << stats.firstUseMicroseconds << " us on first use\n";
+}
+
+// Only reuses a blob written by the same driver and GPU; anything else starts empty
+void GraphicsPipelineCache::load_cache_file() {
+    std::vector<char> data;
+    if (!cachePath.empty()) {
+        std::ifstream file(cachePath, std::ios::binary);
+        if (file) {
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    }
+
+    if (!data.empty()) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        VkPipelineCacheHeaderVersionOne header{};
+        bool valid = data.size() >= sizeof(header);
+        if (valid) {
+            std::memcpy(&header, data.data(), sizeof(header));
+            valid = header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                    header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+                    std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+        if (!valid) {
+            std::cerr << "[Pipelines] Ignoring stale pipeline cache " << cachePath << std::endl;
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline cache!");
+    }
+}
+
+void GraphicsPipelineCache::save_cache_file() {
+    if (cachePath.empty()) {
+        return;
+    }
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+        return;
+    }
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(size));
+}
+
+uint64_t GraphicsPipelineCache::part_key(LibraryPart part, const GraphicsPipelineDesc& desc) {
+    uint64_t hash = FNV_OFFSET;
+    hash_value(hash, part);
+    switch (part) {
+    case VERTEX_INPUT:
+        hash_vector(hash, desc.vertexBindings);
+        hash_vector(hash, desc.vertexAttributes);
+        hash_value(hash, desc.topology);
+        break;
+    case PRE_RASTERIZATION:
+        hash_value(hash, desc.vertexShader);
+        hash_constants(hash, desc.vertexConstants);
+        hash_value(hash, desc.layout);
+        hash_value(hash, desc.polygonMode);
+        hash_value(hash, desc.cullMode);
+        hash_value(hash, desc.frontFace);
+        break;
+    case FRAGMENT_SHADER:
+        hash_value(hash, desc.fragmentShader);
+        hash_constants(hash, desc.fragmentConstants);
+        hash_value(hash, desc.layout);
+        hash_value(hash, desc.depthTest);
+        hash_value(hash, desc.depthWrite);
+        hash_value(hash, desc.depthCompare);
+        break;
+    default:
+        hash_vector(hash, desc.colorFormats);
+        hash_value(hash, desc.depthFormat);
+        hash_value(hash, desc.alphaBlend);
+        break;
+    }
+    return hash;
+}
+
+VkPipeline GraphicsPipelineCache::get_library(LibraryPart part, const GraphicsPipelineDesc& desc) {
+    uint64_t key = part_key(part, desc);
+    auto it = libraries[part].find(key);
+    if (it != libraries[part].end()) {
+        return it->second;
+    }
+    VkPipeline library = create_library(part, desc);
+    libraries[part].emplace(key, library);
+    stats.libraries++;
+    return library;
+}
+
+VkPipeline GraphicsPipelineCache::create_library(LibraryPart part, const GraphicsPipelineDesc& desc) {
+    PipelineState state(desc);
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    // Retaining link-time information lets the background build optimize across libraries
+    pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+    switch (part) {
+    case VERTEX_INPUT:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        pipelineInfo.pVertexInputState = &state.vertexInput;
+        pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+        break;
+    case PRE_RASTERIZATION:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        libraryInfo.pNext = &state.rendering;
+        pipelineInfo.stageCount = 1;
+        pipelineInfo.pStages = &state.stages[0];
+        pipelineInfo.pViewportState = &state.viewport;
+        pipelineInfo.pRasterizationState = &state.rasterization;
+        pipelineInfo.pDynamicState = &state.dynamic;
+        pipelineInfo.layout = desc.layout;
+        break;
+    case FRAGMENT_SHADER:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        libraryInfo.pNext = &state.rendering;
+        pipelineInfo.stageCount = state.stageCount - 1;
+        pipelineInfo.pStages = &state.stages[1];
+        pipelineInfo.pDepthStencilState = &state.depthStencil;
+        pipelineInfo.pMultisampleState = &state.multisample;
+        pipelineInfo.layout = desc.layout;
+        break;
+    default:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        libraryInfo.pNext = &state.rendering;
+        pipelineInfo.pColorBlendState = &state.colorBlend;
+        pipelineInfo.pMultisampleState = &state.multisample;
+        break;
+    }
+
+    VkPipeline library;
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &library) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline library!");
+    }
+    return library;
+}
+
+VkPipeline GraphicsPipelineCache::link(const VkPipeline* parts, VkPipelineLayout layout, bool optimize) {
+    VkPipelineLibraryCreateInfoKHR linkInfo{};
+    linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    linkInfo.libraryCount = PART_COUNT;
+    linkInfo.pLibraries = parts;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &linkInfo;
+    pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    pipelineInfo.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return pipeline;
+}
+
+VkPipeline GraphicsPipelineCache::compile_full(const GraphicsPipelineDesc& desc) {
+    PipelineState state(desc);
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &state.rendering;
+    pipelineInfo.stageCount = state.stageCount;
+    pipelineInfo.pStages = state.stages;
+    pipelineInfo.pVertexInputState = &state.vertexInput;
+    pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+    pipelineInfo.pViewportState = &state.viewport;
+    pipelineInfo.pRasterizationState = &state.rasterization;
+    pipelineInfo.pMultisampleState = &state.multisample;
+    pipelineInfo.pDepthStencilState = &state.depthStencil;
+    pipelineInfo.pColorBlendState = &state.colorBlend;
+    pipelineInfo.pDynamicState = &state.dynamic;
+    pipelineInfo.layout = desc.layout;
+
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline!");
+    }
+    return pipeline;
+}
+
+void GraphicsPipelineCache::prepare(const GraphicsPipelineDesc& desc) {
+    if (!useLibraries) {
+        return;
+    }
+    for (int part = 0; part < PART_COUNT; ++part) {
+        get_library(static_cast<LibraryPart>(part), desc);
+    }
+}
+
+VkPipeline GraphicsPipelineCache::get(const GraphicsPipelineDesc& desc) {
+    uint64_t key = FNV_OFFSET;
+    for (int part = 0; part < PART_COUNT; ++part) {
+        hash_value(key, part_key(static_cast<LibraryPart>(part), desc));
+    }
+    auto it = pipelines.find(key);
+    if (it != pipelines.end()) {
+        return it->second.pipeline;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Entry entry;
+    if (useLibraries) {
+        UpgradeJob job{};
+        job.key = key;
+        job.layout = desc.layout;
+        for (int part = 0; part < PART_COUNT; ++part) {
+            job.libraries[part] = get_library(static_cast<LibraryPart>(part), desc);
+        }
+        entry.pipeline = link(job.libraries, desc.layout, false);
+        if (entry.pipeline == VK_NULL_HANDLE) {
+            throw std::runtime_error("Failed to link graphics pipeline libraries!");
+        }
+        stats.fastLinks++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(job);
+        }
+        wake.notify_one();
+    } else {
+        entry.pipeline = compile_full(desc);
+        entry.optimized = true;
+        stats.fullCompiles++;
+    }
+    stats.firstUseMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    pipelines.emplace(key, entry);
+    return entry.pipeline;
+}
+
+void GraphicsPipelineCache::collect() {
+    std::vector<UpgradeJob> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(finished);
+    }
+
+    for (UpgradeJob& job : done) {
+        if (job.result == VK_NULL_HANDLE) {
+            continue; // Optimization failed; the linked pipeline stays in service
+        }
+        Entry& entry = pipelines[job.key];
+        VkPipeline linked = entry.pipeline;
+        VkDevice dev = device;
+        retire([dev, linked]() { vkDestroyPipeline(dev, linked, nullptr); }); // Earlier frames may still use it
+        entry.pipeline = job.result;
+        entry.optimized = true;
+        stats.optimized++;
+    }
+}
+
+// Libraries live until destruction, so jobs can reference them without extra locking
+void GraphicsPipelineCache::worker_loop() {
+    while (true) {
+        UpgradeJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = queued.front();
+            queued.pop_front();
+        }
+
+        job.result = link(job.libraries, job.layout, true);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(job);
+    }
+}
@@ -0,0 +1,216 @@
+#include "platform/present_thread.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+// Bounded so a vblank wait in acquire never holds back presents that are ready to go
+constexpr uint64_t ACQUIRE_TIMEOUT_NS = 2000000;
+
+double milliseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void accumulate(double& total, double& maximum, double sample) {
+    total += sample;
+    maximum = std::max(maximum, sample);
+}
+}
+
+PresentThread::PresentThread(VkDevice device, VkQueue queue, std::mutex& queueMutex, VkSwapchainKHR swapchain)
+    : device(device), queue(queue), queueMutex(queueMutex), swapchain(swapchain) {
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    // Two frames in flight, one image acquired ahead and one spare
+    semaphores.resize(SEMAPHORE_COUNT);
+    for (VkSemaphore& semaphore : semaphores) {
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create acquire semaphore!");
+        }
+        freeSemaphores.push(semaphore);
+    }
+
+    thread = std::thread(&PresentThread::thread_loop, this);
+    std::cout << "[PresentThread] Acquire and present moved off the render thread.\n";
+}
+
+PresentThread::~PresentThread() {
+    stopping = true;
+    notify();
+    thread.join();
+
+    vkDeviceWaitIdle(device); // Outstanding acquires and presents still reference the semaphores
+    for (VkSemaphore semaphore : semaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+
+    if (stats.frames > 0) {
+        double frames = static_cast<double>(stats.frames);
+        std::cout << "[PresentThread] " << stats.frames << " frames; avg/max ms waiting: image "
+                  << stats.imageWaitMilliseconds / frames << "/" << stats.imageWaitMaxMilliseconds
+                  << ", acquire " << stats.acquireMilliseconds / frames << "/" << stats.acquireMaxMilliseconds
+                  << ", present " << stats.presentMilliseconds / frames << "/" << stats.presentMaxMilliseconds << "\n";
+    }
+}
+
+void PresentThread::notify() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex); // Orders the state change before a waiter's check
+    }
+    wake.notify_all();
+}
+
+bool PresentThread::acquire(AcquiredImage& image) {
+    auto start = std::chrono::steady_clock::now();
+    bool ready = false;
+    while (true) {
+        if (acquired.pop(image)) {
+            ready = true;
+            break;
+        }
+        if (failed) {
+            throw std::runtime_error("Failed to acquire next image from swapchain!");
+        }
+        if (recreateRequested && presentsPending == 0) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this]() {
+            return !acquired.empty() || failed || (recreateRequested && presentsPending == 0);
+        });
+    }
+    notify(); // The present thread may start acquiring the next image now
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    accumulate(stats.imageWaitMilliseconds, stats.imageWaitMaxMilliseconds, milliseconds_since(start));
+    return ready;
+}
+
+void PresentThread::present(uint32_t imageIndex, VkSemaphore renderFinished) {
+    presentsPending++;
+    if (!presents.push({imageIndex, renderFinished})) {
+        throw std::runtime_error("Present queue overflow!");
+    }
+    notify();
+}
+
+void PresentThread::release_semaphore(VkSemaphore semaphore) {
+    if (semaphore != VK_NULL_HANDLE) {
+        freeSemaphores.push(semaphore);
+        notify();
+    }
+}
+
+void PresentThread::resume(VkSwapchainKHR newSwapchain) {
+    swapchain = newSwapchain;
+    recreateRequested.store(false, std::memory_order_release); // Publishes the new handle
+    notify();
+}
+
+void PresentThread::set_present_hook(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    presentHook = std::move(hook);
+}
+
+PresentThread::Stats PresentThread::get_stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void PresentThread::thread_loop() {
+    while (!stopping) {
+        bool worked = present_pending();
+        worked = try_acquire() || worked;
+        if (worked) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this]() {
+            bool canAcquire = !recreateRequested && !failed && acquired.empty() &&
+                              (spareSemaphore != VK_NULL_HANDLE || !freeSemaphores.empty());
+            return stopping || !presents.empty() || canAcquire;
+        });
+    }
+}
+
+bool PresentThread::present_pending() {
+    bool worked = false;
+    PendingPresent pending;
+    while (presents.pop(pending)) {
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &pending.renderFinished;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.pImageIndices = &pending.imageIndex;
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult result;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (presentHook) {
+                presentHook();
+            }
+            result = vkQueuePresentKHR(queue, &presentInfo);
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.frames++;
+            accumulate(stats.presentMilliseconds, stats.presentMaxMilliseconds, milliseconds_since(start));
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            recreateRequested = true;
+        } else if (result != VK_SUCCESS) {
+            std::cerr << "[PresentThread] vkQueuePresentKHR failed: " << result << std::endl;
+            failed = true;
+        }
+        presentsPending--;
+        worked = true;
+    }
+    if (worked) {
+        notify();
+    }
+    return worked;
+}
+
+// Keeps at most one image acquired ahead of the render thread
+bool PresentThread::try_acquire() {
+    if (recreateRequested || failed || !acquired.empty()) {
+        return false;
+    }
+    if (spareSemaphore == VK_NULL_HANDLE && !freeSemaphores.pop(spareSemaphore)) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t imageIndex;
+    VkResult result = vkAcquireNextImageKHR(device, swapchain, ACQUIRE_TIMEOUT_NS, spareSemaphore, VK_NULL_HANDLE,
+                                            &imageIndex);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        accumulate(stats.acquireMilliseconds, stats.acquireMaxMilliseconds, milliseconds_since(start));
+    }
+
+    if (result == VK_TIMEOUT || result == VK_NOT_READY) {
+        return true; // Service presents, then try again
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreateRequested = true; // Nothing was signalled, so the semaphore stays spare
+    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        std::cerr << "[PresentThread] vkAcquireNextImageKHR failed: " << result << std::endl;
+        failed = true;
+    } else {
+        acquired.push({imageIndex, spareSemaphore});
+        spareSemaphore = VK_NULL_HANDLE;
+        if (result == VK_SUBOPTIMAL_KHR) {
+            recreateRequested = true;
+        }
+    }
+    notify();
+    return true;
+}
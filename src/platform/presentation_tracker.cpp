@@ -0,0 +1,185 @@
+#include "platform/presentation_tracker.hpp"
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+namespace {
+constexpr uint64_t NS_PER_MS = 1000000;
+constexpr uint32_t MAX_INPUT_AGE_MS = 1000; // Older timestamps are from another clock; use arrival time
+
+double to_ms(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / static_cast<double>(NS_PER_MS);
+}
+}
+
+const wl_registry_listener PresentationTracker::registryListener = {
+    PresentationTracker::registry_global,
+    PresentationTracker::registry_global_remove
+};
+
+const wp_presentation_listener PresentationTracker::presentationListener = {
+    .clock_id = PresentationTracker::clock_id_event
+};
+
+const wp_presentation_feedback_listener PresentationTracker::feedbackListener = {
+    .sync_output = PresentationTracker::sync_output,
+    .presented = PresentationTracker::presented,
+    .discarded = PresentationTracker::discarded
+};
+
+PresentationTracker::PresentationTracker(wl_display* display, wl_surface* surface)
+    : surface(surface), clockId(CLOCK_MONOTONIC) {
+    // Binds on a registry of its own so the listener is in place before clock_id arrives
+    wl_registry* registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registryListener, this);
+    wl_display_roundtrip(display);
+    wl_registry_destroy(registry);
+
+    if (presentation) {
+        std::cout << "[Presentation] wp_presentation bound, clock " << clockId << ".\n";
+    } else {
+        std::cout << "[Presentation] wp_presentation unavailable; no present timing.\n";
+    }
+}
+
+PresentationTracker::~PresentationTracker() {
+    for (auto& entry : pending) {
+        wp_presentation_feedback_destroy(entry.first);
+    }
+    if (presentation) {
+        wp_presentation_destroy(presentation);
+    }
+
+    if (stats.presented == 0) {
+        return;
+    }
+    double presentedFrames = static_cast<double>(stats.presented);
+    std::cout << "[Presentation] " << stats.presented << " presented, " << stats.discarded << " discarded, "
+              << stats.missedRefreshes << " missed refreshes; vsync " << 100.0 * stats.vsync / presentedFrames
+              << "%, zero-copy " << 100.0 * stats.zeroCopy / presentedFrames << "%, hw-completion "
+              << 100.0 * stats.hwCompletion / presentedFrames << "%\n";
+
+    const LatencyHistogram& commit = stats.commitToPresent;
+    std::cout << "[Presentation] commit-to-present ms: avg " << commit.mean() << ", p50 " << commit.percentile(0.5)
+              << ", p99 " << commit.percentile(0.99) << ", max " << commit.max() << "\n";
+    const LatencyHistogram& input = stats.inputToPhoton;
+    if (input.count() > 0) {
+        std::cout << "[Presentation] input-to-photon ms (" << input.count() << " frames): avg " << input.mean()
+                  << ", p50 " << input.percentile(0.5) << ", p99 " << input.percentile(0.99) << ", max "
+                  << input.max() << "\n";
+    }
+}
+
+void PresentationTracker::registry_global(void* data, wl_registry* registry, uint32_t id, const char* interface,
+                                          uint32_t version) {
+    PresentationTracker* tracker = static_cast<PresentationTracker*>(data);
+    if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        tracker->presentation =
+            static_cast<wp_presentation*>(wl_registry_bind(registry, id, &wp_presentation_interface, 1));
+        wp_presentation_add_listener(tracker->presentation, &presentationListener, tracker);
+    }
+}
+
+void PresentationTracker::registry_global_remove(void* data, wl_registry* registry, uint32_t id) {
+}
+
+void PresentationTracker::clock_id_event(void* data, wp_presentation* presentation, uint32_t clockId) {
+    static_cast<PresentationTracker*>(data)->clockId = clockId;
+}
+
+uint64_t PresentationTracker::now_ns() const {
+    timespec now;
+    clock_gettime(static_cast<clockid_t>(clockId), &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+void PresentationTracker::note_input(uint32_t timeMs) {
+    if (!presentation) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingInputNs != 0) {
+        return;
+    }
+    // Input timestamps are milliseconds on an unspecified base; in practice that is
+    // CLOCK_MONOTONIC truncated to 32 bits, which lets the event time be recovered
+    uint64_t now = now_ns();
+    uint32_t ageMs = static_cast<uint32_t>(now / NS_PER_MS) - timeMs;
+    bool sameClock = clockId == CLOCK_MONOTONIC && ageMs < MAX_INPUT_AGE_MS;
+    pendingInputNs = sameClock ? now - ageMs * NS_PER_MS : now;
+}
+
+void PresentationTracker::frame_committed() {
+    if (!presentation) {
+        return;
+    }
+    // Attaches to the next wl_surface.commit, including the one inside vkQueuePresentKHR
+    struct wp_presentation_feedback* feedback = wp_presentation_feedback(presentation, surface);
+    wp_presentation_feedback_add_listener(feedback, &feedbackListener, this);
+    std::lock_guard<std::mutex> lock(mutex);
+    pending[feedback] = {now_ns(), pendingInputNs};
+    pendingInputNs = 0;
+}
+
+void PresentationTracker::sync_output(void* data, struct wp_presentation_feedback* feedback, wl_output* output) {
+}
+
+void PresentationTracker::presented(void* data, struct wp_presentation_feedback* feedback, uint32_t secondsHi,
+                                    uint32_t secondsLo, uint32_t nanoseconds, uint32_t refresh, uint32_t sequenceHi,
+                                    uint32_t sequenceLo, uint32_t flags) {
+    PresentationTracker* tracker = static_cast<PresentationTracker*>(data);
+    Stats& stats = tracker->stats;
+
+    PresentedFrame frame;
+    uint64_t seconds = (static_cast<uint64_t>(secondsHi) << 32) | secondsLo;
+    frame.presentedNs = seconds * 1000000000ull + nanoseconds;
+    frame.refreshNs = refresh;
+    frame.sequence = (static_cast<uint64_t>(sequenceHi) << 32) | sequenceLo;
+    frame.flags = flags;
+
+    // Sequence is only meaningful for vsync'd presents on an output with a counter
+    const PresentedFrame& previous = tracker->lastPresented;
+    if ((flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC) && previous.sequence != 0 && frame.sequence > previous.sequence) {
+        stats.missedRefreshes += frame.sequence - previous.sequence - 1;
+    }
+
+    std::unique_lock<std::mutex> lock(tracker->mutex);
+    auto entry = tracker->pending.find(feedback);
+    if (entry != tracker->pending.end()) {
+        const PendingFrame& pendingFrame = entry->second;
+        if (frame.presentedNs >= pendingFrame.commitNs) {
+            stats.commitToPresent.record(to_ms(frame.presentedNs - pendingFrame.commitNs));
+        }
+        if (pendingFrame.inputNs != 0 && frame.presentedNs >= pendingFrame.inputNs) {
+            stats.inputToPhoton.record(to_ms(frame.presentedNs - pendingFrame.inputNs));
+        }
+        tracker->pending.erase(entry);
+    }
+    lock.unlock();
+
+    stats.presented++;
+    stats.vsync += (flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC) ? 1 : 0;
+    stats.hwClock += (flags & WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK) ? 1 : 0;
+    stats.hwCompletion += (flags & WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION) ? 1 : 0;
+    stats.zeroCopy += (flags & WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY) ? 1 : 0;
+    tracker->lastPresented = frame;
+    wp_presentation_feedback_destroy(feedback);
+}
+
+void PresentationTracker::discarded(void* data, struct wp_presentation_feedback* feedback) {
+    PresentationTracker* tracker = static_cast<PresentationTracker*>(data);
+    tracker->stats.discarded++;
+
+    // The input still reaches the screen, just in a later frame
+    std::unique_lock<std::mutex> lock(tracker->mutex);
+    auto entry = tracker->pending.find(feedback);
+    if (entry != tracker->pending.end()) {
+        uint64_t inputNs = entry->second.inputNs;
+        if (inputNs != 0 && (tracker->pendingInputNs == 0 || inputNs < tracker->pendingInputNs)) {
+            tracker->pendingInputNs = inputNs;
+        }
+        tracker->pending.erase(entry);
+    }
+    lock.unlock();
+    wp_presentation_feedback_destroy(feedback);
+}
@@ -0,0 +1,792 @@
+#include "platform/render_graph.hpp"
+#include "platform/vulkan_buffer.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+struct UsageInfo {
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+    bool write;
+};
+
+constexpr VkPipelineStageFlags2 SHADER_STAGES = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                                                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+                                                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+constexpr VkPipelineStageFlags2 DEPTH_STAGES = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                                               VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+UsageInfo usage_info(RGUsage usage) {
+    switch (usage) {
+    case RGUsage::ColorAttachment:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    case RGUsage::DepthAttachment:
+        return {DEPTH_STAGES,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+    case RGUsage::DepthRead:
+        return {DEPTH_STAGES | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false};
+    case RGUsage::Sampled:
+        return {SHADER_STAGES, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+    case RGUsage::StorageRead:
+        return {SHADER_STAGES, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+    case RGUsage::StorageWrite:
+        return {SHADER_STAGES, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, true};
+    case RGUsage::TransferSrc:
+        return {VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+    case RGUsage::TransferDst:
+        return {VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true};
+    case RGUsage::IndirectRead:
+        return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case RGUsage::VertexRead:
+        return {VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case RGUsage::Present:
+        return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false};
+    }
+    return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, false};
+}
+
+const char* layout_name(VkImageLayout layout) {
+    switch (layout) {
+    case VK_IMAGE_LAYOUT_UNDEFINED: return "UNDEFINED";
+    case VK_IMAGE_LAYOUT_GENERAL: return "GENERAL";
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return "COLOR_ATTACHMENT";
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return "DEPTH_ATTACHMENT";
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: return "DEPTH_READ_ONLY";
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return "SHADER_READ_ONLY";
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return "TRANSFER_SRC";
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return "TRANSFER_DST";
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return "PRESENT_SRC";
+    default: return "OTHER";
+    }
+}
+
+double to_mib(VkDeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+RGHandle RenderGraph::PassBuilder::create_texture(const std::string& name, const RGTextureDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    graph.resources.push_back(resource);
+    return static_cast<RGHandle>(graph.resources.size() - 1);
+}
+
+void RenderGraph::PassBuilder::read(RGHandle handle, RGUsage usage) {
+    graph.add_access(passIndex, handle, usage);
+}
+
+void RenderGraph::PassBuilder::write(RGHandle handle, RGUsage usage) {
+    graph.add_access(passIndex, handle, usage);
+}
+
+void RenderGraph::PassBuilder::color_attachment(RGHandle handle, const VkClearColorValue* clear) {
+    graph.add_access(passIndex, handle, RGUsage::ColorAttachment);
+
+    Attachment attachment;
+    attachment.handle = handle;
+    if (clear) {
+        attachment.clear = true;
+        attachment.clearValue.color = *clear;
+    }
+    graph.passes[passIndex].colorAttachments.push_back(attachment);
+}
+
+void RenderGraph::PassBuilder::depth_attachment(RGHandle handle, const VkClearDepthStencilValue* clear) {
+    graph.add_access(passIndex, handle, RGUsage::DepthAttachment);
+
+    Pass& pass = graph.passes[passIndex];
+    pass.hasDepth = true;
+    pass.depthAttachment.handle = handle;
+    if (clear) {
+        pass.depthAttachment.clear = true;
+        pass.depthAttachment.clearValue.depthStencil = *clear;
+    }
+}
+
+void RenderGraph::PassBuilder::side_effect() {
+    graph.passes[passIndex].sideEffect = true;
+}
+
+RenderGraph::RenderGraph(VkPhysicalDevice physicalDevice, VkDevice device)
+    : physicalDevice(physicalDevice), device(device) {}
+
+RenderGraph::~RenderGraph() {
+    destroy_transients();
+}
+
+void RenderGraph::reset() {
+    resources.clear();
+    passes.clear();
+    executionOrder.clear();
+    finalBarriers.clear();
+    buckets.clear();
+    stats = Stats{};
+    compiled = false;
+}
+
+RGHandle RenderGraph::import_texture(const std::string& name, VkImage image, VkImageView view, VkExtent2D extent,
+                                     VkImageLayout initialLayout, RGUsage finalUsage,
+                                     VkPipelineStageFlags2 initialStage) {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+    resource.desc.width = extent.width;
+    resource.desc.height = extent.height;
+    resource.initialLayout = initialLayout;
+    resource.initialStage = initialStage;
+    resource.hasFinalUsage = true;
+    resource.finalUsage = finalUsage;
+    resources.push_back(resource);
+    return static_cast<RGHandle>(resources.size() - 1);
+}
+
+RGHandle RenderGraph::import_buffer(const std::string& name, VkBuffer buffer, VkDeviceSize size) {
+    Resource resource;
+    resource.name = name;
+    resource.isBuffer = true;
+    resource.imported = true;
+    resource.buffer = buffer;
+    resource.bufferSize = size;
+    resource.initialStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    resources.push_back(resource);
+    return static_cast<RGHandle>(resources.size() - 1);
+}
+
+void RenderGraph::add_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute) {
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+
+    PassBuilder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::add_access(uint32_t passIndex, RGHandle handle, RGUsage usage) {
+    if (handle >= resources.size()) {
+        throw std::runtime_error("Render graph pass references an unknown resource!");
+    }
+
+    UsageInfo info = usage_info(usage);
+    Pass& pass = passes[passIndex];
+
+    // A pass touching the same resource twice gets one merged access
+    for (Access& access : pass.accesses) {
+        if (access.handle == handle) {
+            access.state.stage |= info.stage;
+            access.state.access |= info.access;
+            access.state.write = access.state.write || info.write;
+            if (info.write) {
+                access.state.layout = info.layout;
+            }
+            return;
+        }
+    }
+    pass.accesses.push_back({handle, {info.stage, info.access, info.layout, info.write}});
+}
+
+void RenderGraph::compile() {
+    stats = Stats{};
+    stats.declaredPasses = static_cast<uint32_t>(passes.size());
+    for (Resource& resource : resources) {
+        resource.firstUse = -1;
+        resource.lastUse = -1;
+        resource.aliasBucket = -1;
+        resource.aliasPredecessor = -1;
+    }
+
+    cull_passes();
+    order_passes();
+    compute_lifetimes();
+    plan_aliasing();
+    realize_transients();
+    build_barriers();
+    compiled = true;
+}
+
+// Walks passes backwards from the graph outputs; a pass survives only if something
+// downstream reads what it writes.
+void RenderGraph::cull_passes() {
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); ++i) {
+        needed[i] = resources[i].imported;
+    }
+
+    for (size_t p = passes.size(); p-- > 0;) {
+        Pass& pass = passes[p];
+        bool alive = pass.sideEffect;
+        for (const Access& access : pass.accesses) {
+            if (access.state.write && needed[access.handle]) {
+                alive = true;
+            }
+        }
+
+        pass.culled = !alive;
+        if (!alive) {
+            stats.culledPasses++;
+            continue;
+        }
+
+        for (const Access& access : pass.accesses) {
+            // Attachments and storage writes read back earlier contents, so the producer must stay
+            needed[access.handle] = true;
+        }
+    }
+}
+
+// Stable topological sort: a pass runs after every earlier pass that touches one of its
+// resources with a write on either side.
+void RenderGraph::order_passes() {
+    std::vector<uint32_t> alive;
+    for (uint32_t p = 0; p < passes.size(); ++p) {
+        if (!passes[p].culled) {
+            alive.push_back(p);
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> successors(passes.size());
+    std::vector<uint32_t> inDegree(passes.size(), 0);
+    for (size_t a = 0; a < alive.size(); ++a) {
+        for (size_t b = a + 1; b < alive.size(); ++b) {
+            bool dependent = false;
+            for (const Access& first : passes[alive[a]].accesses) {
+                for (const Access& second : passes[alive[b]].accesses) {
+                    if (first.handle == second.handle && (first.state.write || second.state.write)) {
+                        dependent = true;
+                    }
+                }
+            }
+            if (dependent) {
+                successors[alive[a]].push_back(alive[b]);
+                inDegree[alive[b]]++;
+            }
+        }
+    }
+
+    executionOrder.clear();
+    std::vector<uint32_t> ready;
+    for (uint32_t p : alive) {
+        if (inDegree[p] == 0) {
+            ready.push_back(p);
+        }
+    }
+    while (!ready.empty()) {
+        auto next = std::min_element(ready.begin(), ready.end());
+        uint32_t p = *next;
+        ready.erase(next);
+        executionOrder.push_back(p);
+        for (uint32_t s : successors[p]) {
+            if (--inDegree[s] == 0) {
+                ready.push_back(s);
+            }
+        }
+    }
+}
+
+void RenderGraph::compute_lifetimes() {
+    for (size_t position = 0; position < executionOrder.size(); ++position) {
+        for (const Access& access : passes[executionOrder[position]].accesses) {
+            Resource& resource = resources[access.handle];
+            if (resource.firstUse < 0) {
+                resource.firstUse = static_cast<int>(position);
+            }
+            resource.lastUse = static_cast<int>(position);
+        }
+    }
+}
+
+// Greedy interval packing: largest textures first, each into the first bucket whose
+// occupants are all dead before it starts or born after it ends.
+void RenderGraph::plan_aliasing() {
+    buckets.clear();
+
+    std::vector<uint32_t> transients;
+    for (uint32_t i = 0; i < resources.size(); ++i) {
+        Resource& resource = resources[i];
+        if (resource.imported || resource.isBuffer || resource.firstUse < 0) {
+            continue;
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.desc.format;
+        imageInfo.extent = {resource.desc.width, resource.desc.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = resource.desc.usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkDeviceImageMemoryRequirements query{};
+        query.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+        query.pCreateInfo = &imageInfo;
+        VkMemoryRequirements2 requirements{};
+        requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        vkGetDeviceImageMemoryRequirements(device, &query, &requirements);
+
+        resource.requirements = requirements.memoryRequirements;
+        stats.transientBytes += resource.requirements.size;
+        transients.push_back(i);
+    }
+
+    std::stable_sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) {
+        return resources[a].requirements.size > resources[b].requirements.size;
+    });
+
+    for (uint32_t handle : transients) {
+        Resource& resource = resources[handle];
+        int chosen = -1;
+        for (size_t b = 0; b < buckets.size() && chosen < 0; ++b) {
+            if ((buckets[b].memoryTypeBits & resource.requirements.memoryTypeBits) == 0) {
+                continue;
+            }
+            bool overlaps = false;
+            for (uint32_t occupant : buckets[b].occupants) {
+                const Resource& other = resources[occupant];
+                if (!(other.lastUse < resource.firstUse || other.firstUse > resource.lastUse)) {
+                    overlaps = true;
+                    break;
+                }
+            }
+            if (!overlaps) {
+                chosen = static_cast<int>(b);
+            }
+        }
+        if (chosen < 0) {
+            buckets.push_back(AliasBucket{});
+            chosen = static_cast<int>(buckets.size() - 1);
+        }
+
+        AliasBucket& bucket = buckets[chosen];
+        bucket.size = std::max(bucket.size, resource.requirements.size);
+        bucket.memoryTypeBits &= resource.requirements.memoryTypeBits;
+        bucket.occupants.push_back(handle);
+        resource.aliasBucket = chosen;
+    }
+
+    // The predecessor is the occupant whose contents this resource overwrites
+    for (AliasBucket& bucket : buckets) {
+        for (uint32_t handle : bucket.occupants) {
+            Resource& resource = resources[handle];
+            int bestLastUse = -1;
+            for (uint32_t other : bucket.occupants) {
+                if (resources[other].lastUse < resource.firstUse && resources[other].lastUse > bestLastUse) {
+                    bestLastUse = resources[other].lastUse;
+                    resource.aliasPredecessor = static_cast<int>(other);
+                }
+            }
+        }
+        stats.allocatedBytes += bucket.size;
+    }
+}
+
+// Physical images are reused as long as every transient keeps its description and bucket.
+// Replaced ones go through the retire function, or are destroyed directly without one.
+void RenderGraph::realize_transients() {
+    std::vector<uint32_t> transients;
+    for (uint32_t i = 0; i < resources.size(); ++i) {
+        if (resources[i].aliasBucket >= 0) {
+            transients.push_back(i);
+        }
+    }
+
+    bool reusable = transients.size() == physicalTextures.size() && buckets.size() == bucketMemory.size();
+    for (size_t i = 0; reusable && i < transients.size(); ++i) {
+        const Resource& resource = resources[transients[i]];
+        reusable = physicalTextures[i].desc == resource.desc && physicalTextures[i].bucket == resource.aliasBucket;
+    }
+
+    if (!reusable) {
+        if (retireFn) {
+            std::vector<PhysicalTexture> oldTextures = std::move(physicalTextures);
+            std::vector<VkDeviceMemory> oldMemory = std::move(bucketMemory);
+            physicalTextures.clear();
+            bucketMemory.clear();
+            VkDevice dev = device;
+            retireFn([dev, oldTextures, oldMemory]() {
+                for (const PhysicalTexture& texture : oldTextures) {
+                    vkDestroyImageView(dev, texture.view, nullptr);
+                    vkDestroyImage(dev, texture.image, nullptr);
+                }
+                for (VkDeviceMemory memory : oldMemory) {
+                    vkFreeMemory(dev, memory, nullptr);
+                }
+            });
+        } else {
+            destroy_transients();
+        }
+
+        for (const AliasBucket& bucket : buckets) {
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = bucket.size;
+            allocInfo.memoryTypeIndex = find_memory_type(physicalDevice, bucket.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            VkDeviceMemory memory;
+            if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate render graph transient memory!");
+            }
+            bucketMemory.push_back(memory);
+        }
+
+        for (uint32_t handle : transients) {
+            const Resource& resource = resources[handle];
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = resource.desc.format;
+            imageInfo.extent = {resource.desc.width, resource.desc.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = resource.desc.usage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            PhysicalTexture texture{resource.desc, resource.aliasBucket, VK_NULL_HANDLE, VK_NULL_HANDLE};
+            if (vkCreateImage(device, &imageInfo, nullptr, &texture.image) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create render graph transient image!");
+            }
+            vkBindImageMemory(device, texture.image, bucketMemory[resource.aliasBucket], 0);
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = texture.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.desc.format;
+            viewInfo.subresourceRange = {resource.desc.aspect, 0, 1, 0, 1};
+            if (vkCreateImageView(device, &viewInfo, nullptr, &texture.view) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create render graph transient image view!");
+            }
+            physicalTextures.push_back(texture);
+        }
+    }
+
+    for (size_t i = 0; i < transients.size(); ++i) {
+        resources[transients[i]].image = physicalTextures[i].image;
+        resources[transients[i]].view = physicalTextures[i].view;
+    }
+}
+
+void RenderGraph::destroy_transients() {
+    for (const PhysicalTexture& texture : physicalTextures) {
+        vkDestroyImageView(device, texture.view, nullptr);
+        vkDestroyImage(device, texture.image, nullptr);
+    }
+    physicalTextures.clear();
+    for (VkDeviceMemory memory : bucketMemory) {
+        vkFreeMemory(device, memory, nullptr);
+    }
+    bucketMemory.clear();
+}
+
+// Tracks each resource's last stage/access/layout through the ordered passes and emits a
+// barrier only on a layout change or a hazard involving a write. Consecutive reads in the
+// same layout are merged so the next writer waits on all of them, but a reader whose stage
+// or access the last write was not yet made visible to gets its own barrier from that write.
+void RenderGraph::build_barriers() {
+    // The last write, kept apart from the readers merged into the usage state, and the
+    // stages and accesses it has been made visible to since
+    struct WriteState {
+        VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 visibleStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 visibleAccess = VK_ACCESS_2_NONE;
+
+        bool covers(const UsageState& reader) const {
+            return access == VK_ACCESS_2_NONE ||
+                   ((reader.stage & ~visibleStages) == 0 && (reader.access & ~visibleAccess) == 0);
+        }
+    };
+
+    std::vector<UsageState> states(resources.size());
+    std::vector<WriteState> writes(resources.size());
+    for (size_t i = 0; i < resources.size(); ++i) {
+        states[i].stage = resources[i].initialStage;
+        states[i].layout = resources[i].initialLayout;
+        // Imported contents may have been written by earlier submissions
+        states[i].write = resources[i].imported;
+        states[i].access = resources[i].imported ? VK_ACCESS_2_MEMORY_WRITE_BIT : VK_ACCESS_2_NONE;
+        if (resources[i].imported) {
+            writes[i].stage = resources[i].initialStage;
+            writes[i].access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+        }
+    }
+
+    // Source scope for a barrier into a read: the readers so far, for the layout change,
+    // plus the last write; the stages that already waited on it chain after earlier transitions
+    auto read_source = [](const UsageState& current, const WriteState& write) {
+        UsageState src = current;
+        src.stage |= write.stage | write.visibleStages;
+        src.access = write.access;
+        return src;
+    };
+    auto barrier_to = [](UsageState& current, WriteState& write, const UsageState& wanted) {
+        current = wanted;
+        if (wanted.write) {
+            write = WriteState{wanted.stage, wanted.access};
+        } else {
+            write.visibleStages = wanted.stage;
+            write.visibleAccess = wanted.access;
+        }
+    };
+
+    for (size_t position = 0; position < executionOrder.size(); ++position) {
+        Pass& pass = passes[executionOrder[position]];
+        pass.barriers.clear();
+
+        for (const Access& access : pass.accesses) {
+            Resource& resource = resources[access.handle];
+            UsageState& current = states[access.handle];
+            WriteState& write = writes[access.handle];
+            UsageState wanted = access.state;
+            if (resource.isBuffer) {
+                wanted.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+
+            if (!resource.imported && resource.firstUse == static_cast<int>(position)) {
+                // Contents are discarded; wait for whatever used the aliased memory last,
+                // including the previous frame on this queue for the first occupant
+                UsageState src;
+                if (resource.aliasPredecessor >= 0) {
+                    src = states[resource.aliasPredecessor];
+                } else {
+                    src.stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                    src.access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+                }
+                src.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                pass.barriers.push_back({access.handle, src, wanted});
+                barrier_to(current, write, wanted);
+                continue;
+            }
+
+            bool layoutChange = !resource.isBuffer && current.layout != wanted.layout;
+            if (layoutChange || current.write || wanted.write) {
+                UsageState src = current;
+                if (!wanted.write) {
+                    src = read_source(current, write);
+                } else if (!current.write) {
+                    src.access = VK_ACCESS_2_NONE; // Write-after-read only needs an execution dependency
+                }
+                pass.barriers.push_back({access.handle, src, wanted});
+                barrier_to(current, write, wanted);
+            } else {
+                if (!write.covers(wanted)) {
+                    UsageState src{write.stage | write.visibleStages, write.access, current.layout, false};
+                    pass.barriers.push_back({access.handle, src, wanted});
+                    write.visibleStages |= wanted.stage;
+                    write.visibleAccess |= wanted.access;
+                }
+                current.stage |= wanted.stage;
+                current.access |= wanted.access;
+            }
+        }
+        stats.barriers += static_cast<uint32_t>(pass.barriers.size());
+    }
+
+    finalBarriers.clear();
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const Resource& resource = resources[i];
+        if (!resource.hasFinalUsage) {
+            continue;
+        }
+        UsageInfo info = usage_info(resource.finalUsage);
+        UsageState wanted{info.stage, info.access, info.layout, false};
+        if (states[i].layout != wanted.layout || states[i].write || !writes[i].covers(wanted)) {
+            finalBarriers.push_back({static_cast<RGHandle>(i), read_source(states[i], writes[i]), wanted});
+        }
+    }
+    stats.barriers += static_cast<uint32_t>(finalBarriers.size());
+}
+
+void RenderGraph::record_barriers(VkCommandBuffer cmdBuffer, const std::vector<Barrier>& barriers) const {
+    if (barriers.empty()) {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    for (const Barrier& barrier : barriers) {
+        const Resource& resource = resources[barrier.handle];
+        if (resource.isBuffer) {
+            VkBufferMemoryBarrier2 bufferBarrier{};
+            bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            bufferBarrier.srcStageMask = barrier.src.stage;
+            bufferBarrier.srcAccessMask = barrier.src.access;
+            bufferBarrier.dstStageMask = barrier.dst.stage;
+            bufferBarrier.dstAccessMask = barrier.dst.access;
+            bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.buffer = resource.buffer;
+            bufferBarrier.offset = 0;
+            bufferBarrier.size = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(bufferBarrier);
+            continue;
+        }
+
+        VkImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        imageBarrier.srcStageMask = barrier.src.stage;
+        imageBarrier.srcAccessMask = barrier.src.access;
+        imageBarrier.dstStageMask = barrier.dst.stage;
+        imageBarrier.dstAccessMask = barrier.dst.access;
+        imageBarrier.oldLayout = barrier.src.layout;
+        imageBarrier.newLayout = barrier.dst.layout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = resource.image;
+        imageBarrier.subresourceRange = {resource.desc.aspect, 0, 1, 0, 1};
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    VkDependencyInfo dependency{};
+    dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependency.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependency.pImageMemoryBarriers = imageBarriers.data();
+    dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+    dependency.pBufferMemoryBarriers = bufferBarriers.data();
+    vkCmdPipelineBarrier2(cmdBuffer, &dependency);
+}
+
+void RenderGraph::execute(VkCommandBuffer cmdBuffer) {
+    if (!compiled) {
+        throw std::runtime_error("Render graph executed before compile()!");
+    }
+
+    for (size_t position = 0; position < executionOrder.size(); ++position) {
+        const Pass& pass = passes[executionOrder[position]];
+        record_barriers(cmdBuffer, pass.barriers);
+
+        if (pass.colorAttachments.empty() && !pass.hasDepth) {
+            if (pass.execute) {
+                pass.execute(cmdBuffer);
+            }
+            continue;
+        }
+
+        auto make_attachment = [&](const Attachment& attachment, VkImageLayout layout) {
+            const Resource& resource = resources[attachment.handle];
+            VkRenderingAttachmentInfo info{};
+            info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            info.imageView = resource.view;
+            info.imageLayout = layout;
+            bool hasContents = resource.firstUse < static_cast<int>(position) ||
+                               (resource.imported && resource.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+            info.loadOp = attachment.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                        : hasContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            bool lastReader = !resource.imported && resource.lastUse == static_cast<int>(position);
+            info.storeOp = lastReader ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+            info.clearValue = attachment.clearValue;
+            return info;
+        };
+
+        std::vector<VkRenderingAttachmentInfo> colorInfos;
+        for (const Attachment& attachment : pass.colorAttachments) {
+            colorInfos.push_back(make_attachment(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+        }
+        VkRenderingAttachmentInfo depthInfo{};
+        if (pass.hasDepth) {
+            depthInfo = make_attachment(pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        }
+
+        RGHandle extentSource = pass.colorAttachments.empty() ? pass.depthAttachment.handle
+                                                              : pass.colorAttachments[0].handle;
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.renderArea.offset = {0, 0};
+        renderingInfo.renderArea.extent = {resources[extentSource].desc.width, resources[extentSource].desc.height};
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorInfos.size());
+        renderingInfo.pColorAttachments = colorInfos.data();
+        renderingInfo.pDepthAttachment = pass.hasDepth ? &depthInfo : nullptr;
+
+        vkCmdBeginRendering(cmdBuffer, &renderingInfo);
+        if (pass.execute) {
+            pass.execute(cmdBuffer);
+        }
+        vkCmdEndRendering(cmdBuffer);
+    }
+
+    record_barriers(cmdBuffer, finalBarriers);
+}
+
+void RenderGraph::dump(std::ostream& out) const {
+    out << "[RenderGraph] " << stats.declaredPasses << " passes, " << stats.culledPasses << " culled, "
+        << stats.barriers << " barriers\n";
+
+    for (size_t position = 0; position < executionOrder.size(); ++position) {
+        const Pass& pass = passes[executionOrder[position]];
+        out << "  #" << position << " " << pass.name << "\n";
+        for (const Access& access : pass.accesses) {
+            out << "      " << (access.state.write ? "write " : "read  ") << resources[access.handle].name << "\n";
+        }
+        for (const Barrier& barrier : pass.barriers) {
+            out << "      barrier " << resources[barrier.handle].name;
+            if (!resources[barrier.handle].isBuffer) {
+                out << " " << layout_name(barrier.src.layout) << " -> " << layout_name(barrier.dst.layout);
+            }
+            out << "\n";
+        }
+    }
+    for (const Pass& pass : passes) {
+        if (pass.culled) {
+            out << "  culled " << pass.name << "\n";
+        }
+    }
+    for (const Barrier& barrier : finalBarriers) {
+        out << "  final barrier " << resources[barrier.handle].name << " " << layout_name(barrier.src.layout)
+            << " -> " << layout_name(barrier.dst.layout) << "\n";
+    }
+
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        out << "  memory block " << b << " (" << std::fixed << std::setprecision(2) << to_mib(buckets[b].size)
+            << " MiB):";
+        for (uint32_t handle : buckets[b].occupants) {
+            const Resource& resource = resources[handle];
+            out << " " << resource.name << "[" << resource.firstUse << "-" << resource.lastUse << "]";
+        }
+        out << "\n";
+    }
+
+    VkDeviceSize saved = stats.transientBytes - stats.allocatedBytes;
+    double percent = stats.transientBytes ? 100.0 * static_cast<double>(saved) / static_cast<double>(stats.transientBytes) : 0.0;
+    out << "  transient memory: " << std::fixed << std::setprecision(2) << to_mib(stats.transientBytes)
+        << " MiB requested, " << to_mib(stats.allocatedBytes) << " MiB allocated, " << to_mib(saved)
+        << " MiB saved (" << std::setprecision(1) << percent << "%)\n";
+}
+
+VkImage RenderGraph::get_image(RGHandle handle) const {
+    return resources.at(handle).image;
+}
+
+VkImageView RenderGraph::get_image_view(RGHandle handle) const {
+    return resources.at(handle).view;
+}
+
+VkBuffer RenderGraph::get_buffer(RGHandle handle) const {
+    return resources.at(handle).buffer;
+}
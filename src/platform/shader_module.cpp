@@ -0,0 +1,70 @@
+#include "platform/shader_module.hpp"
+#include "platform/embedded_shaders.hpp"
+#include <cstring>
+#include <stdexcept>
+
+const EmbeddedShader* find_embedded_shader(const char* name) {
+    for (size_t i = 0; i < EMBEDDED_SHADER_COUNT; ++i) {
+        if (strcmp(EMBEDDED_SHADERS[i].name, name) == 0) {
+            return &EMBEDDED_SHADERS[i];
+        }
+    }
+    return nullptr;
+}
+
+VkShaderModule load_shader_module(VkDevice device, const std::string& name) {
+    const EmbeddedShader* shader = find_embedded_shader(name.c_str());
+    if (!shader) {
+        throw std::runtime_error("Shader not embedded (add it to ENGINE_SHADERS): " + name);
+    }
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = shader->wordCount * sizeof(uint32_t);
+    createInfo.pCode = shader->code;
+
+    VkShaderModule module;
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create shader module: " + name);
+    }
+    return module;
+}
+
+SpecializationConstants& SpecializationConstants::set_word(uint32_t constantId, uint32_t word) {
+    for (const VkSpecializationMapEntry& entry : entries) {
+        if (entry.constantID == constantId) {
+            data[entry.offset / sizeof(uint32_t)] = word;
+            return *this;
+        }
+    }
+    entries.push_back({constantId, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t)});
+    data.push_back(word);
+    return *this;
+}
+
+SpecializationConstants& SpecializationConstants::set(uint32_t constantId, uint32_t value) {
+    return set_word(constantId, value);
+}
+
+SpecializationConstants& SpecializationConstants::set(uint32_t constantId, int32_t value) {
+    return set_word(constantId, static_cast<uint32_t>(value));
+}
+
+SpecializationConstants& SpecializationConstants::set(uint32_t constantId, float value) {
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    return set_word(constantId, word);
+}
+
+SpecializationConstants& SpecializationConstants::set(uint32_t constantId, bool value) {
+    return set_word(constantId, value ? VK_TRUE : VK_FALSE);
+}
+
+VkSpecializationInfo SpecializationConstants::info() const {
+    VkSpecializationInfo specialization{};
+    specialization.mapEntryCount = static_cast<uint32_t>(entries.size());
+    specialization.pMapEntries = entries.data();
+    specialization.dataSize = data.size() * sizeof(uint32_t);
+    specialization.pData = data.data();
+    return specialization;
+}
@@ -0,0 +1,220 @@
+#include "platform/shm_presenter.hpp"
+#include "shm_renderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+ShmPresenter::ShmPresenter(VkPhysicalDevice physicalDevice, VkDevice device, ShmRenderer& shmRenderer,
+                           VkExtent2D extent, uint32_t frameSlots, bool hostImport)
+    : physicalDevice(physicalDevice), device(device), shmRenderer(shmRenderer), extent(extent),
+      slotPoolIndex(frameSlots, -1) {
+    VkDeviceSize alignment = 4096;
+    if (hostImport) {
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProps{};
+        hostProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 props{};
+        props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props.pNext = &hostProps;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &props);
+        alignment = std::max<VkDeviceSize>(alignment, hostProps.minImportedHostPointerAlignment);
+    }
+
+    // One wl_shm buffer per slot in flight plus one the compositor can hold on to
+    shmRenderer.create_buffer_pool(static_cast<int>(extent.width), static_cast<int>(extent.height),
+                                   static_cast<int>(frameSlots + 1), static_cast<size_t>(alignment));
+    create_image();
+
+    zeroCopy = hostImport && import_pool();
+    if (!zeroCopy) {
+        VkDeviceSize bytes = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+        for (uint32_t i = 0; i < frameSlots; ++i) {
+            stagingBuffers.push_back(create_gpu_buffer(physicalDevice, device, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VK_MEMORY_PROPERTY_HOST_CACHED_BIT));
+        }
+    }
+
+    std::cout << "[ShmPresenter] " << extent.width << "x" << extent.height << " via wl_shm, "
+              << (zeroCopy ? "zero-copy host import" : "staging copy") << "\n";
+}
+
+ShmPresenter::~ShmPresenter() {
+    for (VkBuffer buffer : importedBuffers) {
+        vkDestroyBuffer(device, buffer, nullptr);
+    }
+    if (importedMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, importedMemory, nullptr);
+    }
+    for (GpuBuffer& buffer : stagingBuffers) {
+        destroy_gpu_buffer(device, buffer);
+    }
+    vkDestroyImageView(device, imageView, nullptr);
+    vkDestroyImage(device, image, nullptr);
+    vkFreeMemory(device, imageMemory, nullptr);
+
+    double perFrame = stats.presented ? stats.copyMilliseconds / static_cast<double>(stats.presented) : 0.0;
+    std::cout << "[ShmPresenter] " << stats.presented << " presented, " << stats.dropped << " dropped, "
+              << perFrame << " ms CPU copy per frame\n";
+}
+
+void ShmPresenter::create_image() {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = get_format();
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create SHM presenter image!");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image, &requirements);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = find_memory_type(physicalDevice, requirements.memoryTypeBits,
+                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate SHM presenter image memory!");
+    }
+    vkBindImageMemory(device, image, imageMemory, 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = get_format();
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create SHM presenter image view!");
+    }
+}
+
+// Imports the whole wl_shm mapping as device memory; any failure falls back to staging
+bool ShmPresenter::import_pool() {
+    auto getHostPointerProperties = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+        vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT"));
+    if (!getHostPointerProperties) {
+        return false;
+    }
+
+    const VkExternalMemoryHandleTypeFlagBits handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    VkMemoryHostPointerPropertiesEXT pointerProps{};
+    pointerProps.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+    if (getHostPointerProperties(device, handleType, shmRenderer.pool_data(), &pointerProps) != VK_SUCCESS ||
+        pointerProps.memoryTypeBits == 0) {
+        return false;
+    }
+
+    VkExternalMemoryBufferCreateInfo externalInfo{};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    externalInfo.handleTypes = handleType;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = &externalInfo;
+    bufferInfo.size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    uint32_t typeBits = pointerProps.memoryTypeBits;
+    for (int i = 0; i < shmRenderer.pool_buffer_count(); ++i) {
+        VkBuffer buffer;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+            return false;
+        }
+        importedBuffers.push_back(buffer);
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        typeBits &= requirements.memoryTypeBits;
+    }
+    if (typeBits == 0) {
+        return false;
+    }
+
+    VkImportMemoryHostPointerInfoEXT importInfo{};
+    importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    importInfo.handleType = handleType;
+    importInfo.pHostPointer = shmRenderer.pool_data();
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = &importInfo;
+    allocInfo.allocationSize = shmRenderer.pool_size();
+    allocInfo.memoryTypeIndex = find_memory_type(physicalDevice, typeBits, 0);
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &importedMemory) != VK_SUCCESS) {
+        importedMemory = VK_NULL_HANDLE;
+        return false;
+    }
+
+    for (int i = 0; i < shmRenderer.pool_buffer_count(); ++i) {
+        if (vkBindBufferMemory(device, importedBuffers[i], importedMemory, shmRenderer.pool_buffer_offset(i)) != VK_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShmPresenter::add_to_graph(RenderGraph& graph, RGHandle target, uint32_t frameSlot) {
+    int poolIndex = shmRenderer.acquire_pool_buffer();
+    if (poolIndex < 0) {
+        stats.dropped++; // The compositor still holds every buffer; render without presenting
+        return;
+    }
+    slotPoolIndex[frameSlot] = poolIndex;
+
+    VkBuffer destination = zeroCopy ? importedBuffers[poolIndex] : stagingBuffers[frameSlot].buffer;
+    VkImage source = image;
+    VkExtent2D copyExtent = extent;
+    graph.add_pass("shm_readback",
+        [&](RenderGraph::PassBuilder& builder) {
+            builder.read(target, RGUsage::TransferSrc);
+            builder.side_effect();
+        },
+        [source, destination, copyExtent](VkCommandBuffer cmdBuffer) {
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            region.imageExtent = {copyExtent.width, copyExtent.height, 1};
+            vkCmdCopyImageToBuffer(cmdBuffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination, 1, &region);
+
+            VkMemoryBarrier2 toHost{};
+            toHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            toHost.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+            toHost.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            toHost.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+            toHost.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+            VkDependencyInfo dependency{};
+            dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependency.memoryBarrierCount = 1;
+            dependency.pMemoryBarriers = &toHost;
+            vkCmdPipelineBarrier2(cmdBuffer, &dependency);
+        });
+}
+
+void ShmPresenter::present_completed(uint32_t frameSlot) {
+    int poolIndex = slotPoolIndex[frameSlot];
+    if (poolIndex < 0) {
+        return;
+    }
+    slotPoolIndex[frameSlot] = -1;
+
+    if (!zeroCopy) {
+        auto start = std::chrono::steady_clock::now();
+        std::memcpy(shmRenderer.pool_buffer_data(poolIndex), stagingBuffers[frameSlot].mapped,
+                    static_cast<size_t>(extent.width) * extent.height * 4);
+        stats.copyMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    shmRenderer.present_pool_buffer(poolIndex);
+    stats.presented++;
+}
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 ShmRenderer::ShmRenderer(wl_display* display, wl_surface* surface)
     : display(display), surface(surface), buffer(nullptr), width(800), height(600) {
@@ -16,10 +17,106 @@ ShmRenderer::ShmRenderer(wl_display* display, wl_surface* surface)
     std::cout << "[ShmRenderer] wl_shm interface successfully assigned." << std::endl;
 }
 
+ShmRenderer::ShmRenderer(wl_display* display, wl_surface* surface, wl_shm* shm)
+    : display(display), surface(surface), shm(shm), buffer(nullptr), width(800), height(600) {
+    if (!shm) {
+        throw std::runtime_error("Failed to bind wl_shm interface.");
+    }
+}
+
 ShmRenderer::~ShmRenderer() {
     if (buffer) {
         wl_buffer_destroy(buffer);
     }
+    destroy_buffer_pool();
+}
+
+static void pool_buffer_release(void* data, wl_buffer* /*buffer*/) {
+    *static_cast<bool*>(data) = false;
+}
+
+static const wl_buffer_listener pool_buffer_listener = {
+    .release = pool_buffer_release
+};
+
+void ShmRenderer::create_buffer_pool(int poolWidth, int poolHeight, int count, size_t alignment) {
+    destroy_buffer_pool();
+    width = poolWidth;
+    height = poolHeight;
+
+    int stride = width * 4;
+    size_t bufferSize = static_cast<size_t>(stride) * height;
+    size_t alignedSize = (bufferSize + alignment - 1) / alignment * alignment;
+    poolSize = alignedSize * count;
+
+    int fd = memfd_create("shm_pool", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared memory file.");
+    }
+    if (ftruncate(fd, poolSize) < 0) {
+        close(fd);
+        throw std::runtime_error("Failed to set size of shared memory file.");
+    }
+
+    poolData = mmap(nullptr, poolSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (poolData == MAP_FAILED) {
+        poolData = nullptr;
+        close(fd);
+        throw std::runtime_error("Failed to map shared memory.");
+    }
+
+    wl_shm_pool* pool = wl_shm_create_pool(shm, fd, static_cast<int32_t>(poolSize));
+    poolBuffers.resize(count);
+    for (int i = 0; i < count; ++i) {
+        PoolBuffer& entry = poolBuffers[i];
+        entry.offset = alignedSize * i;
+        entry.busy = false;
+        entry.reserved = false;
+        entry.buffer = wl_shm_pool_create_buffer(pool, static_cast<int32_t>(entry.offset), width, height, stride,
+                                                 WL_SHM_FORMAT_ARGB8888);
+        wl_buffer_add_listener(entry.buffer, &pool_buffer_listener, &entry.busy);
+    }
+    wl_shm_pool_destroy(pool);
+    close(fd); // The compositor and our mapping keep the memory alive
+}
+
+void ShmRenderer::destroy_buffer_pool() {
+    for (PoolBuffer& entry : poolBuffers) {
+        wl_buffer_destroy(entry.buffer);
+    }
+    poolBuffers.clear();
+    if (poolData) {
+        munmap(poolData, poolSize);
+        poolData = nullptr;
+    }
+    poolSize = 0;
+}
+
+int ShmRenderer::acquire_pool_buffer() {
+    for (size_t i = 0; i < poolBuffers.size(); ++i) {
+        if (!poolBuffers[i].busy && !poolBuffers[i].reserved) {
+            poolBuffers[i].reserved = true;
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void ShmRenderer::present_pool_buffer(int index) {
+    PoolBuffer& entry = poolBuffers.at(index);
+    entry.reserved = false;
+    entry.busy = true;
+    wl_surface_attach(surface, entry.buffer, 0, 0);
+    wl_surface_damage(surface, 0, 0, width, height);
+    wl_surface_commit(surface);
+}
+
+void* ShmRenderer::pool_buffer_data(int index) const {
+    return static_cast<uint8_t*>(poolData) + poolBuffers.at(index).offset;
+}
+
+size_t ShmRenderer::pool_buffer_offset(int index) const {
+    return poolBuffers.at(index).offset;
 }
 
 void ShmRenderer::create_buffer(uint32_t color) {
@@ -1,5 +1,7 @@
 #pragma once
 #include <wayland-client.h>
+#include <cstddef>
+#include <vector>
 
 extern wl_shm* shm; // Declare the global wl_shm pointer as extern
 
@@ -8,10 +10,23 @@ wl_buffer *create_shm_buffer(wl_shm *shm, int width, int height, uint32_t color)
 class ShmRenderer {
 public:
     ShmRenderer(wl_display* display, wl_surface* surface);
+    ShmRenderer(wl_display* display, wl_surface* surface, wl_shm* shm);
     ~ShmRenderer();
 
     void draw_background(uint32_t color);
 
+    // Persistent pool of ARGB8888 buffers in one memfd, for producers such as the Vulkan
+    // SHM presenter. Each buffer starts at a multiple of `alignment` bytes.
+    void create_buffer_pool(int width, int height, int count, size_t alignment = 4096);
+    int acquire_pool_buffer();             // Reserves a buffer; -1 while all are held or reserved
+    void present_pool_buffer(int index);   // Attach, damage and commit
+    void* pool_buffer_data(int index) const;
+    void* pool_data() const { return poolData; }
+    size_t pool_size() const { return poolSize; }
+    size_t pool_buffer_offset(int index) const;
+    int pool_stride() const { return width * 4; }
+    int pool_buffer_count() const { return static_cast<int>(poolBuffers.size()); }
+
 private:
     wl_display* display;
     wl_surface* surface;
@@ -21,4 +36,15 @@ private:
     int height;
 
     void create_buffer(uint32_t color);
+    void destroy_buffer_pool();
+
+    struct PoolBuffer {
+        wl_buffer* buffer;
+        size_t offset;
+        bool busy;     // Attached and not yet released by the compositor
+        bool reserved; // Handed to a producer that has not presented it yet
+    };
+    std::vector<PoolBuffer> poolBuffers;
+    void* poolData = nullptr;
+    size_t poolSize = 0;
 };
@@ -0,0 +1,113 @@
+#include "platform/vulkan_buffer.hpp"
+#include <stdexcept>
+
+namespace {
+uint32_t try_find_memory_type(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Bit per memory type that has every one of `properties`
+uint32_t memory_types_with(VkPhysicalDevice physicalDevice, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    uint32_t types = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            types |= 1u << i;
+        }
+    }
+    return types;
+}
+}
+
+uint32_t find_memory_type(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags properties) {
+    uint32_t index = try_find_memory_type(physicalDevice, typeBits, properties);
+    if (index == UINT32_MAX) {
+        throw std::runtime_error("Failed to find a suitable memory type!");
+    }
+    return index;
+}
+
+GpuBuffer create_gpu_buffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size,
+                            VkBufferUsageFlags usage, VkMemoryPropertyFlags required,
+                            VkMemoryPropertyFlags preferred) {
+    GpuBuffer result;
+    result.size = size;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &result.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create buffer!");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, result.buffer, &requirements);
+
+    uint32_t memoryType = try_find_memory_type(physicalDevice, requirements.memoryTypeBits, required | preferred);
+    if (memoryType == UINT32_MAX) {
+        memoryType = find_memory_type(physicalDevice, requirements.memoryTypeBits, required);
+    }
+
+    // Buffers queried through vkGetBufferDeviceAddress need device-address capable memory
+    VkMemoryAllocateFlagsInfo allocFlags{};
+    allocFlags.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlags.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &allocFlags : nullptr;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkResult allocated = vkAllocateMemory(device, &allocInfo, nullptr, &result.memory);
+    // The preferred heap can be small (256 MB of ReBAR without resizable BAR), so running
+    // out of it retries once with a type that only has the required properties
+    if (allocated == VK_ERROR_OUT_OF_DEVICE_MEMORY && preferred != 0) {
+        uint32_t fallbackBits = requirements.memoryTypeBits & ~memory_types_with(physicalDevice, required | preferred);
+        uint32_t fallbackType = try_find_memory_type(physicalDevice, fallbackBits, required);
+        if (fallbackType != UINT32_MAX && fallbackType != memoryType) {
+            allocInfo.memoryTypeIndex = fallbackType;
+            allocated = vkAllocateMemory(device, &allocInfo, nullptr, &result.memory);
+        }
+    }
+    if (allocated != VK_SUCCESS) {
+        vkDestroyBuffer(device, result.buffer, nullptr);
+        throw std::runtime_error("Failed to allocate buffer memory!");
+    }
+    vkBindBufferMemory(device, result.buffer, result.memory, 0);
+
+    if (required & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, result.memory, 0, VK_WHOLE_SIZE, 0, &result.mapped) != VK_SUCCESS) {
+            destroy_gpu_buffer(device, result);
+            throw std::runtime_error("Failed to map buffer memory!");
+        }
+    }
+    return result;
+}
+
+void destroy_gpu_buffer(VkDevice device, GpuBuffer& buffer) {
+    if (buffer.mapped) {
+        vkUnmapMemory(device, buffer.memory);
+        buffer.mapped = nullptr;
+    }
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+        buffer.buffer = VK_NULL_HANDLE;
+    }
+    if (buffer.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, buffer.memory, nullptr);
+        buffer.memory = VK_NULL_HANDLE;
+    }
+    buffer.size = 0;
+}
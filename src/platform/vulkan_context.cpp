@@ -1,14 +1,20 @@
 #include "platform/vulkan_context.hpp"
+#include "shm_renderer.hpp"
+#include <chrono>
 #include <iostream>
 #include <vulkan/vulkan_wayland.h> // Include Vulkan Wayland extension header
 #include <wayland-client.h> // Include Wayland client header
 #include <string.h>
+#include <cstdlib>
+#include <algorithm>
 
 // Registry listener to bind to wl_compositor
 static void registry_handler(void* data, wl_registry* registry, uint32_t id, const char* interface, uint32_t version) {
     VulkanContext* context = static_cast<VulkanContext*>(data);
     if (strcmp(interface, "wl_compositor") == 0) {
         context->waylandCompositor = static_cast<wl_compositor*>(wl_registry_bind(registry, id, &wl_compositor_interface, 1));
+    } else if (strcmp(interface, "wl_shm") == 0) {
+        context->waylandShm = static_cast<wl_shm*>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
     }
 }
 
@@ -21,49 +27,101 @@ static const wl_registry_listener registry_listener = {
     registry_remover
 };
 
-VulkanContext::VulkanContext(wl_display* display, wl_surface* surface)
-    : waylandDisplay(display), waylandSurface(surface), waylandCompositor(nullptr) {
+// Frames between captures; malformed values fall back to every frame, huge ones are clamped
+static uint32_t capture_interval_from_env() {
+    const char* interval = getenv("ENGINE_CAPTURE_INTERVAL");
+    if (!interval) {
+        return 1;
+    }
+    char* end = nullptr;
+    long value = strtol(interval, &end, 10);
+    if (end == interval || *end != '\0') {
+        std::cout << "[Vulkan] Ignoring ENGINE_CAPTURE_INTERVAL=" << interval << ", not a number\n";
+        return 1;
+    }
+    long clamped = std::clamp<long>(value, 1, UINT32_MAX);
+    if (clamped != value) {
+        std::cout << "[Vulkan] ENGINE_CAPTURE_INTERVAL=" << interval << " clamped to " << clamped << "\n";
+    }
+    return static_cast<uint32_t>(clamped);
+}
+
+VulkanContext::VulkanContext(wl_display* display, wl_surface* surface, PresentPath presentPath)
+    : waylandDisplay(display), waylandSurface(surface), waylandCompositor(nullptr), presentPath(presentPath) {
     wl_registry* registry = wl_display_get_registry(display);
     wl_registry_add_listener(registry, &registry_listener, this);
     wl_display_roundtrip(display); // Ensure the registry is processed
 
     init_instance();
-    create_surface(display, surface);
+    if (presentPath == PresentPath::Swapchain) {
+        create_surface(display, surface);
+    }
     pick_physical_device();
     create_logical_device();
-    create_swapchain();
+    if (presentPath == PresentPath::Swapchain) {
+        create_swapchain();
+    } else {
+        create_shm_presenter();
+    }
     create_render_pass();
     create_framebuffers();
     create_command_pool();
     create_command_buffers();
     create_sync_objects();
 
+    if (presentPath == PresentPath::Swapchain && getenv("ENGINE_PRESENT_THREAD")) {
+        presentThread = std::make_unique<PresentThread>(device, presentQueue, queueMutex, swapchain);
+        slotAcquireSemaphores.assign(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    }
+
+    // Automated visual/perf runs enable capture from the environment
+    if (const char* captureDir = getenv("ENGINE_CAPTURE_DIR")) {
+        enable_capture(captureDir, CaptureFormat::Qoi, capture_interval_from_env());
+    }
+
     std::cout << "[Vulkan] Initialized successfully.\n";
 }
 
 VulkanContext::~VulkanContext() {
+    presentThread.reset(); // Joins before anything else touches the queue
     vkDeviceWaitIdle(device); // Ensure all Vulkan operations are complete
-
-    for (auto framebuffer : swapchainFramebuffers) {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    }
-    for (auto imageView : swapchainImageViews) {
-        vkDestroyImageView(device, imageView, nullptr);
+    // Retired swapchains and their views must go before the swapchain and surface they came from
+    deletionQueue.flush();
+
+    if (timedFrames > 0) {
+        double frames = static_cast<double>(timedFrames);
+        std::cout << "[Vulkan] " << (presentPath == PresentPath::Shm ? "wl_shm" : "swapchain") << " present: "
+                  << timedFrames << " frames, " << frameMillisecondsTotal / frames << " ms avg, "
+                  << frameMillisecondsMax << " ms max CPU per frame, " << fenceWaitMilliseconds / frames
+                  << " ms avg fence wait\n";
     }
+
+    destroy_swapchain_resources();
     vkDestroySwapchainKHR(device, swapchain, nullptr);
-    vkDestroyRenderPass(device, renderPass, nullptr);
+    if (renderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device, renderPass, nullptr);
+    }
     vkDestroyCommandPool(device, commandPool, nullptr);
 
     for (size_t i = 0; i < inFlightFences.size(); i++) {
         vkDestroyFence(device, inFlightFences[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-        vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
+    }
+    for (VkSemaphore semaphore : renderFinishedSemaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
     }
 
     if (vkSurface) {
         vkDestroySurfaceKHR(instance, vkSurface, nullptr);
     }
 
+    frameCapture.reset();
+    shmPresenter.reset();
+    pipelineCache.reset();
+    frameGraph.reset();
+    frameRing.reset();
+    bindlessHeap.reset();
+
     if (device) {
         vkDestroyDevice(device, nullptr);
     }
@@ -73,6 +131,10 @@ VulkanContext::~VulkanContext() {
     }
 
     // Wayland-specific cleanup
+    shmRenderer.reset();
+    if (waylandShm) {
+        wl_shm_destroy(waylandShm);
+    }
     if (waylandCompositor) {
         wl_compositor_destroy(waylandCompositor); // Correct cleanup for wl_compositor
     }
@@ -166,8 +228,12 @@ void VulkanContext::create_swapchain() {
     swapchainCreateInfo.imageExtent = swapchainExtent;      // Fix: Use the variable set earlier
     swapchainCreateInfo.imageArrayLayers = 1;
     swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
+        swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // Frame capture reads it back
+    }
+    swapchainUsage = swapchainCreateInfo.imageUsage;
 
-    uint32_t queueFamilyIndices[] = {0};
+    uint32_t queueFamilyIndices[] = {graphicsQueueFamily};
     swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     swapchainCreateInfo.queueFamilyIndexCount = 1;
     swapchainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
@@ -176,6 +242,7 @@ void VulkanContext::create_swapchain() {
     swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR; // Guaranteed to be supported
     swapchainCreateInfo.clipped = VK_TRUE;
+    swapchainCreateInfo.oldSwapchain = swapchain; // Lets the driver recycle images on resize
 
     if (vkCreateSwapchainKHR(device, &swapchainCreateInfo, nullptr, &swapchain) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create Vulkan swapchain!");
@@ -205,7 +272,28 @@ void VulkanContext::create_swapchain() {
     }
 }
 
+// The SHM path renders into an offscreen image the same size the swapchain would default to
+void VulkanContext::create_shm_presenter() {
+    if (!dynamicRenderingEnabled) {
+        throw std::runtime_error("SHM presentation requires Vulkan 1.3 dynamic rendering!");
+    }
+    if (!waylandShm) {
+        throw std::runtime_error("Compositor does not advertise wl_shm!");
+    }
+
+    shmRenderer = std::make_unique<ShmRenderer>(waylandDisplay, waylandSurface, waylandShm);
+    shmPresenter = std::make_unique<ShmPresenter>(physicalDevice, device, *shmRenderer, VkExtent2D{800, 600},
+                                                  MAX_FRAMES_IN_FLIGHT, hostMemoryImportEnabled);
+    swapchainExtent = shmPresenter->get_extent();
+    swapchainImageFormat = shmPresenter->get_format();
+    swapchainUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+}
+
 void VulkanContext::create_render_pass() {
+    if (dynamicRenderingEnabled || renderPass != VK_NULL_HANDLE) {
+        return; // Dynamic rendering needs no render pass object; the legacy one survives resizes
+    }
+
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = swapchainImageFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -258,15 +346,104 @@ void VulkanContext::create_logical_device() {
     queueCreate.queueCount = 1;
     queueCreate.pQueuePriorities = &priority;
 
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+    auto has_extension = [&availableExtensions](const char* name) {
+        for (const VkExtensionProperties& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    bool libraryExtensions = has_extension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+                             has_extension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+
+    // Probe for Vulkan 1.3 dynamic rendering/synchronization2 and 1.2 descriptor indexing
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supportedLibrary{};
+    supportedLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    VkPhysicalDeviceVulkan13Features supported13{};
+    supported13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    supported13.pNext = libraryExtensions ? &supportedLibrary : nullptr;
+    VkPhysicalDeviceVulkan12Features supported12{};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supported12.pNext = &supported13;
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_3) {
+        supportedFeatures.pNext = &supported12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+    } else {
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures.features);
+    }
+    dynamicRenderingEnabled = supported13.dynamicRendering && supported13.synchronization2;
+    bool bindlessSupported = BindlessHeap::is_supported(supported12);
+    multiDrawIndirectEnabled = supportedFeatures.features.multiDrawIndirect &&
+                               supportedFeatures.features.drawIndirectFirstInstance;
+    drawIndirectCountEnabled = multiDrawIndirectEnabled && supported12.drawIndirectCount;
+    bufferDeviceAddressEnabled = supported12.bufferDeviceAddress;
+    // Libraries are built against VkPipelineRenderingCreateInfo, so they follow dynamic rendering
+    pipelineLibraryEnabled = dynamicRenderingEnabled && supportedLibrary.graphicsPipelineLibrary;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabledLibrary{};
+    enabledLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    enabledLibrary.graphicsPipelineLibrary = VK_TRUE;
+
+    VkPhysicalDeviceVulkan13Features enabled13{};
+    enabled13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    enabled13.dynamicRendering = dynamicRenderingEnabled ? VK_TRUE : VK_FALSE;
+    enabled13.synchronization2 = dynamicRenderingEnabled ? VK_TRUE : VK_FALSE;
+    enabled13.pNext = pipelineLibraryEnabled ? &enabledLibrary : nullptr;
+
+    VkPhysicalDeviceVulkan12Features enabled12{};
+    enabled12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    enabled12.pNext = &enabled13;
+    if (bindlessSupported) {
+        enabled12.descriptorIndexing = VK_TRUE;
+        enabled12.runtimeDescriptorArray = VK_TRUE;
+        enabled12.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        enabled12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        enabled12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        enabled12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    }
+    enabled12.drawIndirectCount = drawIndirectCountEnabled ? VK_TRUE : VK_FALSE;
+    enabled12.bufferDeviceAddress = bufferDeviceAddressEnabled ? VK_TRUE : VK_FALSE;
+
+    VkPhysicalDeviceFeatures2 enabledFeatures{};
+    enabledFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    enabledFeatures.pNext = &enabled12;
+    enabledFeatures.features.multiDrawIndirect = multiDrawIndirectEnabled ? VK_TRUE : VK_FALSE;
+    enabledFeatures.features.drawIndirectFirstInstance = multiDrawIndirectEnabled ? VK_TRUE : VK_FALSE;
+
     VkDeviceCreateInfo deviceCreate{};
     deviceCreate.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_3) {
+        deviceCreate.pNext = &enabledFeatures;
+    } else {
+        deviceCreate.pEnabledFeatures = &enabledFeatures.features;
+    }
     deviceCreate.queueCreateInfoCount = 1;
     deviceCreate.pQueueCreateInfos = &queueCreate;
 
-    // Enable the VK_KHR_swapchain extension
-    const std::vector<const char*> deviceExtensions = {
-        "VK_KHR_swapchain"
-    };
+    // The swapchain path needs VK_KHR_swapchain; the SHM path imports wl_shm memory when it can
+    std::vector<const char*> deviceExtensions;
+    if (presentPath == PresentPath::Swapchain) {
+        deviceExtensions.push_back("VK_KHR_swapchain");
+    } else if (has_extension(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)) {
+        deviceExtensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        hostMemoryImportEnabled = true;
+    }
+    if (pipelineLibraryEnabled) {
+        deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    }
     deviceCreate.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     deviceCreate.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -276,9 +453,37 @@ void VulkanContext::create_logical_device() {
 
     vkGetDeviceQueue(device, graphicsIndex, 0, &graphicsQueue);
     presentQueue = graphicsQueue;
+    graphicsQueueFamily = graphicsIndex;
+
+    std::cout << "[Vulkan] Rendering path: "
+              << (dynamicRenderingEnabled ? "dynamic rendering (1.3)" : "legacy render pass") << "\n";
+
+    if (dynamicRenderingEnabled) {
+        frameGraph = std::make_unique<RenderGraph>(physicalDevice, device);
+        frameGraph->set_retire_function([this](std::function<void()> destroy) { defer_destroy(std::move(destroy)); });
+        dumpFrameGraph = getenv("ENGINE_DUMP_RENDER_GRAPH") != nullptr; // Dumps the first compiled frame
+
+        const char* cachePath = getenv("ENGINE_PIPELINE_CACHE");
+        pipelineCache = std::make_unique<GraphicsPipelineCache>(physicalDevice, device,
+            [this](std::function<void()> destroy) { defer_destroy(std::move(destroy)); },
+            pipelineLibraryEnabled, cachePath ? cachePath : "pipeline_cache.bin");
+    }
+
+    frameRing = std::make_unique<FrameRingBuffer>(physicalDevice, device, FRAME_RING_BYTES,
+                                                  MAX_FRAMES_IN_FLIGHT, bufferDeviceAddressEnabled);
+
+    if (bindlessSupported) {
+        bindlessHeap = std::make_unique<BindlessHeap>(physicalDevice, device);
+    } else {
+        std::cerr << "[Vulkan] Descriptor indexing unsupported; bindless heap disabled." << std::endl;
+    }
 }
 
 void VulkanContext::create_framebuffers() {
+    if (dynamicRenderingEnabled) {
+        return; // Attachments are supplied per pass through vkCmdBeginRendering
+    }
+
     swapchainFramebuffers.resize(swapchainImageViews.size());
 
     for (size_t i = 0; i < swapchainImageViews.size(); i++) {
@@ -302,7 +507,7 @@ void VulkanContext::create_framebuffers() {
 void VulkanContext::create_command_pool() {
     VkCommandPoolCreateInfo poolCreateInfo{};
     poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolCreateInfo.queueFamilyIndex = 0; // Graphics queue
+    poolCreateInfo.queueFamilyIndex = graphicsQueueFamily;
     poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     if (vkCreateCommandPool(device, &poolCreateInfo, nullptr, &commandPool) != VK_SUCCESS) {
@@ -311,7 +516,7 @@ void VulkanContext::create_command_pool() {
 }
 
 void VulkanContext::create_command_buffers() {
-    commandBuffers.resize(swapchainImages.size());
+    commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -325,9 +530,9 @@ void VulkanContext::create_command_buffers() {
 }
 
 void VulkanContext::create_sync_objects() {
-    inFlightFences.resize(swapchainImages.size());
-    imageAvailableSemaphores.resize(swapchainImages.size());
-    renderFinishedSemaphores.resize(swapchainImages.size());
+    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    frameSubmitted.assign(MAX_FRAMES_IN_FLIGHT, 0);
 
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -336,13 +541,27 @@ void VulkanContext::create_sync_objects() {
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < swapchainImages.size(); i++) {
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
             vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create synchronization objects for a frame!");
         }
     }
+
+    create_present_semaphores();
+}
+
+// Present waits on these, so there is one per swapchain image rather than per frame
+void VulkanContext::create_present_semaphores() {
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    renderFinishedSemaphores.resize(swapchainImages.size());
+    for (size_t i = 0; i < swapchainImages.size(); i++) {
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create present semaphore!");
+        }
+    }
 }
 
 void VulkanContext::record_command_buffer(VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
@@ -353,6 +572,58 @@ void VulkanContext::record_command_buffer(VkCommandBuffer cmdBuffer, uint32_t im
         throw std::runtime_error("Failed to begin recording command buffer!");
     }
 
+    if (shmPresenter) {
+        record_dynamic_rendering(cmdBuffer, shmPresenter->get_image(), shmPresenter->get_image_view(),
+                                 RGUsage::TransferSrc);
+    } else if (dynamicRenderingEnabled) {
+        record_dynamic_rendering(cmdBuffer, swapchainImages[imageIndex], swapchainImageViews[imageIndex],
+                                 RGUsage::Present);
+    } else {
+        record_legacy_render_pass(cmdBuffer, imageIndex);
+    }
+
+    if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record command buffer!");
+    }
+}
+
+// The dynamic path records through the render graph, which owns every layout transition
+void VulkanContext::record_dynamic_rendering(VkCommandBuffer cmdBuffer, VkImage image, VkImageView view,
+                                             RGUsage finalUsage) {
+    frameGraph->reset();
+
+    // A swapchain image is only touched after the acquire semaphore's wait at colour output.
+    // The SHM image is shared by both frames in flight, so the clear must also wait for the
+    // previous frame's readback copy and any other pass that read it.
+    VkPipelineStageFlags2 initialStage = shmPresenter ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+                                                      : VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    RGHandle backbuffer = frameGraph->import_texture("backbuffer", image, view, swapchainExtent,
+                                                     VK_IMAGE_LAYOUT_UNDEFINED, finalUsage, initialStage);
+
+    static const VkClearColorValue clearColor = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    frameGraph->add_pass("clear",
+        [&](RenderGraph::PassBuilder& builder) { builder.color_attachment(backbuffer, &clearColor); },
+        nullptr);
+
+    if (frameGraphBuilder) {
+        frameGraphBuilder(*frameGraph, backbuffer);
+    }
+    if (frameCapture) {
+        frameCapture->add_to_graph(*frameGraph, backbuffer, swapchainExtent, swapchainImageFormat, frameNumber + 1);
+    }
+    if (shmPresenter) {
+        shmPresenter->add_to_graph(*frameGraph, backbuffer, currentFrame);
+    }
+
+    frameGraph->compile();
+    if (dumpFrameGraph) {
+        frameGraph->dump(std::cout);
+        dumpFrameGraph = false;
+    }
+    frameGraph->execute(cmdBuffer);
+}
+
+void VulkanContext::record_legacy_render_pass(VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
     VkClearValue clearColor = {};
     clearColor.color = {0.0f, 0.0f, 0.0f, 1.0f};
 
@@ -367,29 +638,136 @@ void VulkanContext::record_command_buffer(VkCommandBuffer cmdBuffer, uint32_t im
 
     vkCmdBeginRenderPass(cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdEndRenderPass(cmdBuffer);
+}
 
-    if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to record command buffer!");
+void VulkanContext::destroy_swapchain_resources() {
+    for (auto framebuffer : swapchainFramebuffers) {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
     }
+    swapchainFramebuffers.clear();
+    for (auto imageView : swapchainImageViews) {
+        vkDestroyImageView(device, imageView, nullptr);
+    }
+    swapchainImageViews.clear();
+}
+
+// Old views, framebuffers, semaphores and the retired swapchain go through the deletion
+// queue instead of idling the device; they are destroyed once in-flight frames finish.
+void VulkanContext::recreate_swapchain() {
+    std::vector<VkImageView> oldViews = std::move(swapchainImageViews);
+    std::vector<VkFramebuffer> oldFramebuffers = std::move(swapchainFramebuffers);
+    std::vector<VkSemaphore> oldSemaphores = std::move(renderFinishedSemaphores);
+    swapchainImageViews.clear();
+    swapchainFramebuffers.clear();
+    renderFinishedSemaphores.clear();
+
+    VkSwapchainKHR oldSwapchain = swapchain;
+    create_swapchain();
+
+    VkDevice dev = device;
+    defer_destroy([dev, oldViews, oldFramebuffers, oldSemaphores, oldSwapchain]() {
+        for (auto framebuffer : oldFramebuffers) {
+            vkDestroyFramebuffer(dev, framebuffer, nullptr);
+        }
+        for (auto imageView : oldViews) {
+            vkDestroyImageView(dev, imageView, nullptr);
+        }
+        for (auto semaphore : oldSemaphores) {
+            vkDestroySemaphore(dev, semaphore, nullptr);
+        }
+        vkDestroySwapchainKHR(dev, oldSwapchain, nullptr);
+    });
+
+    // Only the legacy path has per-image framebuffers to rebuild
+    create_framebuffers();
+    create_present_semaphores();
 }
 
-void VulkanContext::draw_frame() {
-    static size_t currentFrame = 0;
+void VulkanContext::defer_destroy(std::function<void()> destroy) {
+    // Anything recorded so far may be used by the next submission at the latest
+    deletionQueue.retire(frameNumber + 1, std::move(destroy));
+}
+
+void VulkanContext::defer_destroy(GpuBuffer& buffer) {
+    GpuBuffer retired = buffer;
+    buffer = GpuBuffer{};
+    VkDevice dev = device;
+    defer_destroy([dev, retired]() mutable { destroy_gpu_buffer(dev, retired); });
+}
 
+uint64_t VulkanContext::get_frame_number() const {
+    return frameNumber;
+}
+
+uint64_t VulkanContext::get_completed_frame() const {
+    return completedFrame;
+}
+
+PresentPath VulkanContext::get_present_path() const {
+    return presentPath;
+}
+
+bool VulkanContext::draw_frame() {
+    auto start = std::chrono::steady_clock::now();
+    bool presented = presentPath == PresentPath::Shm ? draw_frame_shm() : draw_frame_swapchain();
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    timedFrames++;
+    frameMillisecondsTotal += milliseconds;
+    frameMillisecondsMax = std::max(frameMillisecondsMax, milliseconds);
+    return presented;
+}
+
+// Waits for the current slot's previous frame and recycles everything it was using
+void VulkanContext::begin_frame_slot() {
+    auto waitStart = std::chrono::steady_clock::now();
     vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &inFlightFences[currentFrame]);
+    fenceWaitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+
+    // Frames retire in submission order, so this slot's frame is the newest one known complete
+    completedFrame = std::max(completedFrame, frameSubmitted[currentFrame]);
+    deletionQueue.collect(completedFrame);
+    frameRing->begin_frame(currentFrame);
+    if (frameCapture) {
+        frameCapture->collect(completedFrame);
+    }
+    if (pipelineCache) {
+        pipelineCache->collect();
+    }
+    if (presentThread) {
+        presentThread->release_semaphore(slotAcquireSemaphores[currentFrame]); // Its wait has executed
+        slotAcquireSemaphores[currentFrame] = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanContext::submit(const VkSubmitInfo& submitInfo) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to submit draw command buffer!");
+    }
+}
+
+bool VulkanContext::draw_frame_swapchain() {
+    if (presentThread) {
+        return draw_frame_async();
+    }
+    begin_frame_slot();
 
     uint32_t imageIndex;
     VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-    if (result != VK_SUCCESS) {
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreate_swapchain();
+        return false;
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("Failed to acquire next image from swapchain!");
     }
+    vkResetFences(device, 1, &inFlightFences[currentFrame]); // Only reset once work is guaranteed to be submitted
 
-    record_command_buffer(commandBuffers[imageIndex], imageIndex);
+    record_command_buffer(commandBuffers[currentFrame], imageIndex);
 
     VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+    VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[imageIndex]};
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -397,13 +775,12 @@ void VulkanContext::draw_frame() {
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+    submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to submit draw command buffer!");
-    }
+    submit(submitInfo);
+    frameSubmitted[currentFrame] = ++frameNumber;
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -413,12 +790,78 @@ void VulkanContext::draw_frame() {
     presentInfo.pSwapchains = &swapchain;
     presentInfo.pImageIndices = &imageIndex;
 
-    result = vkQueuePresentKHR(presentQueue, &presentInfo);
-    if (result != VK_SUCCESS) {
+    if (presentHook) {
+        presentHook();
+    }
+    result = vkQueuePresentKHR(presentQueue, &presentInfo); // No present thread, so the queue is ours
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        recreate_swapchain();
+    } else if (result != VK_SUCCESS) {
         throw std::runtime_error("Failed to present swapchain image!");
     }
 
-    currentFrame = (currentFrame + 1) % swapchainImages.size();
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return result != VK_ERROR_OUT_OF_DATE_KHR;
+}
+
+// Same frame as draw_frame_swapchain, but the image comes pre-acquired from the present
+// thread and the present is queued to it; only an unready image makes this thread wait.
+bool VulkanContext::draw_frame_async() {
+    begin_frame_slot();
+
+    PresentThread::AcquiredImage image;
+    if (!presentThread->acquire(image)) {
+        recreate_swapchain(); // The present thread is parked with nothing queued
+        presentThread->resume(swapchain);
+        return false;
+    }
+    vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+    record_command_buffer(commandBuffers[currentFrame], image.imageIndex);
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &image.semaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &renderFinishedSemaphores[image.imageIndex];
+
+    submit(submitInfo);
+    frameSubmitted[currentFrame] = ++frameNumber;
+    slotAcquireSemaphores[currentFrame] = image.semaphore;
+
+    presentThread->present(image.imageIndex, renderFinishedSemaphores[image.imageIndex]);
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return true;
+}
+
+// No acquire or present semaphores: the slot's fence is the only signal that its wl_shm
+// buffer is filled, so each frame is committed when its slot comes round again.
+bool VulkanContext::draw_frame_shm() {
+    begin_frame_slot();
+    bool presented = shmPresenter->has_completed(currentFrame);
+    if (presented && presentHook) {
+        presentHook();
+    }
+    shmPresenter->present_completed(currentFrame);
+
+    vkResetFences(device, 1, &inFlightFences[currentFrame]);
+    record_command_buffer(commandBuffers[currentFrame], 0);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
+
+    submit(submitInfo);
+    frameSubmitted[currentFrame] = ++frameNumber;
+
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return presented;
 }
 
 wl_display* VulkanContext::get_display() const {
@@ -429,6 +872,79 @@ wl_surface* VulkanContext::get_surface() const {
     return waylandSurface; // Return the stored Wayland surface
 }
 
+bool VulkanContext::uses_dynamic_rendering() const {
+    return dynamicRenderingEnabled;
+}
+
+VkDevice VulkanContext::get_device() const {
+    return device;
+}
+
+VkPhysicalDevice VulkanContext::get_physical_device() const {
+    return physicalDevice;
+}
+
+BindlessHeap* VulkanContext::get_bindless_heap() const {
+    return bindlessHeap.get();
+}
+
+bool VulkanContext::supports_multi_draw_indirect() const {
+    return multiDrawIndirectEnabled;
+}
+
+bool VulkanContext::supports_draw_indirect_count() const {
+    return drawIndirectCountEnabled;
+}
+
+void VulkanContext::enable_capture(const std::string& directory, CaptureFormat format, uint32_t interval) {
+    if (!frameGraph || !(swapchainUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+        std::cerr << "[Vulkan] Frame capture needs dynamic rendering and a transfer-source swapchain." << std::endl;
+        return;
+    }
+    frameCapture = std::make_unique<FrameCapture>(physicalDevice, device,
+        [this](std::function<void()> destroy) { defer_destroy(std::move(destroy)); },
+        directory, format, interval);
+}
+
+void VulkanContext::disable_capture() {
+    if (frameCapture) {
+        std::lock_guard<std::mutex> lock(queueMutex); // Waiting idle also synchronizes the queue
+        vkDeviceWaitIdle(device); // Rare, user-triggered; in-flight copies must land first
+        frameCapture.reset();
+    }
+}
+
+FrameCapture* VulkanContext::get_frame_capture() const {
+    return frameCapture.get();
+}
+
+FrameRingBuffer* VulkanContext::get_frame_ring() const {
+    return frameRing.get();
+}
+
+uint32_t VulkanContext::get_frame_slot() const {
+    return currentFrame;
+}
+
+RenderGraph* VulkanContext::get_render_graph() const {
+    return frameGraph.get();
+}
+
+GraphicsPipelineCache* VulkanContext::get_pipeline_cache() const {
+    return pipelineCache.get();
+}
+
+void VulkanContext::set_frame_graph_builder(FrameGraphBuilder builder) {
+    frameGraphBuilder = std::move(builder);
+}
+
+void VulkanContext::set_present_hook(std::function<void()> hook) {
+    if (presentThread) {
+        presentThread->set_present_hook(hook);
+    }
+    presentHook = std::move(hook);
+}
+
 void VulkanContext::process_wayland_events() {
     if (waylandDisplay) {
         wl_display_dispatch_pending(waylandDisplay);
@@ -0,0 +1,753 @@
+#include "scene/bvh.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+constexpr uint32_t SAH_BINS = 12;
+
+float surface_area(const Aabb& bounds) {
+    float dx = bounds.max[0] - bounds.min[0];
+    float dy = bounds.max[1] - bounds.min[1];
+    float dz = bounds.max[2] - bounds.min[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+Aabb merge(const Aabb& a, const Aabb& b) {
+    Aabb merged;
+    for (int axis = 0; axis < 3; axis++) {
+        merged.min[axis] = std::min(a.min[axis], b.min[axis]);
+        merged.max[axis] = std::max(a.max[axis], b.max[axis]);
+    }
+    return merged;
+}
+
+Aabb empty_bounds() {
+    return {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+bool contains(const Aabb& outer, const Aabb& inner) {
+    for (int axis = 0; axis < 3; axis++) {
+        if (inner.min[axis] < outer.min[axis] || inner.max[axis] > outer.max[axis]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool equal(const Aabb& a, const Aabb& b) {
+    return memcmp(&a, &b, sizeof(Aabb)) == 0;
+}
+
+uint32_t lane_mask(uint32_t count) {
+    return (1u << count) - 1u;
+}
+}
+
+Frustum Frustum::from_view_projection(const float m[16]) {
+    Frustum frustum;
+    auto row = [&](int r, int c) { return m[c * 4 + r]; };
+    for (int c = 0; c < 4; ++c) {
+        frustum.planes[0][c] = row(3, c) + row(0, c); // Left
+        frustum.planes[1][c] = row(3, c) - row(0, c); // Right
+        frustum.planes[2][c] = row(3, c) + row(1, c); // Bottom
+        frustum.planes[3][c] = row(3, c) - row(1, c); // Top
+        frustum.planes[4][c] = row(2, c);             // Near
+        frustum.planes[5][c] = row(3, c) - row(2, c); // Far
+    }
+    for (auto& plane : frustum.planes) {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (float& value : plane) {
+                value /= length;
+            }
+        }
+    }
+    return frustum;
+}
+
+DynamicBvh::DynamicBvh(float margin) : margin(margin) {
+}
+
+DynamicBvh::~DynamicBvh() {
+    if (pending) {
+        pending->jobs->wait(pending->counter); // The build job writes into `pending`
+    }
+}
+
+uint32_t DynamicBvh::allocate_node(uint32_t parent, uint32_t parentSlot) {
+    uint32_t index;
+    if (!freeNodes.empty()) {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& node = nodes[index];
+    memset(&node, 0, sizeof(Node));
+    for (uint32_t& child : node.child) {
+        child = NULL_NODE;
+    }
+    node.parent = parent;
+    node.parentSlot = parentSlot;
+    return index;
+}
+
+void DynamicBvh::free_node(uint32_t node) {
+    nodes[node].count = 0;
+    freeNodes.push_back(node);
+}
+
+void DynamicBvh::set_child(uint32_t node, uint32_t slot, uint32_t child, const Aabb& bounds) {
+    Node& n = nodes[node];
+    n.child[slot] = child;
+    n.minX[slot] = bounds.min[0];
+    n.minY[slot] = bounds.min[1];
+    n.minZ[slot] = bounds.min[2];
+    n.maxX[slot] = bounds.max[0];
+    n.maxY[slot] = bounds.max[1];
+    n.maxZ[slot] = bounds.max[2];
+    if (child & PROXY_BIT) {
+        proxies[child & ~PROXY_BIT].node = node;
+        proxies[child & ~PROXY_BIT].slot = slot;
+    } else {
+        nodes[child].parent = node;
+        nodes[child].parentSlot = slot;
+    }
+}
+
+static Aabb slot_bounds(const float* minX, const float* minY, const float* minZ, const float* maxX,
+                        const float* maxY, const float* maxZ, uint32_t slot) {
+    return {{minX[slot], minY[slot], minZ[slot]}, {maxX[slot], maxY[slot], maxZ[slot]}};
+}
+
+// Keeps children packed by moving the last one into the hole
+void DynamicBvh::remove_child(uint32_t node, uint32_t slot) {
+    Node& n = nodes[node];
+    uint32_t last = n.count - 1;
+    if (slot != last) {
+        set_child(node, slot, n.child[last], slot_bounds(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, last));
+    }
+    n.child[last] = NULL_NODE;
+    n.count--;
+}
+
+Aabb DynamicBvh::node_bounds(uint32_t node) const {
+    const Node& n = nodes[node];
+    Aabb bounds = empty_bounds();
+    for (uint32_t slot = 0; slot < n.count; slot++) {
+        bounds = merge(bounds, slot_bounds(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, slot));
+    }
+    return bounds;
+}
+
+// Rewrites each ancestor's copy of the child bounds, stopping once nothing changes
+void DynamicBvh::refit_upward(uint32_t node) {
+    while (nodes[node].parent != NULL_NODE) {
+        uint32_t parent = nodes[node].parent;
+        uint32_t slot = nodes[node].parentSlot;
+        Aabb bounds = node_bounds(node);
+        const Node& p = nodes[parent];
+        if (equal(bounds, slot_bounds(p.minX, p.minY, p.minZ, p.maxX, p.maxY, p.maxZ, slot))) {
+            return;
+        }
+        set_child(parent, slot, node, bounds);
+        node = parent;
+    }
+}
+
+// After a removal: frees emptied nodes and splices out nodes left with one child
+void DynamicBvh::collapse_upward(uint32_t node) {
+    while (true) {
+        Node& n = nodes[node];
+        uint32_t parent = n.parent;
+        if (n.count == 0) {
+            free_node(node);
+            if (node == root) {
+                root = NULL_NODE;
+                return;
+            }
+            remove_child(parent, n.parentSlot);
+            node = parent;
+            continue;
+        }
+        if (n.count == 1 && node == root) {
+            if (!(n.child[0] & PROXY_BIT)) {
+                root = n.child[0];
+                nodes[root].parent = NULL_NODE;
+                free_node(node);
+            }
+            return;
+        }
+        if (n.count == 1) {
+            uint32_t child = n.child[0];
+            Aabb bounds = slot_bounds(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, 0);
+            uint32_t slot = n.parentSlot;
+            free_node(node);
+            set_child(parent, slot, child, bounds);
+            refit_upward(parent);
+            return;
+        }
+        refit_upward(node);
+        return;
+    }
+}
+
+uint32_t DynamicBvh::insert(const Aabb& bounds, uint32_t userData) {
+    uint32_t proxy;
+    if (freeProxy != NULL_PROXY) {
+        proxy = freeProxy;
+        freeProxy = proxies[proxy].nextFree;
+    } else {
+        proxy = static_cast<uint32_t>(proxies.size());
+        proxies.emplace_back();
+    }
+    Aabb fat = bounds;
+    for (int axis = 0; axis < 3; axis++) {
+        fat.min[axis] -= margin;
+        fat.max[axis] += margin;
+    }
+    proxies[proxy].fat = fat;
+    proxies[proxy].userData = userData;
+    proxies[proxy].nextFree = NULL_PROXY;
+    proxyCount++;
+    structureVersion++;
+
+    uint32_t leaf = proxy | PROXY_BIT;
+    if (root == NULL_NODE) {
+        root = allocate_node(NULL_NODE, 0);
+        set_child(root, 0, leaf, fat);
+        nodes[root].count = 1;
+        return proxy;
+    }
+
+    // Descend toward the child whose bounds grow least, widening them on the way, until a
+    // free slot is cheaper than going deeper or the best child is a proxy to pair with
+    float fatArea = surface_area(fat);
+    uint32_t node = root;
+    while (true) {
+        const Node& n = nodes[node];
+        uint32_t best = 0;
+        float bestCost = FLT_MAX;
+        for (uint32_t slot = 0; slot < n.count; slot++) {
+            Aabb child = slot_bounds(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, slot);
+            float cost = surface_area(merge(child, fat)) - surface_area(child);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = slot;
+            }
+        }
+        bool bestIsProxy = (n.child[best] & PROXY_BIT) != 0;
+        Aabb bestBounds = slot_bounds(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, best);
+
+        if (n.count < 4 && (bestIsProxy || fatArea <= bestCost)) {
+            uint32_t slot = n.count;
+            nodes[node].count++;
+            set_child(node, slot, leaf, fat);
+            refit_upward(node);
+            return proxy;
+        }
+        if (!bestIsProxy) {
+            uint32_t child = n.child[best];
+            set_child(node, best, child, merge(bestBounds, fat));
+            node = child;
+            continue;
+        }
+
+        uint32_t sibling = n.child[best];
+        uint32_t pair = allocate_node(node, best);
+        nodes[pair].count = 2;
+        set_child(pair, 0, sibling, bestBounds);
+        set_child(pair, 1, leaf, fat);
+        set_child(node, best, pair, merge(bestBounds, fat));
+        refit_upward(node);
+        return proxy;
+    }
+}
+
+void DynamicBvh::remove(uint32_t proxy) {
+    Proxy& p = proxies[proxy];
+    uint32_t node = p.node;
+    remove_child(node, p.slot);
+    p.node = NULL_NODE;
+    p.nextFree = freeProxy;
+    freeProxy = proxy;
+    proxyCount--;
+    structureVersion++;
+    collapse_upward(node);
+}
+
+bool DynamicBvh::move(uint32_t proxy, const Aabb& bounds) {
+    Proxy& p = proxies[proxy];
+    if (contains(p.fat, bounds)) {
+        return false;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        p.fat.min[axis] = bounds.min[axis] - margin;
+        p.fat.max[axis] = bounds.max[axis] + margin;
+    }
+    set_child(p.node, p.slot, proxy | PROXY_BIT, p.fat);
+    refit_upward(p.node);
+    return true;
+}
+
+template <typename Test>
+void DynamicBvh::traverse(Test&& test, std::vector<uint32_t>& out) const {
+    if (root == NULL_NODE) {
+        return;
+    }
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty()) {
+        const Node& n = nodes[stack.back()];
+        stack.pop_back();
+        uint32_t mask = test(n) & lane_mask(n.count);
+        for (; mask; mask &= mask - 1) {
+            uint32_t child = n.child[__builtin_ctz(mask)];
+            if (child & PROXY_BIT) {
+                out.push_back(proxies[child & ~PROXY_BIT].userData);
+            } else {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// Distance along the ray to where it enters each child's bounds, and whether it does so
+// before `maxDistance`
+static uint32_t ray_lanes(const float* minX, const float* minY, const float* minZ, const float* maxX,
+                          const float* maxY, const float* maxZ, const float origin[3], const float inverse[3],
+                          float maxDistance, float* entry) {
+    const float* mins[3] = {minX, minY, minZ};
+    const float* maxs[3] = {maxX, maxY, maxZ};
+    __m128 near = _mm_setzero_ps();
+    __m128 far = _mm_set1_ps(maxDistance);
+    for (int axis = 0; axis < 3; axis++) {
+        __m128 o = _mm_set1_ps(origin[axis]);
+        __m128 inv = _mm_set1_ps(inverse[axis]);
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(mins[axis]), o), inv);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxs[axis]), o), inv);
+        near = _mm_max_ps(near, _mm_min_ps(t0, t1));
+        far = _mm_min_ps(far, _mm_max_ps(t0, t1));
+    }
+    _mm_storeu_ps(entry, near);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near, far)));
+}
+#else
+static uint32_t ray_lanes(const float* minX, const float* minY, const float* minZ, const float* maxX,
+                          const float* maxY, const float* maxZ, const float origin[3], const float inverse[3],
+                          float maxDistance, float* entry) {
+    const float* mins[3] = {minX, minY, minZ};
+    const float* maxs[3] = {maxX, maxY, maxZ};
+    uint32_t mask = 0;
+    for (int lane = 0; lane < 4; lane++) {
+        float near = 0.0f, far = maxDistance;
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (mins[axis][lane] - origin[axis]) * inverse[axis];
+            float t1 = (maxs[axis][lane] - origin[axis]) * inverse[axis];
+            near = std::max(near, std::min(t0, t1));
+            far = std::min(far, std::max(t0, t1));
+        }
+        entry[lane] = near;
+        mask |= near <= far ? 1u << lane : 0u;
+    }
+    return mask;
+}
+#endif
+
+void DynamicBvh::query_aabb(const Aabb& bounds, std::vector<uint32_t>& out) const {
+#if defined(__SSE2__)
+    __m128 qMinX = _mm_set1_ps(bounds.min[0]), qMinY = _mm_set1_ps(bounds.min[1]), qMinZ = _mm_set1_ps(bounds.min[2]);
+    __m128 qMaxX = _mm_set1_ps(bounds.max[0]), qMaxY = _mm_set1_ps(bounds.max[1]), qMaxZ = _mm_set1_ps(bounds.max[2]);
+    traverse([&](const Node& n) {
+        __m128 x = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.minX), qMaxX), _mm_cmpge_ps(_mm_load_ps(n.maxX), qMinX));
+        __m128 y = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.minY), qMaxY), _mm_cmpge_ps(_mm_load_ps(n.maxY), qMinY));
+        __m128 z = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.minZ), qMaxZ), _mm_cmpge_ps(_mm_load_ps(n.maxZ), qMinZ));
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(x, _mm_and_ps(y, z))));
+    }, out);
+#else
+    traverse([&](const Node& n) {
+        uint32_t mask = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            bool overlap = n.minX[lane] <= bounds.max[0] && n.maxX[lane] >= bounds.min[0] &&
+                           n.minY[lane] <= bounds.max[1] && n.maxY[lane] >= bounds.min[1] &&
+                           n.minZ[lane] <= bounds.max[2] && n.maxZ[lane] >= bounds.min[2];
+            mask |= overlap ? 1u << lane : 0u;
+        }
+        return mask;
+    }, out);
+#endif
+}
+
+void DynamicBvh::query_sphere(const float center[3], float radius, std::vector<uint32_t>& out) const {
+#if defined(__SSE2__)
+    __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+    __m128 radiusSquared = _mm_set1_ps(radius * radius);
+    __m128 zero = _mm_setzero_ps();
+    traverse([&](const Node& n) {
+        // Per axis, how far the centre lies outside the box (0 when inside its slab)
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minX), cx), _mm_sub_ps(cx, _mm_load_ps(n.maxX))), zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minY), cy), _mm_sub_ps(cy, _mm_load_ps(n.maxY))), zero);
+        __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(n.minZ), cz), _mm_sub_ps(cz, _mm_load_ps(n.maxZ))), zero);
+        __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_add_ps(_mm_mul_ps(dy, dy), _mm_mul_ps(dz, dz)));
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distance, radiusSquared)));
+    }, out);
+#else
+    traverse([&](const Node& n) {
+        const float* mins[3] = {n.minX, n.minY, n.minZ};
+        const float* maxs[3] = {n.maxX, n.maxY, n.maxZ};
+        uint32_t mask = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            float distance = 0.0f;
+            for (int axis = 0; axis < 3; axis++) {
+                float d = std::max(std::max(mins[axis][lane] - center[axis], center[axis] - maxs[axis][lane]), 0.0f);
+                distance += d * d;
+            }
+            mask |= distance <= radius * radius ? 1u << lane : 0u;
+        }
+        return mask;
+    }, out);
+#endif
+}
+
+void DynamicBvh::query_ray(const Ray& ray, std::vector<uint32_t>& out) const {
+    float inverse[3] = {1.0f / ray.direction[0], 1.0f / ray.direction[1], 1.0f / ray.direction[2]};
+    float entry[4];
+    traverse([&](const Node& n) {
+        return ray_lanes(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, ray.origin, inverse, ray.maxDistance, entry);
+    }, out);
+}
+
+void DynamicBvh::raycast(const Ray* rays, size_t count, RayHit* hits) const {
+    std::vector<uint32_t> stack;
+    for (size_t i = 0; i < count; i++) {
+        const Ray& ray = rays[i];
+        float inverse[3] = {1.0f / ray.direction[0], 1.0f / ray.direction[1], 1.0f / ray.direction[2]};
+        RayHit hit;
+        float nearest = ray.maxDistance;
+        if (root != NULL_NODE) {
+            stack.assign(1, root);
+        }
+        while (!stack.empty()) {
+            const Node& n = nodes[stack.back()];
+            stack.pop_back();
+            float entry[4];
+            uint32_t mask = ray_lanes(n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, ray.origin, inverse, nearest, entry) &
+                            lane_mask(n.count);
+            for (; mask; mask &= mask - 1) {
+                uint32_t lane = __builtin_ctz(mask);
+                uint32_t child = n.child[lane];
+                if (!(child & PROXY_BIT)) {
+                    stack.push_back(child);
+                } else if (entry[lane] <= nearest) {
+                    nearest = entry[lane];
+                    hit.userData = proxies[child & ~PROXY_BIT].userData;
+                    hit.distance = entry[lane];
+                }
+            }
+        }
+        hits[i] = hit;
+    }
+}
+
+// Subtrees entirely inside every plane are marked on the stack and emitted without
+// further tests
+void DynamicBvh::query_frustum(const Frustum& frustum, std::vector<uint32_t>& out) const {
+    if (root == NULL_NODE) {
+        return;
+    }
+    constexpr uint32_t INSIDE_BIT = PROXY_BIT; // Never set in a node index
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty()) {
+        uint32_t entry = stack.back();
+        stack.pop_back();
+        const Node& n = nodes[entry & ~INSIDE_BIT];
+        if (entry & INSIDE_BIT) {
+            for (uint32_t slot = 0; slot < n.count; slot++) {
+                if (n.child[slot] & PROXY_BIT) {
+                    out.push_back(proxies[n.child[slot] & ~PROXY_BIT].userData);
+                } else {
+                    stack.push_back(n.child[slot] | INSIDE_BIT);
+                }
+            }
+            continue;
+        }
+
+        uint32_t outside = 0;
+        uint32_t straddling = 0;
+        for (const float* plane : frustum.planes) {
+#if defined(__SSE2__)
+            // The box corner furthest along the normal decides "outside", the nearest one "straddling"
+            __m128 farX = _mm_load_ps(plane[0] >= 0.0f ? n.maxX : n.minX);
+            __m128 farY = _mm_load_ps(plane[1] >= 0.0f ? n.maxY : n.minY);
+            __m128 farZ = _mm_load_ps(plane[2] >= 0.0f ? n.maxZ : n.minZ);
+            __m128 nearX = _mm_load_ps(plane[0] >= 0.0f ? n.minX : n.maxX);
+            __m128 nearY = _mm_load_ps(plane[1] >= 0.0f ? n.minY : n.maxY);
+            __m128 nearZ = _mm_load_ps(plane[2] >= 0.0f ? n.minZ : n.maxZ);
+            __m128 a = _mm_set1_ps(plane[0]), b = _mm_set1_ps(plane[1]), c = _mm_set1_ps(plane[2]);
+            __m128 d = _mm_set1_ps(plane[3]);
+            __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, farX), _mm_mul_ps(b, farY)), _mm_add_ps(_mm_mul_ps(c, farZ), d));
+            __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, nearX), _mm_mul_ps(b, nearY)), _mm_add_ps(_mm_mul_ps(c, nearZ), d));
+            outside |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(farDistance, _mm_setzero_ps())));
+            straddling |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(nearDistance, _mm_setzero_ps())));
+#else
+            for (int lane = 0; lane < 4; lane++) {
+                float farDistance = plane[0] * (plane[0] >= 0.0f ? n.maxX : n.minX)[lane] +
+                                    plane[1] * (plane[1] >= 0.0f ? n.maxY : n.minY)[lane] +
+                                    plane[2] * (plane[2] >= 0.0f ? n.maxZ : n.minZ)[lane] + plane[3];
+                float nearDistance = plane[0] * (plane[0] >= 0.0f ? n.minX : n.maxX)[lane] +
+                                     plane[1] * (plane[1] >= 0.0f ? n.minY : n.maxY)[lane] +
+                                     plane[2] * (plane[2] >= 0.0f ? n.minZ : n.maxZ)[lane] + plane[3];
+                outside |= farDistance < 0.0f ? 1u << lane : 0u;
+                straddling |= nearDistance < 0.0f ? 1u << lane : 0u;
+            }
+#endif
+        }
+
+        for (uint32_t mask = ~outside & lane_mask(n.count); mask; mask &= mask - 1) {
+            uint32_t lane = __builtin_ctz(mask);
+            uint32_t child = n.child[lane];
+            if (child & PROXY_BIT) {
+                out.push_back(proxies[child & ~PROXY_BIT].userData);
+            } else {
+                stack.push_back(straddling & (1u << lane) ? child : child | INSIDE_BIT);
+            }
+        }
+    }
+}
+
+// Binned SAH over centroids along the widest axis; returns the size of the left part
+uint32_t DynamicBvh::split_sah(BuildItem* items, uint32_t count) {
+    float low[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float high[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (uint32_t i = 0; i < count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            low[axis] = std::min(low[axis], items[i].centroid[axis]);
+            high[axis] = std::max(high[axis], items[i].centroid[axis]);
+        }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; a++) {
+        if (high[a] - low[a] > high[axis] - low[axis]) {
+            axis = a;
+        }
+    }
+
+    auto median = [&]() {
+        std::nth_element(items, items + count / 2, items + count, [axis](const BuildItem& a, const BuildItem& b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+        return count / 2;
+    };
+    float extent = high[axis] - low[axis];
+    if (extent <= 0.0f) {
+        return median();
+    }
+
+    float scale = static_cast<float>(SAH_BINS) / extent;
+    auto bin_of = [&](const BuildItem& item) {
+        return std::min(SAH_BINS - 1, static_cast<uint32_t>((item.centroid[axis] - low[axis]) * scale));
+    };
+    uint32_t binCount[SAH_BINS] = {};
+    Aabb binBounds[SAH_BINS];
+    std::fill(binBounds, binBounds + SAH_BINS, empty_bounds());
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bin = bin_of(items[i]);
+        binCount[bin]++;
+        binBounds[bin] = merge(binBounds[bin], items[i].bounds);
+    }
+
+    // Cost of splitting after bin i: left and right areas weighted by their item counts
+    float rightCost[SAH_BINS];
+    Aabb right = empty_bounds();
+    uint32_t rightCount = 0;
+    for (uint32_t i = SAH_BINS - 1; i > 0; i--) {
+        right = merge(right, binBounds[i]);
+        rightCount += binCount[i];
+        rightCost[i - 1] = rightCount ? surface_area(right) * static_cast<float>(rightCount) : 0.0f;
+    }
+    Aabb left = empty_bounds();
+    uint32_t leftCount = 0;
+    uint32_t bestBin = 0;
+    float bestCost = FLT_MAX;
+    for (uint32_t i = 0; i + 1 < SAH_BINS; i++) {
+        left = merge(left, binBounds[i]);
+        leftCount += binCount[i];
+        float cost = (leftCount ? surface_area(left) * static_cast<float>(leftCount) : 0.0f) + rightCost[i];
+        if (leftCount > 0 && leftCount < count && cost < bestCost) {
+            bestCost = cost;
+            bestBin = i;
+        }
+    }
+    if (bestCost == FLT_MAX) {
+        return median();
+    }
+    BuildItem* middle = std::partition(items, items + count, [&](const BuildItem& item) { return bin_of(item) <= bestBin; });
+    return static_cast<uint32_t>(middle - items);
+}
+
+// Two levels of binary SAH splits give each node up to four children. Nodes are appended
+// before their children, so iterating in reverse visits children first.
+uint32_t DynamicBvh::build_node(std::vector<Node>& built, BuildItem* items, uint32_t count, uint32_t parent,
+                                uint32_t parentSlot) {
+    uint32_t index = static_cast<uint32_t>(built.size());
+    built.emplace_back();
+    memset(&built[index], 0, sizeof(Node));
+    for (uint32_t& child : built[index].child) {
+        child = NULL_NODE;
+    }
+    built[index].parent = parent;
+    built[index].parentSlot = parentSlot;
+
+    uint32_t begins[4];
+    uint32_t counts[4];
+    uint32_t ranges = 0;
+    if (count <= 4) {
+        for (uint32_t i = 0; i < count; i++) {
+            begins[ranges] = i;
+            counts[ranges++] = 1;
+        }
+    } else {
+        uint32_t middle = split_sah(items, count);
+        uint32_t halves[2][2] = {{0, middle}, {middle, count - middle}};
+        for (auto& half : halves) {
+            if (half[1] == 1) {
+                begins[ranges] = half[0];
+                counts[ranges++] = 1;
+                continue;
+            }
+            uint32_t quarter = split_sah(items + half[0], half[1]);
+            begins[ranges] = half[0];
+            counts[ranges++] = quarter;
+            begins[ranges] = half[0] + quarter;
+            counts[ranges++] = half[1] - quarter;
+        }
+    }
+
+    for (uint32_t slot = 0; slot < ranges; slot++) {
+        BuildItem* range = items + begins[slot];
+        Aabb bounds = empty_bounds();
+        for (uint32_t i = 0; i < counts[slot]; i++) {
+            bounds = merge(bounds, range[i].bounds);
+        }
+        uint32_t child = counts[slot] == 1 ? (range[0].proxy | PROXY_BIT)
+                                           : build_node(built, range, counts[slot], index, slot);
+        Node& node = built[index]; // The recursion may have reallocated `built`
+        node.child[slot] = child;
+        node.minX[slot] = bounds.min[0];
+        node.minY[slot] = bounds.min[1];
+        node.minZ[slot] = bounds.min[2];
+        node.maxX[slot] = bounds.max[0];
+        node.maxY[slot] = bounds.max[1];
+        node.maxZ[slot] = bounds.max[2];
+    }
+    built[index].count = ranges;
+    return index;
+}
+
+// Adopts a built tree, taking proxy bounds from their current values rather than the
+// snapshot the build saw
+void DynamicBvh::install(std::vector<Node>& built) {
+    nodes.swap(built);
+    freeNodes.clear();
+    root = nodes.empty() ? NULL_NODE : 0;
+    for (uint32_t index = 0; index < nodes.size(); index++) {
+        for (uint32_t slot = 0; slot < nodes[index].count; slot++) {
+            uint32_t child = nodes[index].child[slot];
+            if (child & PROXY_BIT) {
+                set_child(index, slot, child, proxies[child & ~PROXY_BIT].fat);
+            }
+        }
+    }
+    for (uint32_t index = static_cast<uint32_t>(nodes.size()); index-- > 1;) {
+        set_child(nodes[index].parent, nodes[index].parentSlot, index, node_bounds(index));
+    }
+}
+
+std::vector<DynamicBvh::BuildItem> DynamicBvh::gather_build_items() const {
+    std::vector<BuildItem> items;
+    items.reserve(proxyCount);
+    for (uint32_t proxy = 0; proxy < proxies.size(); proxy++) {
+        const Proxy& p = proxies[proxy];
+        if (p.node != NULL_NODE) {
+            BuildItem item{p.fat, {}, proxy};
+            for (int axis = 0; axis < 3; axis++) {
+                item.centroid[axis] = 0.5f * (p.fat.min[axis] + p.fat.max[axis]);
+            }
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+void DynamicBvh::build(std::vector<BuildItem>& items, std::vector<Node>& built) {
+    built.reserve(items.size() / 2 + 1);
+    if (!items.empty()) {
+        build_node(built, items.data(), static_cast<uint32_t>(items.size()), NULL_NODE, 0);
+    }
+}
+
+void DynamicBvh::rebuild() {
+    std::vector<BuildItem> items = gather_build_items();
+    std::vector<Node> built;
+    build(items, built);
+    install(built);
+}
+
+void DynamicBvh::begin_rebuild(JobSystem& jobs) {
+    if (pending) {
+        return;
+    }
+    pending = std::make_unique<PendingRebuild>();
+    pending->jobs = &jobs;
+    pending->structureVersion = structureVersion;
+    pending->items = gather_build_items();
+    PendingRebuild* rebuild = pending.get();
+    jobs.run([rebuild]() { build(rebuild->items, rebuild->nodes); }, &pending->counter);
+}
+
+bool DynamicBvh::is_rebuild_ready() const {
+    return pending && pending->counter.done();
+}
+
+bool DynamicBvh::finish_rebuild() {
+    if (!pending) {
+        return false;
+    }
+    pending->jobs->wait(pending->counter);
+    std::unique_ptr<PendingRebuild> rebuild = std::move(pending);
+    if (rebuild->structureVersion != structureVersion) {
+        return false;
+    }
+    install(rebuild->nodes);
+    return true;
+}
+
+float DynamicBvh::get_sah_cost() const {
+    if (root == NULL_NODE) {
+        return 0.0f;
+    }
+    float rootArea = surface_area(node_bounds(root));
+    if (rootArea <= 0.0f) {
+        return 0.0f;
+    }
+    float total = 0.0f;
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty()) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        total += surface_area(node_bounds(node));
+        for (uint32_t slot = 0; slot < nodes[node].count; slot++) {
+            if (!(nodes[node].child[slot] & PROXY_BIT)) {
+                stack.push_back(nodes[node].child[slot]);
+            }
+        }
+    }
+    return total / rootArea;
+}
@@ -0,0 +1,363 @@
+#include "scene/ecs.hpp"
+#include <algorithm>
+
+namespace {
+constexpr uint32_t COLUMN_ALIGNMENT = 64; // Cache-line aligned columns, ready for SIMD loads
+
+struct ComponentTable {
+    std::mutex mutex;
+    std::array<ComponentInfo, MAX_COMPONENT_TYPES> infos{};
+    uint32_t count = 0;
+};
+
+ComponentTable& component_table() {
+    static ComponentTable table;
+    return table;
+}
+
+uint32_t align_up(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+ComponentId ComponentRegistry::register_component(uint32_t size, uint32_t alignment) {
+    ComponentTable& table = component_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (table.count == MAX_COMPONENT_TYPES) {
+        throw std::runtime_error("Too many ECS component types!");
+    }
+    table.infos[table.count] = {size, alignment};
+    return table.count++;
+}
+
+const ComponentInfo& ComponentRegistry::info(ComponentId id) {
+    return component_table().infos[id];
+}
+
+Archetype::Archetype(ComponentMask mask) : mask(mask) {
+    columns.fill(-1);
+    for (ComponentId id = 0; id < MAX_COMPONENT_TYPES; id++) {
+        if (mask & (ComponentMask(1) << id)) {
+            columns[id] = static_cast<int8_t>(components.size());
+            components.push_back(id);
+            sizes.push_back(ComponentRegistry::info(id).size);
+        }
+    }
+
+    // Largest capacity whose aligned columns still fit in one chunk
+    uint32_t bytesPerEntity = sizeof(Entity);
+    for (uint32_t size : sizes) {
+        bytesPerEntity += size;
+    }
+    uint32_t padding = COLUMN_ALIGNMENT * static_cast<uint32_t>(components.size() + 1);
+    capacity = std::max<uint32_t>(1, static_cast<uint32_t>((ECS_CHUNK_BYTES - padding) / bytesPerEntity));
+
+    offsets.resize(components.size());
+    while (true) {
+        uint32_t offset = align_up(sizeof(Entity) * capacity, COLUMN_ALIGNMENT);
+        for (size_t i = 0; i < components.size(); i++) {
+            offsets[i] = offset;
+            offset = align_up(offset + sizes[i] * capacity, COLUMN_ALIGNMENT);
+        }
+        if (offset <= ECS_CHUNK_BYTES) {
+            break;
+        }
+        if (capacity == 1) {
+            throw std::runtime_error("ECS archetype does not fit in a chunk!");
+        }
+        capacity--;
+    }
+}
+
+size_t EntityQuery::count() const {
+    size_t total = 0;
+    for (const Archetype* archetype : archetypes) {
+        total += archetype->get_entity_count();
+    }
+    return total;
+}
+
+EntityCommandBuffer::PendingEntity EntityCommandBuffer::create() {
+    std::lock_guard<std::mutex> lock(mutex);
+    PendingEntity pending{pendingCount++};
+    Header header{Op::Create, pending.index, 0, 0, 0};
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&header);
+    bytes.insert(bytes.end(), raw, raw + sizeof(header));
+    return pending;
+}
+
+void EntityCommandBuffer::destroy(Entity entity) {
+    record(Op::Destroy, entity.index, entity.generation, 0, nullptr, 0);
+}
+
+void EntityCommandBuffer::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    bytes.clear();
+    pendingCount = 0;
+}
+
+void EntityCommandBuffer::record(Op op, uint32_t index, uint32_t generation, ComponentId component,
+                                 const void* payload, uint32_t size) {
+    Header header{op, index, generation, component, size};
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&header);
+    bytes.insert(bytes.end(), raw, raw + sizeof(header));
+    if (size > 0) {
+        const uint8_t* data = static_cast<const uint8_t*>(payload);
+        bytes.insert(bytes.end(), data, data + size);
+    }
+}
+
+World::~World() = default;
+
+void World::destroy(Entity entity) {
+    check_structural_change();
+    if (!is_alive(entity)) {
+        return;
+    }
+    EntityRecord& record = records[entity.index];
+    remove_row(record.archetype, record.chunk, record.row);
+    record.archetype = nullptr;
+    record.generation++;
+    freeIndices.push_back(entity.index);
+}
+
+bool World::is_alive(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+           records[entity.index].archetype != nullptr;
+}
+
+Entity World::allocate_entity() {
+    check_structural_change();
+    if (!freeIndices.empty()) {
+        uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+        return {index, records[index].generation};
+    }
+    records.emplace_back();
+    return {static_cast<uint32_t>(records.size() - 1), 0};
+}
+
+Archetype* World::get_archetype(ComponentMask mask) {
+    auto found = archetypes.find(mask);
+    if (found != archetypes.end()) {
+        return found->second.get();
+    }
+
+    Archetype* archetype = new Archetype(mask);
+    archetypes.emplace(mask, std::unique_ptr<Archetype>(archetype));
+    for (auto& entry : queries) {
+        if (entry.second->matches(mask)) {
+            entry.second->archetypes.push_back(archetype);
+        }
+    }
+    for (auto& query : excludingQueries) {
+        if (query->matches(mask)) {
+            query->archetypes.push_back(archetype);
+        }
+    }
+    return archetype;
+}
+
+Archetype* World::archetype_with(Archetype* from, ComponentId component) {
+    if (!from->addEdges[component]) {
+        from->addEdges[component] = get_archetype(from->mask | (ComponentMask(1) << component));
+    }
+    return from->addEdges[component];
+}
+
+Archetype* World::archetype_without(Archetype* from, ComponentId component) {
+    if (!from->removeEdges[component]) {
+        from->removeEdges[component] = get_archetype(from->mask & ~(ComponentMask(1) << component));
+    }
+    return from->removeEdges[component];
+}
+
+std::unique_ptr<ArchetypeChunk> World::take_chunk() {
+    if (freeChunks.empty()) {
+        return std::make_unique<ArchetypeChunk>();
+    }
+    std::unique_ptr<ArchetypeChunk> chunk = std::move(freeChunks.back());
+    freeChunks.pop_back();
+    chunk->count = 0;
+    return chunk;
+}
+
+// Appends the entity to the end of the archetype; component values are left for the caller
+void World::place(Entity entity, Archetype* archetype) {
+    uint32_t chunkIndex = archetype->entityCount / archetype->capacity;
+    if (chunkIndex == archetype->chunks.size()) {
+        archetype->chunks.push_back(take_chunk());
+    }
+    ArchetypeChunk* chunk = archetype->chunks[chunkIndex].get();
+    uint32_t row = chunk->count++;
+    archetype->entities(chunk)[row] = entity;
+    archetype->entityCount++;
+
+    EntityRecord& record = records[entity.index];
+    record.archetype = archetype;
+    record.chunk = chunkIndex;
+    record.row = row;
+}
+
+// Fills the hole with the archetype's last entity, keeping every chunk but the last full
+void World::remove_row(Archetype* archetype, uint32_t chunkIndex, uint32_t row) {
+    uint32_t lastChunkIndex = (archetype->entityCount - 1) / archetype->capacity;
+    ArchetypeChunk* chunk = archetype->chunks[chunkIndex].get();
+    ArchetypeChunk* lastChunk = archetype->chunks[lastChunkIndex].get();
+    uint32_t lastRow = lastChunk->count - 1;
+
+    if (chunk != lastChunk || row != lastRow) {
+        Entity moved = archetype->entities(lastChunk)[lastRow];
+        archetype->entities(chunk)[row] = moved;
+        for (size_t column = 0; column < archetype->components.size(); column++) {
+            uint32_t size = archetype->sizes[column];
+            memcpy(archetype->column_data(chunk, static_cast<int>(column)) + row * size,
+                   archetype->column_data(lastChunk, static_cast<int>(column)) + lastRow * size, size);
+        }
+        records[moved.index].chunk = chunkIndex;
+        records[moved.index].row = row;
+    }
+
+    lastChunk->count--;
+    archetype->entityCount--;
+    if (lastChunk->count == 0) {
+        freeChunks.push_back(std::move(archetype->chunks[lastChunkIndex]));
+        archetype->chunks.pop_back();
+    }
+}
+
+// Copies the components both archetypes share; new ones are written by the caller
+void World::move_entity(Entity entity, Archetype* to) {
+    EntityRecord record = records[entity.index];
+    Archetype* from = record.archetype;
+    ArchetypeChunk* fromChunk = from->chunks[record.chunk].get();
+
+    place(entity, to);
+    const EntityRecord& placed = records[entity.index];
+    ArchetypeChunk* toChunk = to->chunks[placed.chunk].get();
+    for (size_t column = 0; column < from->components.size(); column++) {
+        int toColumn = to->column_of(from->components[column]);
+        if (toColumn >= 0) {
+            uint32_t size = from->sizes[column];
+            memcpy(to->column_data(toChunk, toColumn) + placed.row * size,
+                   from->column_data(fromChunk, static_cast<int>(column)) + record.row * size, size);
+        }
+    }
+
+    // remove_row may move another entity of `from`, never this one: it now lives in `to`
+    remove_row(from, record.chunk, record.row);
+}
+
+void World::write_component(Entity entity, ComponentId component, const void* value) {
+    memcpy(component_pointer(entity, component), value, ComponentRegistry::info(component).size);
+}
+
+void World::add_component(Entity entity, ComponentId component, const void* value) {
+    check_structural_change();
+    if (!is_alive(entity)) {
+        return;
+    }
+    Archetype* from = records[entity.index].archetype;
+    if (from->column_of(component) < 0) {
+        move_entity(entity, archetype_with(from, component));
+    }
+    write_component(entity, component, value);
+}
+
+void World::remove_component(Entity entity, ComponentId component) {
+    check_structural_change();
+    if (!is_alive(entity)) {
+        return;
+    }
+    Archetype* from = records[entity.index].archetype;
+    if (from->column_of(component) >= 0) {
+        move_entity(entity, archetype_without(from, component));
+    }
+}
+
+void* World::component_pointer(Entity entity, ComponentId component) {
+    if (!is_alive(entity)) {
+        return nullptr;
+    }
+    const EntityRecord& record = records[entity.index];
+    int column = record.archetype->column_of(component);
+    if (column < 0) {
+        return nullptr;
+    }
+    ArchetypeChunk* chunk = record.archetype->chunks[record.chunk].get();
+    return record.archetype->column_data(chunk, column) + record.row * record.archetype->sizes[column];
+}
+
+void World::check_structural_change() const {
+    if (iterating.load(std::memory_order_relaxed) > 0) {
+        throw std::runtime_error("ECS structural change during iteration; use an EntityCommandBuffer!");
+    }
+}
+
+EntityQuery& World::get_query(ComponentMask required, ComponentMask excluded) {
+    if (excluded == 0) {
+        auto found = queries.find(required);
+        if (found != queries.end()) {
+            return *found->second;
+        }
+    } else {
+        for (auto& query : excludingQueries) {
+            if (query->required == required && query->excluded == excluded) {
+                return *query;
+            }
+        }
+    }
+
+    auto query = std::make_unique<EntityQuery>(required, excluded);
+    query->world = this;
+    for (auto& entry : archetypes) {
+        if (query->matches(entry.first)) {
+            query->archetypes.push_back(entry.second.get());
+        }
+    }
+    EntityQuery& result = *query;
+    if (excluded == 0) {
+        queries.emplace(required, std::move(query));
+    } else {
+        excludingQueries.push_back(std::move(query));
+    }
+    return result;
+}
+
+void World::apply(EntityCommandBuffer& commands) {
+    std::lock_guard<std::mutex> lock(commands.mutex);
+    std::vector<Entity> created(commands.pendingCount);
+    Archetype* empty = get_archetype(0);
+
+    size_t offset = 0;
+    while (offset < commands.bytes.size()) {
+        EntityCommandBuffer::Header header;
+        memcpy(&header, commands.bytes.data() + offset, sizeof(header));
+        const uint8_t* payload = commands.bytes.data() + offset + sizeof(header);
+        offset += sizeof(header) + header.size;
+
+        Entity entity{header.index, header.generation};
+        switch (header.op) {
+        case EntityCommandBuffer::Op::Create:
+            created[header.index] = allocate_entity();
+            place(created[header.index], empty);
+            break;
+        case EntityCommandBuffer::Op::Destroy:
+            destroy(entity);
+            break;
+        case EntityCommandBuffer::Op::AddPending:
+            add_component(created[header.index], header.component, payload);
+            break;
+        case EntityCommandBuffer::Op::Add:
+            add_component(entity, header.component, payload);
+            break;
+        case EntityCommandBuffer::Op::Remove:
+            remove_component(entity, header.component);
+            break;
+        }
+    }
+
+    commands.bytes.clear();
+    commands.pendingCount = 0;
+}
@@ -0,0 +1,357 @@
+#include "scene/transform_hierarchy.hpp"
+#include "core/job_system.hpp"
+#include "platform/gpu_instance.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+// Levels smaller than this are cheaper to run inline than to split into jobs
+constexpr uint32_t PARALLEL_MIN_NODES = 4096;
+constexpr uint32_t GROUPS_PER_JOB = 256;
+
+alignas(16) const float IDENTITY[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+};
+}
+
+TransformHierarchy::TransformHierarchy(size_t reserveNodes) : levelStart{0} {
+    for (auto* array : {&tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz}) {
+        array->reserve(reserveNodes);
+    }
+    parentSlot.reserve(reserveNodes);
+    instance.reserve(reserveNodes);
+    depth.reserve(reserveNodes);
+    dirty.reserve(reserveNodes);
+    stale.reserve(reserveNodes);
+    world.reserve(reserveNodes);
+    nodeAt.reserve(reserveNodes);
+    slotOf.reserve(reserveNodes);
+}
+
+uint32_t TransformHierarchy::create(uint32_t parent, const Transform& local) {
+    if (parent != NO_NODE && parent >= slotOf.size()) {
+        throw std::runtime_error("Transform parent does not exist!");
+    }
+
+    uint32_t node = static_cast<uint32_t>(slotOf.size());
+    uint32_t slot = static_cast<uint32_t>(nodeAt.size());
+    slotOf.push_back(slot);
+    nodeAt.push_back(node);
+
+    // Appended out of order for now; update() re-sorts by depth before computing
+    uint32_t parentIndex = parent == NO_NODE ? NO_NODE : slotOf[parent];
+    parentSlot.push_back(parentIndex);
+    depth.push_back(parentIndex == NO_NODE ? 0 : depth[parentIndex] + 1);
+    for (auto* array : {&tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz}) {
+        array->push_back(0.0f);
+    }
+    write_local(slot, local);
+    instance.push_back(NO_NODE);
+    dirty.push_back(1);
+    stale.push_back(0);
+    Matrix4 identity;
+    memcpy(identity.m, IDENTITY, sizeof(IDENTITY));
+    world.push_back(identity);
+
+    layoutDirty = true;
+    anyDirty = true;
+    return node;
+}
+
+void TransformHierarchy::write_local(uint32_t slot, const Transform& local) {
+    tx[slot] = local.translation[0];
+    ty[slot] = local.translation[1];
+    tz[slot] = local.translation[2];
+    qx[slot] = local.rotation[0];
+    qy[slot] = local.rotation[1];
+    qz[slot] = local.rotation[2];
+    qw[slot] = local.rotation[3];
+    sx[slot] = local.scale[0];
+    sy[slot] = local.scale[1];
+    sz[slot] = local.scale[2];
+}
+
+void TransformHierarchy::set_local(uint32_t node, const Transform& local) {
+    uint32_t slot = slotOf[node];
+    write_local(slot, local);
+    dirty[slot] = 1;
+    anyDirty = true;
+}
+
+Transform TransformHierarchy::get_local(uint32_t node) const {
+    uint32_t slot = slotOf[node];
+    Transform local;
+    local.translation[0] = tx[slot];
+    local.translation[1] = ty[slot];
+    local.translation[2] = tz[slot];
+    local.rotation[0] = qx[slot];
+    local.rotation[1] = qy[slot];
+    local.rotation[2] = qz[slot];
+    local.rotation[3] = qw[slot];
+    local.scale[0] = sx[slot];
+    local.scale[1] = sy[slot];
+    local.scale[2] = sz[slot];
+    return local;
+}
+
+uint32_t TransformHierarchy::get_parent(uint32_t node) const {
+    uint32_t parent = parentSlot[slotOf[node]];
+    return parent == NO_NODE ? NO_NODE : nodeAt[parent];
+}
+
+void TransformHierarchy::bind_instance(uint32_t node, uint32_t instanceIndex) {
+    uint32_t slot = slotOf[node];
+    instance[slot] = instanceIndex;
+    dirty[slot] = 1; // So the instance receives its matrix on the next update
+    anyDirty = true;
+}
+
+void TransformHierarchy::set_instance_buffer_count(uint32_t count) {
+    if (count == 0 || count > 8) {
+        throw std::runtime_error("Transform hierarchies support 1 to 8 instance buffers!");
+    }
+    instanceBufferCount = count;
+    invalidate_instances();
+}
+
+void TransformHierarchy::invalidate_instances() {
+    uint8_t all = static_cast<uint8_t>((1u << instanceBufferCount) - 1);
+    for (uint32_t slot = 0; slot < stale.size(); slot++) {
+        if (instance[slot] != NO_NODE) {
+            stale[slot] = all;
+        }
+    }
+    staleBuffers = all;
+}
+
+// Stable counting sort by depth; siblings keep their creation order
+void TransformHierarchy::rebuild_layout() {
+    uint32_t count = static_cast<uint32_t>(nodeAt.size());
+    uint32_t levels = 0;
+    for (uint32_t d : depth) {
+        levels = std::max(levels, d + 1);
+    }
+
+    levelStart.assign(levels + 1, 0);
+    for (uint32_t d : depth) {
+        levelStart[d + 1]++;
+    }
+    for (uint32_t i = 0; i < levels; i++) {
+        levelStart[i + 1] += levelStart[i];
+    }
+
+    std::vector<uint32_t> newSlot(count);
+    std::vector<uint32_t> cursor(levelStart.begin(), levelStart.end() - 1);
+    for (uint32_t slot = 0; slot < count; slot++) {
+        newSlot[slot] = cursor[depth[slot]]++;
+    }
+
+    auto permute = [&](auto& array) {
+        std::remove_reference_t<decltype(array)> sorted(array.size());
+        for (uint32_t slot = 0; slot < count; slot++) {
+            sorted[newSlot[slot]] = array[slot];
+        }
+        array.swap(sorted);
+    };
+    for (auto* array : {&tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz}) {
+        permute(*array);
+    }
+    permute(instance);
+    permute(depth);
+    permute(dirty);
+    permute(stale);
+    permute(world);
+    permute(nodeAt);
+    permute(parentSlot);
+    for (uint32_t& parent : parentSlot) {
+        if (parent != NO_NODE) {
+            parent = newSlot[parent];
+        }
+    }
+    for (uint32_t slot = 0; slot < count; slot++) {
+        slotOf[nodeAt[slot]] = slot;
+    }
+    layoutDirty = false;
+}
+
+void TransformHierarchy::update(JobSystem* jobs, GpuInstance* instances, uint32_t buffer) {
+    if (buffer >= instanceBufferCount) {
+        throw std::runtime_error("Instance buffer index out of range!");
+    }
+    lastUpdateCount = 0;
+    uint8_t bufferBit = static_cast<uint8_t>(1u << buffer);
+    if (!anyDirty) {
+        if (instances && (staleBuffers & bufferBit)) {
+            catch_up(instances, bufferBit);
+        }
+        return;
+    }
+    if (layoutDirty) {
+        rebuild_layout();
+    }
+    uint8_t all = static_cast<uint8_t>((1u << instanceBufferCount) - 1);
+    staleAfterWrite = instances ? all & ~bufferBit : all;
+
+    // Levels run in order so parents are final before their children read them
+    for (uint32_t level = 0; level < get_level_count(); level++) {
+        uint32_t begin = levelStart[level];
+        uint32_t end = levelStart[level + 1];
+        if (!jobs || end - begin < PARALLEL_MIN_NODES) {
+            update_range(begin, end, instances);
+            continue;
+        }
+        // Ranges are whole groups of four so no SIMD pass straddles two jobs
+        uint32_t groups = (end - begin + 3) / 4;
+        jobs->parallel_for(0, groups, [this, begin, end, instances](uint32_t first, uint32_t last) {
+            update_range(begin + first * 4, std::min(end, begin + last * 4), instances);
+        }, GROUPS_PER_JOB);
+    }
+
+    std::fill(dirty.begin(), dirty.end(), 0);
+    anyDirty = false;
+    staleBuffers |= staleAfterWrite;
+    if (instances && (staleBuffers & bufferBit)) {
+        catch_up(instances, bufferBit);
+    }
+}
+
+// After the dirty pass, so matrices it just wrote are not copied twice
+void TransformHierarchy::catch_up(GpuInstance* instances, uint8_t bufferBit) {
+    for (uint32_t slot = 0; slot < stale.size(); slot++) {
+        if (stale[slot] & bufferBit) {
+            if (instance[slot] != NO_NODE) {
+                memcpy(instances[instance[slot]].model, world[slot].m, sizeof(Matrix4));
+            }
+            stale[slot] &= static_cast<uint8_t>(~bufferBit);
+        }
+    }
+    staleBuffers &= static_cast<uint8_t>(~bufferBit);
+}
+
+void TransformHierarchy::update_range(uint32_t begin, uint32_t end, GpuInstance* instances) {
+    size_t computed = 0;
+    uint32_t slot = begin;
+    for (; slot + 4 <= end; slot += 4) {
+        uint8_t any = 0;
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            uint32_t parent = parentSlot[slot + lane];
+            uint8_t flag = dirty[slot + lane] | (parent == NO_NODE ? 0 : dirty[parent]);
+            dirty[slot + lane] = flag;
+            any |= flag;
+        }
+        // Clean lanes are recomputed with the rest; their result is unchanged
+        if (any) {
+            compute_four(slot, instances);
+            computed += 4;
+        }
+    }
+    for (; slot < end; slot++) {
+        uint32_t parent = parentSlot[slot];
+        dirty[slot] |= parent == NO_NODE ? 0 : dirty[parent];
+        if (dirty[slot]) {
+            compute_one(slot, instances);
+            computed++;
+        }
+    }
+    lastUpdateCount += computed;
+}
+
+void TransformHierarchy::compute_one(uint32_t slot, GpuInstance* instances) {
+    float x = qx[slot], y = qy[slot], z = qz[slot], w = qw[slot];
+    float local[16] = {
+        sx[slot] * (1.0f - 2.0f * (y * y + z * z)), sx[slot] * 2.0f * (x * y + w * z), sx[slot] * 2.0f * (x * z - w * y), 0.0f,
+        sy[slot] * 2.0f * (x * y - w * z), sy[slot] * (1.0f - 2.0f * (x * x + z * z)), sy[slot] * 2.0f * (y * z + w * x), 0.0f,
+        sz[slot] * 2.0f * (x * z + w * y), sz[slot] * 2.0f * (y * z - w * x), sz[slot] * (1.0f - 2.0f * (x * x + y * y)), 0.0f,
+        tx[slot], ty[slot], tz[slot], 1.0f,
+    };
+    const float* parent = parentSlot[slot] == NO_NODE ? IDENTITY : world[parentSlot[slot]].m;
+
+    float* out = world[slot].m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            out[c * 4 + r] = parent[r] * local[c * 4] + parent[4 + r] * local[c * 4 + 1] +
+                             parent[8 + r] * local[c * 4 + 2] + parent[12 + r] * local[c * 4 + 3];
+        }
+    }
+    if (instances && instance[slot] != NO_NODE) {
+        memcpy(instances[instance[slot]].model, out, sizeof(Matrix4));
+    }
+    stale[slot] = staleAfterWrite;
+}
+
+#if defined(__SSE2__)
+// One node per lane: the local matrices are built straight from the SoA arrays, the four
+// parent matrices are transposed into lane order, and the products are transposed back
+// so each column is stored to the world array and, if bound, the instance buffer.
+void TransformHierarchy::compute_four(uint32_t slot, GpuInstance* instances) {
+    __m128 x = _mm_loadu_ps(&qx[slot]), y = _mm_loadu_ps(&qy[slot]);
+    __m128 z = _mm_loadu_ps(&qz[slot]), w = _mm_loadu_ps(&qw[slot]);
+    __m128 two = _mm_set1_ps(2.0f), one = _mm_set1_ps(1.0f);
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+    __m128 scaleX = _mm_loadu_ps(&sx[slot]), scaleY = _mm_loadu_ps(&sy[slot]), scaleZ = _mm_loadu_ps(&sz[slot]);
+
+    __m128 local[4][3] = {
+        {_mm_mul_ps(scaleX, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)))),
+         _mm_mul_ps(scaleX, _mm_mul_ps(two, _mm_add_ps(xy, wz))),
+         _mm_mul_ps(scaleX, _mm_mul_ps(two, _mm_sub_ps(xz, wy)))},
+        {_mm_mul_ps(scaleY, _mm_mul_ps(two, _mm_sub_ps(xy, wz))),
+         _mm_mul_ps(scaleY, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)))),
+         _mm_mul_ps(scaleY, _mm_mul_ps(two, _mm_add_ps(yz, wx)))},
+        {_mm_mul_ps(scaleZ, _mm_mul_ps(two, _mm_add_ps(xz, wy))),
+         _mm_mul_ps(scaleZ, _mm_mul_ps(two, _mm_sub_ps(yz, wx))),
+         _mm_mul_ps(scaleZ, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))))},
+        {_mm_loadu_ps(&tx[slot]), _mm_loadu_ps(&ty[slot]), _mm_loadu_ps(&tz[slot])},
+    };
+
+    const float* parents[4];
+    for (uint32_t lane = 0; lane < 4; lane++) {
+        uint32_t parent = parentSlot[slot + lane];
+        parents[lane] = parent == NO_NODE ? IDENTITY : world[parent].m;
+    }
+    // parent[k][r]: element (row r, column k) of each lane's parent
+    __m128 parent[4][4];
+    for (int k = 0; k < 4; k++) {
+        parent[k][0] = _mm_load_ps(parents[0] + k * 4);
+        parent[k][1] = _mm_load_ps(parents[1] + k * 4);
+        parent[k][2] = _mm_load_ps(parents[2] + k * 4);
+        parent[k][3] = _mm_load_ps(parents[3] + k * 4);
+        _MM_TRANSPOSE4_PS(parent[k][0], parent[k][1], parent[k][2], parent[k][3]);
+    }
+
+    for (int c = 0; c < 4; c++) {
+        __m128 column[4];
+        for (int r = 0; r < 4; r++) {
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(parent[0][r], local[c][0]), _mm_mul_ps(parent[1][r], local[c][1])),
+                                    _mm_mul_ps(parent[2][r], local[c][2]));
+            column[r] = c == 3 ? _mm_add_ps(sum, parent[3][r]) : sum; // Local column 3 ends in 1, the others in 0
+        }
+        _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            _mm_store_ps(world[slot + lane].m + c * 4, column[lane]);
+            if (instances && instance[slot + lane] != NO_NODE) {
+                _mm_storeu_ps(instances[instance[slot + lane]].model + c * 4, column[lane]);
+            }
+        }
+    }
+    for (uint32_t lane = 0; lane < 4; lane++) {
+        stale[slot + lane] = staleAfterWrite;
+    }
+}
+#else
+void TransformHierarchy::compute_four(uint32_t slot, GpuInstance* instances) {
+    for (uint32_t lane = 0; lane < 4; lane++) {
+        compute_one(slot + lane, instances);
+    }
+}
+#endif
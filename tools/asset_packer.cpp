@@ -0,0 +1,183 @@
+#include "assets/asset_archive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Packs a directory into an asset archive (see include/assets/asset_archive.hpp):
+//   asset_packer <input directory> <output file> [--compression none|lz4|zstd] [--alignment N]
+// Blobs are compressed only where that saves at least an eighth of their size, so assets
+// that are already compressed stay usable in place.
+
+namespace {
+namespace fs = std::filesystem;
+
+struct PackedFile {
+    std::string name; // Relative to the input directory, '/' separated
+    uint64_t hash;
+    std::vector<uint8_t> stored;
+    uint64_t size;
+    AssetCompression compression;
+};
+
+AssetCompression parse_compression(const std::string& name) {
+    if (name == "none") {
+        return AssetCompression::None;
+    }
+    if (name == "lz4") {
+        return AssetCompression::Lz4;
+    }
+    if (name == "zstd") {
+        return AssetCompression::Zstd;
+    }
+    throw std::runtime_error("Unknown compression " + name + "!");
+}
+
+std::vector<uint8_t> read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path.string() + "!");
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void pack(const fs::path& input, const fs::path& output, AssetCompression compression, uint32_t alignment) {
+    std::vector<PackedFile> files;
+    uint64_t rawBytes = 0;
+    for (const fs::directory_entry& item : fs::recursive_directory_iterator(input)) {
+        if (!item.is_regular_file()) {
+            continue;
+        }
+        PackedFile file;
+        file.name = fs::relative(item.path(), input).generic_string();
+        file.hash = AssetArchive::hash_path(file.name);
+        file.stored = read_file(item.path());
+        file.size = file.stored.size();
+        file.compression = AssetCompression::None;
+        rawBytes += file.size;
+        if (compression != AssetCompression::None) {
+            std::vector<uint8_t> packed = AssetArchive::compress(compression, file.stored.data(), file.stored.size());
+            if (!packed.empty() && packed.size() <= file.size - file.size / 8) {
+                file.stored = std::move(packed);
+                file.compression = compression;
+            }
+        }
+        files.push_back(std::move(file));
+    }
+    std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.hash < b.hash; });
+    for (size_t i = 1; i < files.size(); i++) {
+        if (files[i].hash == files[i - 1].hash) {
+            throw std::runtime_error("Asset paths " + files[i - 1].name + " and " + files[i].name +
+                                     " hash to the same value; rename one!");
+        }
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, "APAK", 4);
+    header.version = AssetArchive::VERSION;
+    header.entryCount = static_cast<uint32_t>(files.size());
+    header.alignment = alignment;
+    header.indexOffset = sizeof(ArchiveHeader) + AssetArchive::FANOUT_SIZE * sizeof(uint32_t);
+    header.namesOffset = header.indexOffset + files.size() * sizeof(ArchiveEntry);
+
+    std::vector<uint32_t> fanout(AssetArchive::FANOUT_SIZE, 0);
+    std::vector<ArchiveEntry> entries(files.size());
+    std::string names;
+    for (size_t i = 0; i < files.size(); i++) {
+        fanout[files[i].hash >> 56]++;
+        entries[i] = ArchiveEntry{};
+        entries[i].hash = files[i].hash;
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        names += files[i].name;
+        names.push_back('\0');
+    }
+    names.push_back('\0'); // Never empty, even for an empty directory
+    for (uint32_t bucket = 1; bucket < AssetArchive::FANOUT_SIZE; bucket++) {
+        fanout[bucket] += fanout[bucket - 1];
+    }
+    header.namesSize = names.size();
+
+    uint64_t offset = align_up(header.namesOffset + header.namesSize, alignment);
+    for (size_t i = 0; i < files.size(); i++) {
+        entries[i].offset = offset;
+        entries[i].storedSize = files[i].stored.size();
+        entries[i].size = files[i].size;
+        entries[i].checksum = AssetArchive::checksum(files[i].stored.data(), files[i].stored.size());
+        entries[i].compression = static_cast<uint8_t>(files[i].compression);
+        offset = align_up(offset + files[i].stored.size(), alignment);
+    }
+    header.fileSize = offset;
+
+    // Written beside the output and renamed over it, so a running engine never maps a half-written file
+    fs::path temporary = output;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to create " + temporary.string() + "!");
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(fanout.data()), fanout.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+        uint64_t written = header.namesOffset + header.namesSize;
+        const std::vector<char> padding(alignment, 0);
+        for (size_t i = 0; i < files.size(); i++) {
+            out.write(padding.data(), static_cast<std::streamsize>(entries[i].offset - written));
+            out.write(reinterpret_cast<const char*>(files[i].stored.data()),
+                      static_cast<std::streamsize>(files[i].stored.size()));
+            written = entries[i].offset + files[i].stored.size();
+        }
+        out.write(padding.data(), static_cast<std::streamsize>(header.fileSize - written));
+        if (!out) {
+            throw std::runtime_error("Failed to write " + temporary.string() + "!");
+        }
+    }
+    fs::rename(temporary, output);
+
+    std::cout << "[AssetPacker] " << files.size() << " files, " << rawBytes / 1024 << " KB packed into "
+              << header.fileSize / 1024 << " KB at " << output.string() << "\n";
+}
+}
+
+int main(int argc, char** argv) {
+    // Every option takes a value, so a trailing one without it is a usage error too
+    if (argc < 3 || (argc - 3) % 2 != 0) {
+        std::cerr << "Usage: " << argv[0] << " <input directory> <output file> [--compression none|lz4|zstd]"
+                  << " [--alignment N]\n";
+        return 1;
+    }
+    try {
+        AssetCompression compression =
+            AssetArchive::supports(AssetCompression::Lz4) ? AssetCompression::Lz4 : AssetCompression::None;
+        uint32_t alignment = 64;
+        for (int i = 3; i < argc; i += 2) {
+            if (std::strcmp(argv[i], "--compression") == 0) {
+                compression = parse_compression(argv[i + 1]);
+            } else if (std::strcmp(argv[i], "--alignment") == 0) {
+                alignment = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+            } else {
+                throw std::runtime_error(std::string("Unknown option ") + argv[i] + "!");
+            }
+        }
+        if (alignment < 8 || (alignment & (alignment - 1)) != 0) {
+            throw std::runtime_error("Alignment must be a power of two of at least 8!");
+        }
+        if (!AssetArchive::supports(compression)) {
+            throw std::runtime_error("This build of asset_packer lacks the requested codec!");
+        }
+        pack(argv[1], argv[2], compression, alignment);
+    } catch (const std::exception& error) {
+        std::cerr << "[AssetPacker] " << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}